@@ -41,8 +41,11 @@ public class MultiplayerSessions : ModuleRules
 			{
 				"CoreUObject",
 				"Engine",
+				"Icmp",
+				"Networking",
 				"Slate",
 				"SlateCore",
+				"Sockets",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
@@ -2,19 +2,23 @@
 
 #include "MultiplayerSessionsSubsystem.h"
 #include "OnlineSessionSettings.h"
-#include "OnlineSubsystem.h"
 
 #include "Components/Button.h"
 #include "Kismet/KismetSystemLibrary.h"
 
 
-void UMenu::MenuSetup(int32 NumberOfPublicConnection, FString TypeOfMatch, FString LobbyPath)
+void UMenu::MenuSetup(int32 NumberOfPublicConnection, FString TypeOfMatch, FString LobbyPath, bool bUseFastHost)
 {
 	NumPublicConnections = NumberOfPublicConnection;
 	MatchType = TypeOfMatch;
+	MatchKey = FMultiplayerSessionSearchIndex::MakeMatchKey(MatchType);
 	PathToLobby = FString::Printf(TEXT("%s?listen"), *LobbyPath);
+	bFastHost = bUseFastHost;
 	
-	AddToViewport();
+	// a pooled menu comes back with whatever buttons were disabled when it was last used
+	SetButtonsEnabled(true);
+
+	if(!IsInViewport()) { AddToViewport(); }
 	SetVisibility(ESlateVisibility::Visible);
 	bIsFocusable = true;
 
@@ -43,17 +47,42 @@ void UMenu::MenuSetup(int32 NumberOfPublicConnection, FString TypeOfMatch, FStri
 		MultiplayerSessionsSubsystem = GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>();
 	}
 	
+	BindSubsystemDelegates();
+}
+
+void UMenu::BindSubsystemDelegates()
+{
+	// setting up a menu that is already shown must not bind it twice
+	UnbindSubsystemDelegates();
+
 	if(MultiplayerSessionsSubsystem)
 	{
 		// Bind callback functions to a MultiplayerSubsystem's delegates.
 		MultiplayerSessionsSubsystem->MultiplayerOnCreateSessionComplete.AddDynamic(this, &ThisClass::OnCreateSession);
-		MultiplayerSessionsSubsystem->MultiplayerOnFindSessionsComplete.AddUObject(this, &ThisClass::OnFindSessions);
+		MultiplayerSessionsSubsystem->MultiplayerOnFindSessionsPage.AddUObject(this, &ThisClass::OnFindSessions);
+		MultiplayerSessionsSubsystem->MultiplayerOnSessionsRanked.AddUObject(this, &ThisClass::OnSessionsRanked);
 		MultiplayerSessionsSubsystem->MultiplayerOnJoinSessionsComplete.AddUObject(this, &ThisClass::OnJoinSession);
 		MultiplayerSessionsSubsystem->MultiplayerOnDestroySessionsComplete.AddDynamic(this, &ThisClass::OnDestroySession);
 		MultiplayerSessionsSubsystem->MultiplayerOnStartSessionsComplete.AddDynamic(this, &ThisClass::OnStartSession);
+		MultiplayerSessionsSubsystem->MultiplayerOnHostReady.AddUObject(this, &ThisClass::OnHostReady);
+		MultiplayerSessionsSubsystem->MultiplayerOnQuickMatchComplete.AddUObject(this, &ThisClass::OnQuickMatchComplete);
 	}
 }
 
+void UMenu::UnbindSubsystemDelegates()
+{
+	if(!MultiplayerSessionsSubsystem) { return; }
+
+	MultiplayerSessionsSubsystem->MultiplayerOnCreateSessionComplete.RemoveAll(this);
+	MultiplayerSessionsSubsystem->MultiplayerOnFindSessionsPage.RemoveAll(this);
+	MultiplayerSessionsSubsystem->MultiplayerOnSessionsRanked.RemoveAll(this);
+	MultiplayerSessionsSubsystem->MultiplayerOnJoinSessionsComplete.RemoveAll(this);
+	MultiplayerSessionsSubsystem->MultiplayerOnDestroySessionsComplete.RemoveAll(this);
+	MultiplayerSessionsSubsystem->MultiplayerOnStartSessionsComplete.RemoveAll(this);
+	MultiplayerSessionsSubsystem->MultiplayerOnHostReady.RemoveAll(this);
+	MultiplayerSessionsSubsystem->MultiplayerOnQuickMatchComplete.RemoveAll(this);
+}
+
 bool UMenu::Initialize()
 {
 	if(!Super::Initialize()) { return false; }
@@ -61,6 +90,7 @@ bool UMenu::Initialize()
 	if(HostButton) { HostButton->OnClicked.AddDynamic(this, &ThisClass::HostButtonClicked); }
 	if(JoinButton) { JoinButton->OnClicked.AddDynamic(this, &ThisClass::JoinButtonClicked); }
 	if(QuitButton) { QuitButton->OnClicked.AddDynamic(this, &ThisClass::QuitButtonClicked); }
+	if(QuickMatchButton) { QuickMatchButton->OnClicked.AddDynamic(this, &ThisClass::QuickMatchButtonClicked); }
 	
 	return true;
 }
@@ -81,6 +111,9 @@ void UMenu::MenuTearDown()
 {
 	RemoveFromParent();
 
+	// a hidden menu must not act on session results, e.g. join a session somebody else searched for
+	UnbindSubsystemDelegates();
+
 	UWorld* World = GetWorld();
 
 	if(World)
@@ -117,8 +150,16 @@ void UMenu::HostButtonClicked()
 	// MultiplayerSessionsSubsystem valid check 
 	if(MultiplayerSessionsSubsystem)
 	{
-		// Call CreateSession() on SessionSubsystem 
-		MultiplayerSessionsSubsystem->CreateSession(NumPublicConnections, MatchType);
+		if (bFastHost)
+		{
+			// Create the session while the lobby map loads, we travel from OnHostReady()
+			MultiplayerSessionsSubsystem->HostSession(NumPublicConnections, MatchType, PathToLobby);
+		}
+		else
+		{
+			// Call CreateSession() on SessionSubsystem 
+			MultiplayerSessionsSubsystem->CreateSession(NumPublicConnections, MatchType);
+		}
 	}
 }
 void UMenu::JoinButtonClicked()
@@ -129,8 +170,23 @@ void UMenu::JoinButtonClicked()
 	// MultiplayerSessionsSubsystem valid check 
 	if(MultiplayerSessionsSubsystem)
 	{
-		// Call FindSessions() on SessionSubsystem 
-		MultiplayerSessionsSubsystem->FindSessions(10000);
+		// Only ask for sessions of our match type
+		FMultiplayerSessionSearchFilter Filter;
+		Filter.MatchType = MatchType;
+		
+		// Call FindSessionsIncremental() on SessionSubsystem so we can join as soon as the first matching page arrives
+		MultiplayerSessionsSubsystem->FindSessionsIncremental(10000, Filter);
+	}
+}
+void UMenu::QuickMatchButtonClicked()
+{
+	// nothing else may touch the game session while the quick match decides between joining and hosting
+	SetButtonsEnabled(false);
+
+	if(MultiplayerSessionsSubsystem)
+	{
+		// we hear back once in OnQuickMatchComplete(), the other session callbacks stay quiet until then
+		MultiplayerSessionsSubsystem->QuickMatch(NumPublicConnections, MatchType, PathToLobby);
 	}
 }
 void UMenu::QuitButtonClicked()
@@ -153,6 +209,9 @@ void UMenu::OnCreateSession(bool bWasSuccessful)
 	{	
 		if (GEngine) { GEngine->AddOnScreenDebugMessage(-1,15.f,FColor::Green,FString::Printf(TEXT("Session was successfully created!"))); }
 
+		// fast host travels once the lobby has loaded as well, see OnHostReady()
+		if(bFastHost) { return; }
+
 		UWorld* World = GetWorld();
 
 		if(World)
@@ -166,66 +225,92 @@ void UMenu::OnCreateSession(bool bWasSuccessful)
 		HostButton->SetIsEnabled(true);
 	}
 }
-void UMenu::OnFindSessions(const TArray<FOnlineSessionSearchResult>& SessionResults, bool bWasSuccessful)
+void UMenu::OnFindSessions(TArrayView<const FOnlineSessionSearchResult> SessionResults, bool bIsLastPage)
 {
 	// check if MultiplayerSessionsSubsystem is valid 
 	if(!MultiplayerSessionsSubsystem) { return; }
 
-	// 
-	for (FOnlineSessionSearchResult Result : SessionResults)
+	// results are indexed by match type as they arrive. As soon as there's a matching one rank everything
+	// found so far and join the best in OnSessionsRanked(). The subsystem will cancel the rest of the search
+	if (MultiplayerSessionsSubsystem->FindSearchResult(MatchKey))
 	{
-		FString SettingsValue;
-		Result.Session.SessionSettings.Get(FName("MatchType"), SettingsValue);
-
-		if (SettingsValue == MatchType)
-		{
-			MultiplayerSessionsSubsystem->JoinSession(Result);
-			return;
-		}
+		MultiplayerSessionsSubsystem->RankSessions(MatchKey);
+		return;
 	}
 
-	// if we don't find the session
-	// or for some reason, session was found but sessions array is empty
-	if(!bWasSuccessful || !SessionResults.Num())
+	// if the search is over and we didn't find the session
+	if(bIsLastPage)
 	{
 		// enable join button back so we can try to find session again
 		JoinButton->SetIsEnabled(true);
 	}
 }
 
+void UMenu::OnSessionsRanked(TArrayView<const FMultiplayerSessionCandidate> RankedCandidates)
+{
+	if(!MultiplayerSessionsSubsystem) { return; }
+
+	// best candidate comes first, if it turns us down the subsystem fails over to the next one without searching again
+	if (!MultiplayerSessionsSubsystem->JoinRankedSessions())
+	{
+		// every candidate was rejected (e.g. full), let the player search again
+		JoinButton->SetIsEnabled(true);
+	}
+}
 
 void UMenu::OnJoinSession(EOnJoinSessionCompleteResult::Type Result)
 {
-	IOnlineSubsystem* Subsystem = IOnlineSubsystem::Get();
-	if(Subsystem)
+	// the subsystem resolved the address and started loading the host's map while the join was in progress
+	if (Result == EOnJoinSessionCompleteResult::Success && MultiplayerSessionsSubsystem && MultiplayerSessionsSubsystem->ClientTravelToSession())
 	{
-		IOnlineSessionPtr SessionInterface = Subsystem->GetSessionInterface();
-
-		if (SessionInterface.IsValid())
-		{
-			FString Address;
-
-			SessionInterface->GetResolvedConnectString(NAME_GameSession, Address);
+		return;
+	}
 
-			// Reference to a local player controller
-			APlayerController* PlayerController = GetGameInstance()->GetFirstLocalPlayerController();
+	JoinButton->SetIsEnabled(true);
+}
+void UMenu::OnDestroySession(bool bWasSuccessful)
+{
+}
+void UMenu::OnStartSession(bool bWasSuccessful)
+{
+}
+void UMenu::OnHostReady(bool bWasSuccessful)
+{
+	// failure has already been reported and the Host button re-enabled by OnCreateSession()
+	if(!bWasSuccessful) { return; }
 
-			if (PlayerController)
-			{
-				PlayerController->ClientTravel(Address, TRAVEL_Absolute);
-			}
-		}
-	}
+	UWorld* World = GetWorld();
 
-	if (Result != EOnJoinSessionCompleteResult::Success)
+	if(World)
 	{
-		JoinButton->SetIsEnabled(true);
+		World->ServerTravel(PathToLobby);
 	}
-	
 }
-void UMenu::OnDestroySession(bool bWasSuccessful)
+void UMenu::OnQuickMatchComplete(EMultiplayerQuickMatchResult Result)
 {
+	switch (Result)
+	{
+	case EMultiplayerQuickMatchResult::Joined:
+		if(MultiplayerSessionsSubsystem && MultiplayerSessionsSubsystem->ClientTravelToSession()) { return; }
+		break;
+	case EMultiplayerQuickMatchResult::Hosted:
+		// the lobby map has been loaded while the session was created
+		if(UWorld* World = GetWorld())
+		{
+			World->ServerTravel(PathToLobby);
+			return;
+		}
+		break;
+	default:
+		break;
+	}
+
+	if (GEngine) { GEngine->AddOnScreenDebugMessage(-1,15.f,FColor::Red,FString::Printf(TEXT("Quick match failed!"))); }
+	SetButtonsEnabled(true);
 }
-void UMenu::OnStartSession(bool bWasSuccessful)
+void UMenu::SetButtonsEnabled(bool bEnabled)
 {
+	HostButton->SetIsEnabled(bEnabled);
+	JoinButton->SetIsEnabled(bEnabled);
+	if(QuickMatchButton) { QuickMatchButton->SetIsEnabled(bEnabled); }
 }
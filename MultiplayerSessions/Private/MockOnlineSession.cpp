@@ -0,0 +1,825 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MockOnlineSession.h"
+
+#include "OnlineSubsystem.h"
+#include "OnlineSubsystemTypes.h"
+#include "SessionAllocationCounter.h"
+#include "SessionAttributes.h"
+#include "SessionSearchIndex.h"
+
+namespace
+{
+	const FName MockNetIdType(TEXT("MOCK"));
+
+	class FMockOnlineSessionInfo : public FOnlineSessionInfo
+	{
+	public:
+
+		FMockOnlineSessionInfo(FUniqueNetIdRef InSessionId, int32 InPort) : SessionId(MoveTemp(InSessionId)), Port(InPort) {}
+
+		virtual const uint8* GetBytes() const override { return nullptr; }
+		virtual int32 GetSize() const override { return sizeof(FMockOnlineSessionInfo); }
+		virtual bool IsValid() const override { return true; }
+		virtual FString ToString() const override { return SessionId->ToString(); }
+		virtual FString ToDebugString() const override { return FString::Printf(TEXT("%s port %d"), *SessionId->ToString(), Port); }
+		virtual const FUniqueNetId& GetSessionId() const override { return *SessionId; }
+
+		FString GetConnectString(bool bPingable) const
+		{
+			return bPingable ? FString::Printf(TEXT("127.0.0.1:%d"), Port) : FString::Printf(TEXT("mock.%s"), *SessionId->ToString());
+		}
+
+	private:
+
+		FUniqueNetIdRef SessionId;
+		int32 Port{0};
+	};
+
+	EOnJoinSessionCompleteResult::Type ToJoinResult(EMultiplayerSessionOpOutcome Outcome)
+	{
+		switch (Outcome)
+		{
+		case EMultiplayerSessionOpOutcome::Success: return EOnJoinSessionCompleteResult::Success;
+		case EMultiplayerSessionOpOutcome::SessionIsFull: return EOnJoinSessionCompleteResult::SessionIsFull;
+		case EMultiplayerSessionOpOutcome::SessionDoesNotExist: return EOnJoinSessionCompleteResult::SessionDoesNotExist;
+		case EMultiplayerSessionOpOutcome::CouldNotRetrieveAddress: return EOnJoinSessionCompleteResult::CouldNotRetrieveAddress;
+		case EMultiplayerSessionOpOutcome::AlreadyInSession: return EOnJoinSessionCompleteResult::AlreadyInSession;
+		default: return EOnJoinSessionCompleteResult::UnknownError;
+		}
+	}
+
+	bool GetConnectString(const FOnlineSession& Session, bool bPingable, FString& ConnectInfo)
+	{
+		if(!Session.SessionInfo.IsValid()) { return false; }
+
+		ConnectInfo = StaticCastSharedPtr<FMockOnlineSessionInfo>(Session.SessionInfo)->GetConnectString(bPingable);
+		return true;
+	}
+}
+
+FMockOnlineSession::FMockOnlineSession(const FMockOnlineSessionConfig& InConfig) :
+	Config(InConfig),
+	Random(InConfig.RandomSeed),
+	LocalUserId(FUniqueNetIdString::Create(InConfig.LocalUserName, MockNetIdType)),
+	Service(MakeShared<FService>())
+{
+	AdvertiseSessions(Config.NumAdvertisedSessions);
+
+	if (!Config.bManualTick)
+	{
+		TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FMockOnlineSession::CoreTick));
+	}
+}
+
+FMockOnlineSession::FMockOnlineSession(const FMockOnlineSessionConfig& InConfig, const FMockOnlineSession& InService) :
+	Config(InConfig),
+	Random(InConfig.RandomSeed),
+	LocalUserId(FUniqueNetIdString::Create(InConfig.LocalUserName, MockNetIdType)),
+	Service(InService.Service)
+{
+	if (!Config.bManualTick)
+	{
+		TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FMockOnlineSession::CoreTick));
+	}
+}
+
+FMockOnlineSession::~FMockOnlineSession()
+{
+	if (TickHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+	}
+}
+
+void FMockOnlineSession::Tick(float DeltaTime)
+{
+	Now += DeltaTime;
+
+	AdvanceSearch();
+
+	// completions may issue new calls, those wait for a later tick even if they are due right away
+	TArray<FPendingCall> DueCalls;
+	{
+		// the simulated service's own bookkeeping isn't the cost of its client
+		MultiplayerSessionAllocations::FScopedIgnore IgnoreAllocations;
+
+		for (int32 Index = 0; Index < PendingCalls.Num(); )
+		{
+			if (PendingCalls[Index].DueTime <= Now)
+			{
+				DueCalls.Add(MoveTemp(PendingCalls[Index]));
+				PendingCalls.RemoveAt(Index, 1, EAllowShrinking::No);
+			}
+			else
+			{
+				++Index;
+			}
+		}
+	}
+
+	for (FPendingCall& Call : DueCalls)
+	{
+		Call.Complete();
+	}
+}
+
+bool FMockOnlineSession::CoreTick(float DeltaTime)
+{
+	Tick(DeltaTime);
+	return true;
+}
+
+void FMockOnlineSession::AdvertiseSessions(int32 NumSessions)
+{
+	TArray<FHost>& Hosts = Service->Hosts;
+	Hosts.RemoveAll([](const FHost& Host) { return Host.LocalSessionName.IsNone(); });
+	Hosts.Reserve(Hosts.Num() + NumSessions);
+
+	const uint32 AdvertisedMatchKey = FMultiplayerSessionSearchIndex::MakeMatchKey(Config.AdvertisedMatchType);
+
+	for (int32 Index = 0; Index < NumSessions; ++Index)
+	{
+		FHost& Host = Hosts.AddDefaulted_GetRef();
+		Host.PingInMs = Random.RandRange(Config.MinPingInMs, Config.MaxPingInMs);
+
+		FOnlineSessionSettings& Settings = Host.Session.SessionSettings;
+		Settings.NumPublicConnections = Config.MaxSlotsPerSession;
+		Settings.bShouldAdvertise = true;
+		Settings.bUsesPresence = true;
+		Settings.bAllowJoinInProgress = true;
+		Settings.bIsDedicated = Random.FRand() < 0.5f;
+		Settings.BuildUniqueId = 1;
+		MultiplayerSessionAttributes::SetInt(Settings, EMultiplayerSessionAttribute::MatchKey, AdvertisedMatchKey);
+		MultiplayerSessionAttributes::SetInt(Settings, EMultiplayerSessionAttribute::SchemaVersion, MultiplayerSessionAttributes::CurrentSchemaVersion);
+
+		Host.Session.OwningUserId = FUniqueNetIdString::Create(FString::Printf(TEXT("MockHost%d"), Index), MockNetIdType);
+		Host.Session.OwningUserName = FString::Printf(TEXT("MockHost%d"), Index);
+		Host.Session.NumOpenPublicConnections = Random.RandRange(0, Config.MaxSlotsPerSession);
+		Host.Session.SessionInfo = MakeSessionInfo();
+	}
+}
+
+void FMockOnlineSession::Schedule(TFunction<void()>&& Complete)
+{
+	if (Config.bCompleteInline)
+	{
+		Complete();
+		return;
+	}
+
+	MultiplayerSessionAllocations::FScopedIgnore IgnoreAllocations;
+
+	FPendingCall& Call = PendingCalls.AddDefaulted_GetRef();
+	Call.DueTime = Now + RollLatency();
+	Call.Complete = MoveTemp(Complete);
+}
+
+double FMockOnlineSession::RollLatency()
+{
+	return Config.MinLatency + (Config.MaxLatency - Config.MinLatency) * Random.FRand();
+}
+
+bool FMockOnlineSession::RollFailure()
+{
+	return Config.FailureRate > 0.f && Random.FRand() < Config.FailureRate;
+}
+
+void FMockOnlineSession::Schedule(EMultiplayerSessionMetricOp Op, TFunction<void(const FScriptedCall*)>&& Complete)
+{
+	FScriptedCall Script;
+	if (!PopScriptedCall(Op, Script))
+	{
+		Schedule([Complete = MoveTemp(Complete)]() { Complete(nullptr); });
+		return;
+	}
+
+	if (Config.bCompleteInline)
+	{
+		Complete(&Script);
+		return;
+	}
+
+	MultiplayerSessionAllocations::FScopedIgnore IgnoreAllocations;
+
+	FPendingCall& Call = PendingCalls.AddDefaulted_GetRef();
+	Call.DueTime = Now + Script.Latency;
+	Call.Complete = [Script, Complete = MoveTemp(Complete)]() { Complete(&Script); };
+}
+
+bool FMockOnlineSession::Fails(const FScriptedCall* Script)
+{
+	return Script ? Script->Outcome != EMultiplayerSessionOpOutcome::Success : RollFailure();
+}
+
+void FMockOnlineSession::AddScriptedCall(EMultiplayerSessionMetricOp Op, double Latency, EMultiplayerSessionOpOutcome Outcome, int32 NumResults)
+{
+	if(Op >= EMultiplayerSessionMetricOp::Num) { return; }
+
+	FScriptedCall& Script = ScriptedCalls[static_cast<int32>(Op)].AddDefaulted_GetRef();
+	Script.Latency = FMath::Max(Latency, 0.0);
+	Script.Outcome = Outcome;
+	Script.NumResults = NumResults;
+}
+
+void FMockOnlineSession::ClearScriptedCalls()
+{
+	for (int32 Op = 0; Op < static_cast<int32>(EMultiplayerSessionMetricOp::Num); ++Op)
+	{
+		ScriptedCalls[Op].Reset();
+		NumScriptedCallsUsed[Op] = 0;
+	}
+}
+
+int32 FMockOnlineSession::GetNumScriptedCalls() const
+{
+	int32 NumScripted = 0;
+	for (int32 Op = 0; Op < static_cast<int32>(EMultiplayerSessionMetricOp::Num); ++Op)
+	{
+		NumScripted += ScriptedCalls[Op].Num() - NumScriptedCallsUsed[Op];
+	}
+	return NumScripted;
+}
+
+bool FMockOnlineSession::PopScriptedCall(EMultiplayerSessionMetricOp Op, FScriptedCall& OutScript)
+{
+	const int32 OpIndex = static_cast<int32>(Op);
+	if(NumScriptedCallsUsed[OpIndex] >= ScriptedCalls[OpIndex].Num()) { return false; }
+
+	OutScript = ScriptedCalls[OpIndex][NumScriptedCallsUsed[OpIndex]++];
+	return true;
+}
+
+TSharedRef<FOnlineSessionInfo> FMockOnlineSession::MakeSessionInfo()
+{
+	const int32 SessionId = Service->NextSessionId++;
+	return MakeShared<FMockOnlineSessionInfo>(FUniqueNetIdString::Create(FString::Printf(TEXT("MockSession%d"), SessionId), MockNetIdType), 7777 + SessionId % 10000);
+}
+
+FMockOnlineSession::FHost* FMockOnlineSession::FindHost(const FString& SessionId)
+{
+	return Service->Hosts.FindByPredicate([&SessionId](const FHost& Host) { return Host.Session.GetSessionIdStr() == SessionId; });
+}
+
+void FMockOnlineSession::AdvertiseLocalSession(const FNamedOnlineSession& Session)
+{
+	if(!Session.SessionSettings.bShouldAdvertise) { return; }
+
+	FHost& Host = Service->Hosts.AddDefaulted_GetRef();
+	Host.Session = Session;
+	Host.LocalSessionName = Session.SessionName;
+}
+
+bool FMockOnlineSession::MatchesQuery(const FHost& Host, const FOnlineSessionSearch& Search) const
+{
+	const FOnlineSessionSettings& Settings = Host.Session.SessionSettings;
+
+	if(!MultiplayerSessionAttributes::MatchesQuery(Search.QuerySettings, Settings, EMultiplayerSessionAttribute::MatchKey)) { return false; }
+	if(!MultiplayerSessionAttributes::MatchesQuery(Search.QuerySettings, Settings, EMultiplayerSessionAttribute::RegionKey)) { return false; }
+	if(!MultiplayerSessionAttributes::MatchesQuery(Search.QuerySettings, Settings, EMultiplayerSessionAttribute::Lineage)) { return false; }
+
+	int32 MinOpenSlots = 0;
+	if (Search.QuerySettings.Get(SEARCH_MINSLOTSAVAILABLE, MinOpenSlots) && Host.Session.NumOpenPublicConnections < MinOpenSlots)
+	{
+		return false;
+	}
+
+	bool bDedicatedOnly = false;
+	if (Search.QuerySettings.Get(SEARCH_DEDICATED_ONLY, bDedicatedOnly) && bDedicatedOnly && !Settings.bIsDedicated)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+void FMockOnlineSession::AdvanceSearch()
+{
+	if(!CurrentSearch.IsValid()) { return; }
+
+	if (Now >= CurrentSearchDueTime)
+	{
+		FinishSearch();
+		return;
+	}
+
+	if(!Config.bStreamSearchResults || bCurrentSearchFails) { return; }
+
+	MultiplayerSessionAllocations::FScopedIgnore IgnoreAllocations;
+
+	// results arrive evenly spread over the search's latency
+	const double Progress = (Now - CurrentSearchStartTime) / FMath::Max(CurrentSearchDueTime - CurrentSearchStartTime, 0.001);
+	const int32 NumDue = FMath::Min(FMath::FloorToInt(Progress * CurrentSearchResults.Num()), CurrentSearchResults.Num());
+
+	for (; NumCurrentSearchResultsDelivered < NumDue; ++NumCurrentSearchResultsDelivered)
+	{
+		CurrentSearch->SearchResults.Add(MoveTemp(CurrentSearchResults[NumCurrentSearchResultsDelivered]));
+	}
+}
+
+void FMockOnlineSession::FinishSearch()
+{
+	const TSharedPtr<FOnlineSessionSearch> Search = MoveTemp(CurrentSearch);
+	CurrentSearch.Reset();
+
+	if (!bCurrentSearchFails)
+	{
+		MultiplayerSessionAllocations::FScopedIgnore IgnoreAllocations;
+
+		for (; NumCurrentSearchResultsDelivered < CurrentSearchResults.Num(); ++NumCurrentSearchResultsDelivered)
+		{
+			Search->SearchResults.Add(MoveTemp(CurrentSearchResults[NumCurrentSearchResultsDelivered]));
+		}
+	}
+	CurrentSearchResults.Reset();
+
+	Search->SearchState = bCurrentSearchFails ? EOnlineAsyncTaskState::Failed : EOnlineAsyncTaskState::Done;
+	TriggerOnFindSessionsCompleteDelegates(!bCurrentSearchFails);
+}
+
+/* IOnlineSession
+ * ====================================================================================================================
+ */
+FUniqueNetIdPtr FMockOnlineSession::CreateSessionIdFromString(const FString& SessionIdStr)
+{
+	return FUniqueNetIdString::Create(SessionIdStr, MockNetIdType);
+}
+
+FNamedOnlineSession* FMockOnlineSession::GetNamedSession(FName SessionName)
+{
+	return Sessions.FindByPredicate([SessionName](const FNamedOnlineSession& Session) { return Session.SessionName == SessionName; });
+}
+
+void FMockOnlineSession::RemoveNamedSession(FName SessionName)
+{
+	Sessions.RemoveAll([SessionName](const FNamedOnlineSession& Session) { return Session.SessionName == SessionName; });
+}
+
+bool FMockOnlineSession::HasPresenceSession()
+{
+	return Sessions.ContainsByPredicate([](const FNamedOnlineSession& Session) { return Session.SessionSettings.bUsesPresence; });
+}
+
+EOnlineSessionState::Type FMockOnlineSession::GetSessionState(FName SessionName) const
+{
+	const FNamedOnlineSession* Session = Sessions.FindByPredicate([SessionName](const FNamedOnlineSession& Named) { return Named.SessionName == SessionName; });
+	return Session ? Session->SessionState : EOnlineSessionState::NoSession;
+}
+
+FNamedOnlineSession* FMockOnlineSession::AddNamedSession(FName SessionName, const FOnlineSessionSettings& SessionSettings)
+{
+	return &Sessions.Emplace_GetRef(SessionName, SessionSettings);
+}
+
+FNamedOnlineSession* FMockOnlineSession::AddNamedSession(FName SessionName, const FOnlineSession& Session)
+{
+	return &Sessions.Emplace_GetRef(SessionName, Session);
+}
+
+bool FMockOnlineSession::CreateSession(int32 HostingPlayerNum, FName SessionName, const FOnlineSessionSettings& NewSessionSettings)
+{
+	return CreateSession(*LocalUserId, SessionName, NewSessionSettings);
+}
+
+bool FMockOnlineSession::CreateSession(const FUniqueNetId& HostingPlayerId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings)
+{
+	if(GetNamedSession(SessionName)) { return false; }
+
+	{
+		MultiplayerSessionAllocations::FScopedIgnore IgnoreAllocations;
+
+		FNamedOnlineSession* Session = AddNamedSession(SessionName, NewSessionSettings);
+		Session->SessionState = EOnlineSessionState::Creating;
+		Session->OwningUserId = HostingPlayerId.AsShared();
+		Session->NumOpenPublicConnections = NewSessionSettings.NumPublicConnections;
+		Session->SessionInfo = MakeSessionInfo();
+		Session->bHosting = true;
+	}
+
+	Schedule(EMultiplayerSessionMetricOp::Create, [this, SessionName](const FScriptedCall* Script)
+	{
+		FNamedOnlineSession* Created = GetNamedSession(SessionName);
+		const bool bWasSuccessful = Created && !Fails(Script);
+
+		if (bWasSuccessful)
+		{
+			MultiplayerSessionAllocations::FScopedIgnore IgnoreAllocations;
+
+			Created->SessionState = EOnlineSessionState::Pending;
+			AdvertiseLocalSession(*Created);
+		}
+		else
+		{
+			RemoveNamedSession(SessionName);
+		}
+
+		TriggerOnCreateSessionCompleteDelegates(SessionName, bWasSuccessful);
+	});
+
+	return true;
+}
+
+bool FMockOnlineSession::StartSession(FName SessionName)
+{
+	FNamedOnlineSession* Session = GetNamedSession(SessionName);
+	if(!Session || (Session->SessionState != EOnlineSessionState::Pending && Session->SessionState != EOnlineSessionState::Ended)) { return false; }
+
+	Session->SessionState = EOnlineSessionState::Starting;
+
+	Schedule(EMultiplayerSessionMetricOp::Start, [this, SessionName](const FScriptedCall* Script)
+	{
+		FNamedOnlineSession* Started = GetNamedSession(SessionName);
+		const bool bWasSuccessful = Started && !Fails(Script);
+
+		if (Started)
+		{
+			Started->SessionState = bWasSuccessful ? EOnlineSessionState::InProgress : EOnlineSessionState::Pending;
+		}
+
+		TriggerOnStartSessionCompleteDelegates(SessionName, bWasSuccessful);
+	});
+
+	return true;
+}
+
+bool FMockOnlineSession::UpdateSession(FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings, bool bShouldRefreshOnlineData)
+{
+	FNamedOnlineSession* Session = GetNamedSession(SessionName);
+	if(!Session) { return false; }
+
+	Session->SessionSettings = UpdatedSessionSettings;
+
+	Schedule(EMultiplayerSessionMetricOp::Update, [this, SessionName](const FScriptedCall* Script)
+	{
+		FNamedOnlineSession* Updated = GetNamedSession(SessionName);
+		const bool bWasSuccessful = Updated && !Fails(Script);
+
+		// what searches see changes once the online service has taken the update
+		if (bWasSuccessful)
+		{
+			if (FHost* Host = FindHost(Updated->GetSessionIdStr()))
+			{
+				Host->Session.SessionSettings = Updated->SessionSettings;
+				Host->Session.NumOpenPublicConnections = Updated->NumOpenPublicConnections;
+			}
+		}
+
+		TriggerOnUpdateSessionCompleteDelegates(SessionName, bWasSuccessful);
+	});
+
+	return true;
+}
+
+bool FMockOnlineSession::EndSession(FName SessionName)
+{
+	FNamedOnlineSession* Session = GetNamedSession(SessionName);
+	if(!Session || Session->SessionState != EOnlineSessionState::InProgress) { return false; }
+
+	Session->SessionState = EOnlineSessionState::Ending;
+
+	Schedule([this, SessionName]()
+	{
+		FNamedOnlineSession* Ended = GetNamedSession(SessionName);
+		if (Ended)
+		{
+			Ended->SessionState = EOnlineSessionState::Ended;
+		}
+
+		TriggerOnEndSessionCompleteDelegates(SessionName, Ended != nullptr);
+	});
+
+	return true;
+}
+
+bool FMockOnlineSession::DestroySession(FName SessionName, const FOnDestroySessionCompleteDelegate& CompletionDelegate)
+{
+	FNamedOnlineSession* Session = GetNamedSession(SessionName);
+	if(!Session || Session->SessionState == EOnlineSessionState::Destroying) { return false; }
+
+	Session->SessionState = EOnlineSessionState::Destroying;
+
+	Schedule(EMultiplayerSessionMetricOp::Destroy, [this, SessionName, CompletionDelegate](const FScriptedCall* Script)
+	{
+		FNamedOnlineSession* Destroyed = GetNamedSession(SessionName);
+		const bool bWasSuccessful = Destroyed && !Fails(Script);
+
+		if (bWasSuccessful)
+		{
+			const FString SessionId = Destroyed->GetSessionIdStr();
+
+			if (Destroyed->bHosting)
+			{
+				Service->Hosts.RemoveAll([&SessionId](const FHost& Host) { return Host.Session.GetSessionIdStr() == SessionId; });
+			}
+			else if (FHost* Host = FindHost(SessionId))
+			{
+				// leaving frees the slot we took when joining
+				Host->Session.NumOpenPublicConnections = FMath::Min(Host->Session.NumOpenPublicConnections + 1, Host->Session.SessionSettings.NumPublicConnections);
+			}
+
+			RemoveNamedSession(SessionName);
+		}
+		else if (Destroyed)
+		{
+			Destroyed->SessionState = EOnlineSessionState::Pending;
+		}
+
+		CompletionDelegate.ExecuteIfBound(SessionName, bWasSuccessful);
+		TriggerOnDestroySessionCompleteDelegates(SessionName, bWasSuccessful);
+	});
+
+	return true;
+}
+
+bool FMockOnlineSession::IsPlayerInSession(FName SessionName, const FUniqueNetId& UniqueId)
+{
+	const FNamedOnlineSession* Session = GetNamedSession(SessionName);
+	return Session && Session->RegisteredPlayers.ContainsByPredicate([&UniqueId](const FUniqueNetIdRef& Player) { return *Player == UniqueId; });
+}
+
+bool FMockOnlineSession::StartMatchmaking(const TArray<FUniqueNetIdRef>& LocalPlayers, FName SessionName, const FOnlineSessionSettings& NewSessionSettings, TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+	return false;
+}
+
+bool FMockOnlineSession::CancelMatchmaking(int32 SearchingPlayerNum, FName SessionName)
+{
+	return false;
+}
+
+bool FMockOnlineSession::CancelMatchmaking(const FUniqueNetId& SearchingPlayerId, FName SessionName)
+{
+	return false;
+}
+
+bool FMockOnlineSession::FindSessions(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+	return FindSessions(*LocalUserId, SearchSettings);
+}
+
+bool FMockOnlineSession::FindSessions(const FUniqueNetId& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+	if(CurrentSearch.IsValid()) { return false; }
+
+	CurrentSearch = SearchSettings;
+	CurrentSearch->SearchState = EOnlineAsyncTaskState::InProgress;
+	CurrentSearch->SearchResults.Reset();
+
+	FScriptedCall Script;
+	const bool bScripted = PopScriptedCall(EMultiplayerSessionMetricOp::Find, Script);
+	const int32 MaxResults = bScripted && Script.NumResults != INDEX_NONE ? FMath::Min(Script.NumResults, SearchSettings->MaxSearchResults) : SearchSettings->MaxSearchResults;
+
+	// what the service answers is decided now, hosts coming and going during the search don't change it
+	{
+		MultiplayerSessionAllocations::FScopedIgnore IgnoreAllocations;
+
+		CurrentSearchResults.Reset();
+		for (const FHost& Host : Service->Hosts)
+		{
+			if(CurrentSearchResults.Num() >= MaxResults) { break; }
+			if(!MatchesQuery(Host, *SearchSettings)) { continue; }
+
+			FOnlineSessionSearchResult& Result = CurrentSearchResults.AddDefaulted_GetRef();
+			Result.Session = Host.Session;
+			Result.PingInMs = Host.PingInMs;
+		}
+	}
+
+	NumCurrentSearchResultsDelivered = 0;
+	bCurrentSearchFails = Fails(bScripted ? &Script : nullptr);
+	CurrentSearchStartTime = Now;
+	CurrentSearchDueTime = Config.bCompleteInline ? Now : Now + (bScripted ? Script.Latency : RollLatency());
+
+	if (Config.bCompleteInline)
+	{
+		FinishSearch();
+	}
+
+	return true;
+}
+
+bool FMockOnlineSession::FindSessionById(const FUniqueNetId& SearchingUserId, const FUniqueNetId& SessionId, const FUniqueNetId& FriendId, const FOnSingleSessionResultCompleteDelegate& CompletionDelegate)
+{
+	const FString SessionIdStr = SessionId.ToString();
+
+	Schedule([this, SessionIdStr, CompletionDelegate]()
+	{
+		FOnlineSessionSearchResult Result;
+
+		const FHost* Host = FindHost(SessionIdStr);
+		if (Host)
+		{
+			Result.Session = Host->Session;
+			Result.PingInMs = Host->PingInMs;
+		}
+
+		CompletionDelegate.ExecuteIfBound(0, Host != nullptr, Result);
+	});
+
+	return true;
+}
+
+bool FMockOnlineSession::CancelFindSessions()
+{
+	if(!CurrentSearch.IsValid()) { return false; }
+
+	CurrentSearch->SearchState = EOnlineAsyncTaskState::Failed;
+	CurrentSearch.Reset();
+	CurrentSearchResults.Reset();
+
+	TriggerOnCancelFindSessionsCompleteDelegates(true);
+	return true;
+}
+
+bool FMockOnlineSession::PingSearchResults(const FOnlineSessionSearchResult& SearchResult)
+{
+	return false;
+}
+
+bool FMockOnlineSession::JoinSession(int32 LocalUserNum, FName SessionName, const FOnlineSessionSearchResult& DesiredSession)
+{
+	return JoinSession(*LocalUserId, SessionName, DesiredSession);
+}
+
+bool FMockOnlineSession::JoinSession(const FUniqueNetId& InLocalUserId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession)
+{
+	if (GetNamedSession(SessionName))
+	{
+		Schedule([this, SessionName]() { TriggerOnJoinSessionCompleteDelegates(SessionName, EOnJoinSessionCompleteResult::AlreadyInSession); });
+		return true;
+	}
+
+	{
+		MultiplayerSessionAllocations::FScopedIgnore IgnoreAllocations;
+
+		FNamedOnlineSession* Session = AddNamedSession(SessionName, DesiredSession.Session);
+		Session->SessionState = EOnlineSessionState::Pending;
+		Session->LocalOwnerId = InLocalUserId.AsShared();
+		Session->bHosting = false;
+	}
+
+	Schedule(EMultiplayerSessionMetricOp::Join, [this, SessionName, SessionId = DesiredSession.Session.GetSessionIdStr()](const FScriptedCall* Script)
+	{
+		EOnJoinSessionCompleteResult::Type Result = EOnJoinSessionCompleteResult::Success;
+
+		FHost* Host = FindHost(SessionId);
+		if (!Host) { Result = EOnJoinSessionCompleteResult::SessionDoesNotExist; }
+		else if (Script) { Result = ToJoinResult(Script->Outcome); }
+		else if (Host->Session.NumOpenPublicConnections <= 0) { Result = EOnJoinSessionCompleteResult::SessionIsFull; }
+		else if (RollFailure()) { Result = EOnJoinSessionCompleteResult::UnknownError; }
+
+		if (Result == EOnJoinSessionCompleteResult::Success)
+		{
+			Host->Session.NumOpenPublicConnections = FMath::Max(Host->Session.NumOpenPublicConnections - 1, 0);
+		}
+		else
+		{
+			RemoveNamedSession(SessionName);
+		}
+
+		TriggerOnJoinSessionCompleteDelegates(SessionName, Result);
+	});
+
+	return true;
+}
+
+bool FMockOnlineSession::FindFriendSession(int32 LocalUserNum, const FUniqueNetId& Friend)
+{
+	return false;
+}
+
+bool FMockOnlineSession::FindFriendSession(const FUniqueNetId& InLocalUserId, const FUniqueNetId& Friend)
+{
+	return false;
+}
+
+bool FMockOnlineSession::FindFriendSession(const FUniqueNetId& InLocalUserId, const TArray<FUniqueNetIdRef>& FriendList)
+{
+	return false;
+}
+
+bool FMockOnlineSession::SendSessionInviteToFriend(int32 LocalUserNum, FName SessionName, const FUniqueNetId& Friend)
+{
+	return false;
+}
+
+bool FMockOnlineSession::SendSessionInviteToFriend(const FUniqueNetId& InLocalUserId, FName SessionName, const FUniqueNetId& Friend)
+{
+	return false;
+}
+
+bool FMockOnlineSession::SendSessionInviteToFriends(int32 LocalUserNum, FName SessionName, const TArray<FUniqueNetIdRef>& Friends)
+{
+	return false;
+}
+
+bool FMockOnlineSession::SendSessionInviteToFriends(const FUniqueNetId& InLocalUserId, FName SessionName, const TArray<FUniqueNetIdRef>& Friends)
+{
+	return false;
+}
+
+bool FMockOnlineSession::GetResolvedConnectString(FName SessionName, FString& ConnectInfo, FName PortType)
+{
+	MultiplayerSessionAllocations::FScopedIgnore IgnoreAllocations;
+
+	const FNamedOnlineSession* Session = GetNamedSession(SessionName);
+	return Session && GetConnectString(*Session, Config.bPingableHosts, ConnectInfo);
+}
+
+bool FMockOnlineSession::GetResolvedConnectString(const FOnlineSessionSearchResult& SearchResult, FName PortType, FString& ConnectInfo)
+{
+	MultiplayerSessionAllocations::FScopedIgnore IgnoreAllocations;
+
+	return GetConnectString(SearchResult.Session, Config.bPingableHosts, ConnectInfo);
+}
+
+FOnlineSessionSettings* FMockOnlineSession::GetSessionSettings(FName SessionName)
+{
+	FNamedOnlineSession* Session = GetNamedSession(SessionName);
+	return Session ? &Session->SessionSettings : nullptr;
+}
+
+bool FMockOnlineSession::RegisterPlayer(FName SessionName, const FUniqueNetId& PlayerId, bool bWasInvited)
+{
+	return RegisterPlayers(SessionName, { PlayerId.AsShared() }, bWasInvited);
+}
+
+bool FMockOnlineSession::RegisterPlayers(FName SessionName, const TArray<FUniqueNetIdRef>& Players, bool bWasInvited)
+{
+	FNamedOnlineSession* Session = GetNamedSession(SessionName);
+	if (Session)
+	{
+		for (const FUniqueNetIdRef& Player : Players)
+		{
+			if (!Session->RegisteredPlayers.ContainsByPredicate([&Player](const FUniqueNetIdRef& Registered) { return *Registered == *Player; }))
+			{
+				Session->RegisteredPlayers.Add(Player);
+
+				// like the NULL subsystem, players registered with a session we host take up its slots
+				if (Session->bHosting)
+				{
+					Session->NumOpenPublicConnections = FMath::Max(Session->NumOpenPublicConnections - 1, 0);
+				}
+			}
+		}
+	}
+
+	Schedule([this, SessionName, Players, bWasSuccessful = Session != nullptr]() { TriggerOnRegisterPlayersCompleteDelegates(SessionName, Players, bWasSuccessful); });
+	return true;
+}
+
+bool FMockOnlineSession::UnregisterPlayer(FName SessionName, const FUniqueNetId& PlayerId)
+{
+	return UnregisterPlayers(SessionName, { PlayerId.AsShared() });
+}
+
+bool FMockOnlineSession::UnregisterPlayers(FName SessionName, const TArray<FUniqueNetIdRef>& Players)
+{
+	FNamedOnlineSession* Session = GetNamedSession(SessionName);
+	if (Session)
+	{
+		const int32 NumRemoved = Session->RegisteredPlayers.RemoveAll([&Players](const FUniqueNetIdRef& Registered)
+		{
+			return Players.ContainsByPredicate([&Registered](const FUniqueNetIdRef& Player) { return *Player == *Registered; });
+		});
+
+		if (Session->bHosting)
+		{
+			Session->NumOpenPublicConnections = FMath::Min(Session->NumOpenPublicConnections + NumRemoved, Session->SessionSettings.NumPublicConnections);
+		}
+	}
+
+	Schedule([this, SessionName, Players, bWasSuccessful = Session != nullptr]() { TriggerOnUnregisterPlayersCompleteDelegates(SessionName, Players, bWasSuccessful); });
+	return true;
+}
+
+void FMockOnlineSession::RegisterLocalPlayer(const FUniqueNetId& PlayerId, FName SessionName, const FOnRegisterLocalPlayerCompleteDelegate& Delegate)
+{
+	Delegate.ExecuteIfBound(PlayerId, EOnJoinSessionCompleteResult::Success);
+}
+
+void FMockOnlineSession::UnregisterLocalPlayer(const FUniqueNetId& PlayerId, FName SessionName, const FOnUnregisterLocalPlayerCompleteDelegate& Delegate)
+{
+	Delegate.ExecuteIfBound(PlayerId, true);
+}
+
+void FMockOnlineSession::RemovePlayerFromSession(int32 LocalUserNum, FName SessionName, const FUniqueNetId& TargetPlayerId)
+{
+	UnregisterPlayer(SessionName, TargetPlayerId);
+}
+
+int32 FMockOnlineSession::GetNumSessions()
+{
+	return Sessions.Num();
+}
+
+void FMockOnlineSession::DumpSessionState()
+{
+	for (const FNamedOnlineSession& Session : Sessions)
+	{
+		UE_LOG(LogOnline, Log, TEXT("%s: %s, %d open slots"), *Session.SessionName.ToString(), EOnlineSessionState::ToString(Session.SessionState), Session.NumOpenPublicConnections);
+	}
+
+	UE_LOG(LogOnline, Log, TEXT("%d advertised sessions, %d calls pending"), Service->Hosts.Num(), GetNumPendingCalls());
+}
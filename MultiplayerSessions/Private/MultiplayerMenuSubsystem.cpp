@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MultiplayerMenuSubsystem.h"
+
+#include "Blueprint/UserWidget.h"
+#include "Engine/AssetManager.h"
+#include "Engine/GameInstance.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/World.h"
+#include "Menu.h"
+
+void UMultiplayerMenuSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PreLoadMapHandle = FCoreUObjectDelegates::PreLoadMap.AddUObject(this, &ThisClass::OnPreLoadMap);
+	PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &ThisClass::OnPostLoadMapWithWorld);
+
+	// travel URL options (e.g. "?listen") aren't part of the package name
+	if (!MenuMapPath.Split(TEXT("?"), &MenuMapPackageName, nullptr))
+	{
+		MenuMapPackageName = MenuMapPath;
+	}
+
+	if (!MenuClass.IsNull())
+	{
+		MenuClassHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(MenuClass.ToSoftObjectPath(),
+			FStreamableDelegate::CreateUObject(this, &ThisClass::OnMenuClassLoaded));
+	}
+}
+
+void UMultiplayerMenuSubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::PreLoadMap.Remove(PreLoadMapHandle);
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+
+	if (MenuClassHandle.IsValid())
+	{
+		MenuClassHandle->CancelHandle();
+		MenuClassHandle.Reset();
+	}
+
+	HideMenu();
+	Menu = nullptr;
+	MenuMapPackage = nullptr;
+
+	Super::Deinitialize();
+}
+
+UMenu* UMultiplayerMenuSubsystem::ShowMenu(int32 NumberOfPublicConnection, FString TypeOfMatch, FString LobbyPath, bool bUseFastHost, TSubclassOf<UMenu> InMenuClass)
+{
+	// nobody waits for the async load once the menu is actually needed
+	if (!InMenuClass && !LoadedMenuClass && !MenuClass.IsNull())
+	{
+		LoadedMenuClass = MenuClass.LoadSynchronous();
+	}
+
+	UMenu* PooledMenu = GetOrCreateMenu(InMenuClass ? InMenuClass : LoadedMenuClass);
+	if(!PooledMenu) { return nullptr; }
+
+	PooledMenu->MenuSetup(NumberOfPublicConnection, MoveTemp(TypeOfMatch), MoveTemp(LobbyPath), bUseFastHost);
+	return PooledMenu;
+}
+
+void UMultiplayerMenuSubsystem::HideMenu()
+{
+	// the menu tears itself down (input mode, subsystem delegates) once its Slate widget is released
+	if (Menu && Menu->IsInViewport())
+	{
+		Menu->RemoveFromParent();
+	}
+}
+
+UMenu* UMultiplayerMenuSubsystem::GetOrCreateMenu(TSubclassOf<UMenu> WidgetClass)
+{
+	if(!WidgetClass) { return Menu; }
+	if(Menu && Menu->GetClass() == WidgetClass) { return Menu; }
+
+	HideMenu();
+
+	// owned by the game instance rather than a player controller, so it outlives the world it's shown in
+	Menu = CreateWidget<UMenu>(GetGameInstance(), WidgetClass);
+	return Menu;
+}
+
+void UMultiplayerMenuSubsystem::OnMenuClassLoaded()
+{
+	MenuClassHandle.Reset();
+	LoadedMenuClass = MenuClass.Get();
+
+	// build the widget tree now rather than when the player is waiting for it
+	GetOrCreateMenu(LoadedMenuClass);
+}
+
+void UMultiplayerMenuSubsystem::OnPreLoadMap(const FString& MapName)
+{
+	// a Slate widget left in the viewport would keep the old world's player alive across the travel
+	HideMenu();
+}
+
+void UMultiplayerMenuSubsystem::OnPostLoadMapWithWorld(UWorld* LoadedWorld)
+{
+	if(MenuMapPackageName.IsEmpty()) { return; }
+
+	const bool bOnMenuMap = LoadedWorld && LoadedWorld->GetOutermost()->GetName() == MenuMapPackageName;
+	if (bOnMenuMap)
+	{
+		// the world keeps its own package alive, holding it past the next travel would leak the world
+		MenuMapPackage = nullptr;
+		return;
+	}
+
+	PreloadMenuMap();
+}
+
+void UMultiplayerMenuSubsystem::PreloadMenuMap()
+{
+	if(MenuMapPackage || bMenuMapLoading) { return; }
+
+	bMenuMapLoading = true;
+	LoadPackageAsync(MenuMapPackageName, FLoadPackageAsyncDelegate::CreateUObject(this, &ThisClass::OnMenuMapLoaded));
+}
+
+void UMultiplayerMenuSubsystem::OnMenuMapLoaded(const FName& PackageName, UPackage* LoadedPackage, EAsyncLoadingResult::Type Result)
+{
+	bMenuMapLoading = false;
+
+	// if the load failed travel back to the menu simply loads it itself
+	MenuMapPackage = Result == EAsyncLoadingResult::Succeeded ? LoadedPackage : nullptr;
+}
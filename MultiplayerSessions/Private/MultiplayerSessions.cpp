@@ -4,9 +4,18 @@
 
 #define LOCTEXT_NAMESPACE "FMultiplayerSessionsModule"
 
+DEFINE_LOG_CATEGORY(LogMultiplayerSessions);
+
+double FMultiplayerSessionsModule::StartupTime = 0.0;
+
 void FMultiplayerSessionsModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+	TRACE_CPUPROFILER_EVENT_SCOPE(FMultiplayerSessionsModule::StartupModule);
+
+	// nothing goes online here, the sessions subsystem binds the online subsystem once it's needed
+	StartupTime = FPlatformTime::Seconds();
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Started up %.1f ms after launch"), (StartupTime - GStartTime) * 1000.0);
 }
 
 void FMultiplayerSessionsModule::ShutdownModule()
@@ -15,6 +24,11 @@ void FMultiplayerSessionsModule::ShutdownModule()
 	// we call this function before unloading the module.
 }
 
+double FMultiplayerSessionsModule::GetStartupTime()
+{
+	return StartupTime;
+}
+
 #undef LOCTEXT_NAMESPACE
 	
 IMPLEMENT_MODULE(FMultiplayerSessionsModule, MultiplayerSessions)
\ No newline at end of file
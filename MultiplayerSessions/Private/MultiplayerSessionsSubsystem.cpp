@@ -2,218 +2,2837 @@
 
 
 #include "MultiplayerSessionsSubsystem.h"
+#include "Async/Async.h"
 
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Icmp.h"
 #include "OnlineSessionSettings.h"
+#include "Engine/NetDriver.h"
 #include "OnlineSubsystem.h"
+#include "Misc/App.h"
+#include "Misc/Paths.h"
+#include "MultiplayerSessions.h"
+#include "SessionAttributes.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace
+{
+	EMultiplayerSessionMetricOp ToMetricOp(EMultiplayerSessionOpType Type)
+	{
+		switch (Type)
+		{
+		case EMultiplayerSessionOpType::Create: return EMultiplayerSessionMetricOp::Create;
+		case EMultiplayerSessionOpType::Join: return EMultiplayerSessionMetricOp::Join;
+		case EMultiplayerSessionOpType::Start: return EMultiplayerSessionMetricOp::Start;
+		default: return EMultiplayerSessionMetricOp::Destroy;
+		}
+	}
+
+	EMultiplayerSessionOpOutcome ToOutcome(bool bWasSuccessful, EOnJoinSessionCompleteResult::Type JoinResult)
+	{
+		if(bWasSuccessful) { return EMultiplayerSessionOpOutcome::Success; }
+
+		switch (JoinResult)
+		{
+		case EOnJoinSessionCompleteResult::SessionIsFull: return EMultiplayerSessionOpOutcome::SessionIsFull;
+		case EOnJoinSessionCompleteResult::SessionDoesNotExist: return EMultiplayerSessionOpOutcome::SessionDoesNotExist;
+		case EOnJoinSessionCompleteResult::CouldNotRetrieveAddress: return EMultiplayerSessionOpOutcome::CouldNotRetrieveAddress;
+		case EOnJoinSessionCompleteResult::AlreadyInSession: return EMultiplayerSessionOpOutcome::AlreadyInSession;
+		default: return EMultiplayerSessionOpOutcome::Failure;
+		}
+	}
+
+	// Delete the oldest journals in Directory until there's room for one more of MaxFiles
+	void DeleteOldJournals(const FString& Directory, int32 MaxFiles)
+	{
+		if(MaxFiles <= 0) { return; }
+
+		TArray<FString> FileNames;
+		IFileManager::Get().FindFiles(FileNames, *(Directory / TEXT("MultiplayerSessions-*.msjournal")), true, false);
+
+		const int32 NumToDelete = FileNames.Num() - (MaxFiles - 1);
+		if(NumToDelete <= 0) { return; }
+
+		TArray<TPair<FDateTime, FString>> Files;
+		for (const FString& FileName : FileNames)
+		{
+			const FString FilePath = Directory / FileName;
+			Files.Emplace(IFileManager::Get().GetTimeStamp(*FilePath), FilePath);
+		}
+		Files.Sort([](const TPair<FDateTime, FString>& A, const TPair<FDateTime, FString>& B) { return A.Key < B.Key; });
+
+		// another process may still be writing one of them, it simply stays then
+		for (int32 Index = 0; Index < NumToDelete; ++Index)
+		{
+			IFileManager::Get().Delete(*Files[Index].Value, false, false, true);
+		}
+	}
+
+	double MillisecondsSince(double Time)
+	{
+		return Time > 0.0 ? (FPlatformTime::Seconds() - Time) * 1000.0 : 0.0;
+	}
+
+	FString ToMapPackageName(const FString& MapPath)
+	{
+		// travel URL options (e.g. "?listen") aren't part of the package name
+		FString PackageName;
+		return MapPath.Split(TEXT("?"), &PackageName, nullptr) ? PackageName : MapPath;
+	}
+
+	FAutoConsoleCommandWithWorldArgsAndOutputDevice DumpMetricsCommand(
+		TEXT("MultiplayerSessions.DumpMetrics"),
+		TEXT("Print latency percentiles and outcome counters of every session operation"),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+		{
+			const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+			const UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+
+			if (Subsystem)
+			{
+				Subsystem->GetSessionMetrics().Dump(Ar);
+			}
+		}));
+}
 
 UMultiplayerSessionsSubsystem::UMultiplayerSessionsSubsystem() :
 	CreateSessionCompleteDelegate(FOnCreateSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnCreateSessionComplete)),
 	FindSessionsCompleteDelegate(FOnFindSessionsCompleteDelegate::CreateUObject(this, &ThisClass::OnFindSessionsComplete)),
+	SearchCacheRefreshCompleteDelegate(FOnFindSessionsCompleteDelegate::CreateUObject(this, &ThisClass::OnSearchCacheRefreshComplete)),
 	JoinSessionCompleteDelegate(FOnJoinSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnJoinSessionComplete)),
 	DestroySessionCompleteDelegate(FOnDestroySessionCompleteDelegate::CreateUObject(this, &ThisClass::OnDestroySessionComplete)),
-	StartSessionCompleteDelegate(FOnDestroySessionCompleteDelegate::CreateUObject(this, &ThisClass::OnDestroySessionComplete))
+	StartSessionCompleteDelegate(FOnStartSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnStartSessionComplete)),
+	UpdateSessionCompleteDelegate(FOnUpdateSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnUpdateSessionComplete))
 	
 {
-	IOnlineSubsystem* Subsystem = IOnlineSubsystem::Get();
-	if(Subsystem)
+	// the online subsystem is bound by EnsureSessionInterface(), not here
+}
+
+void UMultiplayerSessionsSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (bEnableSessionJournal)
+	{
+		// several processes, and game instances of one process (PIE), start within the same second
+		static int32 NumJournalsStarted = 0;
+		const FString JournalPath = FPaths::ProjectLogDir() / FString::Printf(TEXT("MultiplayerSessions-%s-%u-%d.msjournal"),
+			*FDateTime::Now().ToString(), FPlatformProcess::GetCurrentProcessId(), NumJournalsStarted++);
+
+		DeleteOldJournals(FPaths::ProjectLogDir(), MaxSessionJournalFiles);
+		Journal.Start(JournalPath, SessionJournalCapacity, SessionJournalFlushInterval);
+	}
+
+	SearchCache.Configure(SearchCacheSize, SearchCacheTimeToLive);
+
+	// processes without anybody to look at a menu go online on first use, if ever
+	if (bWarmUpOnline && FApp::CanEverRender())
+	{
+		OnlineWarmUpHandle = FTSTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateUObject(this, &ThisClass::TickOnlineWarmUp), FMath::Max(OnlineWarmUpDelay, 0.f));
+	}
+
+	// the current search, a background refresh and every cached one may be in use at the same time
+	ObjectPool = FMultiplayerSessionObjectPool(FMath::Max(SearchCacheSize, 0) + 2);
+
+	if (SearchCacheRefreshInterval > 0.f)
+	{
+		SearchCacheTickHandle = FTSTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateUObject(this, &ThisClass::TickSearchCache), SearchCacheRefreshInterval);
+	}
+
+	if (HostHeartbeatInterval > 0.f)
 	{
-		SessionInterface = Subsystem->GetSessionInterface();
+		HostHeartbeatHandle = FTSTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateUObject(this, &ThisClass::TickHostHeartbeat), HostHeartbeatInterval);
+	}
+
+	if (GEngine)
+	{
+		NetworkFailureHandle = GEngine->OnNetworkFailure().AddUObject(this, &ThisClass::OnNetworkFailure);
 	}
 }
 
-void UMultiplayerSessionsSubsystem::CreateSession(int32 NumPublicConnections, FString MatchType)
+void UMultiplayerSessionsSubsystem::Deinitialize()
 {
-	// check if valid
-	if(!SessionInterface.IsValid()) { return; }
+	StopSearchPolling();
+	CancelSearchCacheRefresh();
+	ReleasePreloadedMap();
+	ClearQuickMatchDeadline();
+	StopJoinFailover();
+	StopLANBeacon();
+	CancelHostMigration();
+
+	if(GEngine && NetworkFailureHandle.IsValid())
+	{
+		GEngine->OnNetworkFailure().Remove(NetworkFailureHandle);
+		NetworkFailureHandle.Reset();
+	}
+
+	// whoever is still waiting to be registered gets a last batch before the interface goes away
+	if(PlayerRegistrationHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(PlayerRegistrationHandle);
+		FlushPlayerRegistrations(0.f);
+	}
 
-	// set reference to current session
-	FNamedOnlineSession* ExistingSession = SessionInterface->GetNamedSession(NAME_GameSession);
+	if(SearchCacheTickHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(SearchCacheTickHandle);
+		SearchCacheTickHandle.Reset();
+	}
+
+	if(SessionUpdateHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(SessionUpdateHandle);
+		SessionUpdateHandle.Reset();
+	}
 
-	// if there's current session, destroy it
-	if(ExistingSession)
+	if(HostHeartbeatHandle.IsValid())
 	{
-		bCreateSessionOnDestroy = true;
-		LastNumPublicConnections = NumPublicConnections;
-		LastMatchType = MatchType;
+		FTSTicker::GetCoreTicker().RemoveTicker(HostHeartbeatHandle);
+		HostHeartbeatHandle.Reset();
+	}
 
-		DestroySession();
+	if(OnlineWarmUpHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(OnlineWarmUpHandle);
+		OnlineWarmUpHandle.Reset();
 	}
+
+	UnbindSessionInterface();
+	Journal.Stop();
 	
-	// Add @var CreateSessionCompleteDelegate to the delegate list and store it in @var CreateSessionCompleteDelegateHandle
-	// so we can delete it from the list later
+	Super::Deinitialize();
+}
+void UMultiplayerSessionsSubsystem::OverrideSessionInterface(IOnlineSessionPtr InSessionInterface, FUniqueNetIdPtr InLocalUserId)
+{
+	CancelQuickMatch();
+	StopJoinFailover();
+	StopSearchPolling();
+	CancelFindSessions();
+	CancelSearchCacheRefresh();
+	StopLANBeacon();
+	UnbindSessionInterface();
+
+	// nothing we know about the old interface's sessions or searches applies to the new one
+	Sessions.Reset();
+	RejectedHosts.Reset();
+	PendingPlayerRegistrations.Reset();
+	SearchCache.Invalidate();
+	SearchIndex.Reset(FMultiplayerSessionSearchFilter());
+	LastSessionSearch.Reset();
+	NumSearchResultsIndexed = 0;
+	HostPipeline = FHostPipeline();
+	ResetRanking();
+
+	LocalUserIdOverride = InLocalUserId;
+	SessionInterface = InSessionInterface;
+	bLANSubsystem = false;
+
+	// going back to the online subsystem binds it again on first use
+	bSessionInterfaceBound = SessionInterface.IsValid();
+	BindSessionInterface();
+}
+bool UMultiplayerSessionsSubsystem::EnsureSessionInterface()
+{
+	if(bSessionInterfaceBound) { return SessionInterface.IsValid(); }
+
+	TRACE_CPUPROFILER_EVENT_SCOPE(UMultiplayerSessionsSubsystem::EnsureSessionInterface);
+
+	// a failed attempt isn't repeated, the online subsystem won't turn up later in the same process
+	bSessionInterfaceBound = true;
+
+	if(OnlineWarmUpHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(OnlineWarmUpHandle);
+		OnlineWarmUpHandle.Reset();
+	}
+
+	// loads the online subsystem module and initializes the platform service (e.g. Steam) the first time round
+	const double StartTime = FPlatformTime::Seconds();
+	const IOnlineSubsystem* Subsystem = IOnlineSubsystem::Get();
+	SessionInterface = Subsystem ? Subsystem->GetSessionInterface() : nullptr;
+	bLANSubsystem = Subsystem && Subsystem->GetSubsystemName() == "NULL";
+	const double EndTime = FPlatformTime::Seconds();
+
+	UE_LOG(LogMultiplayerSessions, Log, TEXT("Bound online subsystem %s in %.1f ms, %.1f ms after module startup"),
+		Subsystem ? *Subsystem->GetSubsystemName().ToString() : TEXT("(none)"), (EndTime - StartTime) * 1000.0,
+		(EndTime - FMultiplayerSessionsModule::GetStartupTime()) * 1000.0);
+
+	BindSessionInterface();
+
+	// the beacon stands in for the NULL subsystem's LAN queries
+	StartLANBeacon();
+
+	return SessionInterface.IsValid();
+}
+void UMultiplayerSessionsSubsystem::WarmUpOnline()
+{
+	EnsureSessionInterface();
+}
+bool UMultiplayerSessionsSubsystem::TickOnlineWarmUp(float DeltaTime)
+{
+	OnlineWarmUpHandle.Reset();
+	EnsureSessionInterface();
+
+	return false;
+}
+void UMultiplayerSessionsSubsystem::BindSessionInterface()
+{
+	// Session operations are routed to their slot by session name, so these stay bound for as long as the interface is used
+	if(!SessionInterface.IsValid()) { return; }
+
 	CreateSessionCompleteDelegateHandle = SessionInterface->AddOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegate);
+	JoinSessionCompleteDelegateHandle = SessionInterface->AddOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegate);
+	DestroySessionCompleteDelegateHandle = SessionInterface->AddOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegate);
+	StartSessionCompleteDelegateHandle = SessionInterface->AddOnStartSessionCompleteDelegate_Handle(StartSessionCompleteDelegate);
+	UpdateSessionCompleteDelegateHandle = SessionInterface->AddOnUpdateSessionCompleteDelegate_Handle(UpdateSessionCompleteDelegate);
+}
+void UMultiplayerSessionsSubsystem::UnbindSessionInterface()
+{
+	if(!SessionInterface.IsValid()) { return; }
+
+	SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
+	SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegateHandle);
+	SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegateHandle);
+	SessionInterface->ClearOnStartSessionCompleteDelegate_Handle(StartSessionCompleteDelegateHandle);
+	SessionInterface->ClearOnUpdateSessionCompleteDelegate_Handle(UpdateSessionCompleteDelegateHandle);
+	SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+}
+
+void UMultiplayerSessionsSubsystem::CreateSession(int32 NumPublicConnections, FString MatchType)
+{
+	CreateSession(NAME_GameSession, NumPublicConnections, MatchType);
+}
+void UMultiplayerSessionsSubsystem::CreateSession(FName SessionName, int32 NumPublicConnections, FString MatchType, const FString& MapName, bool bDedicated)
+{
+	CreateSessionWithKey(SessionName, NumPublicConnections, FMultiplayerSessionSearchIndex::MakeMatchKey(MatchType), MapName, bDedicated, 0);
+}
+void UMultiplayerSessionsSubsystem::CreateSessionWithKey(FName SessionName, int32 NumPublicConnections, uint32 MatchKey, const FString& MapName, bool bDedicated, uint32 Lineage)
+{
+	// a failover waiting to join the next candidate would destroy the session we are about to create
+	if(SessionName == JoinFailover.SessionName) { StopJoinFailover(); }
+
+	// check if valid
+	if(!EnsureSessionInterface())
+	{
+		Metrics.RecordOutcome(EMultiplayerSessionMetricOp::Create, EMultiplayerSessionOpOutcome::Failure);
+		BroadcastSessionOpResult(SessionName, EMultiplayerSessionOpType::Create, false);
+		return;
+	}
+
+	// re-creating a session we host would cost two round trips and take it out of searches in between
+	if (UpdateHostedSessionInPlace(SessionName, NumPublicConnections, MatchKey, MapName, bDedicated, Lineage))
+	{
+		Metrics.RecordOutcome(EMultiplayerSessionMetricOp::Create, EMultiplayerSessionOpOutcome::Success);
+		BroadcastSessionOpResult(SessionName, EMultiplayerSessionOpType::Create, true);
+		return;
+	}
 
 	// Set session settings
-	LastSessionSettings = MakeShareable(new FOnlineSessionSettings());
-	LastSessionSettings->bIsLANMatch = IOnlineSubsystem::Get()->GetSubsystemName() == "NULL" ? true : false;
-	LastSessionSettings->NumPublicConnections = NumPublicConnections;
-	LastSessionSettings->bAllowJoinInProgress = true;
-	LastSessionSettings->bAllowJoinViaPresence = true;
-	LastSessionSettings->bShouldAdvertise = true;
-	LastSessionSettings->bUsesPresence = true;
-	LastSessionSettings->bUseLobbiesIfAvailable = true;
-	LastSessionSettings->Set(FName("MatchType"), MatchType, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
-	LastSessionSettings->BuildUniqueId = 1;
-
-	const ULocalPlayer* LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController();
-	
-	// if session wasn't created by any reason...
-	if (!SessionInterface->CreateSession(*LocalPlayer->GetPreferredUniqueNetId(), NAME_GameSession, *LastSessionSettings))
-	{	
-		// clear OnCreateSessionCompleteDelegate from DelegateHandleList
-		SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
+	TSharedPtr<FOnlineSessionSettings> SessionSettings = ObjectPool.AcquireSettings();
+	SessionSettings->bIsLANMatch = bLANSubsystem;
+	SessionSettings->NumPublicConnections = NumPublicConnections;
+	SessionSettings->bAllowJoinInProgress = bAllowJoinInProgress;
+	SessionSettings->bShouldAdvertise = true;
+	SessionSettings->bIsDedicated = bDedicated;
 
-		// Broadcast our own custom delegate
-		MultiplayerOnCreateSessionComplete.Broadcast(false);
+	// presence and lobbies belong to a player, a dedicated server is advertised as a game server instead
+	SessionSettings->bAllowJoinViaPresence = !bDedicated;
+	SessionSettings->bUsesPresence = !bDedicated;
+	SessionSettings->bUseLobbiesIfAvailable = !bDedicated;
+
+	// advertised attributes, see SessionAttributes.h
+	using namespace MultiplayerSessionAttributes;
+	SetInt(*SessionSettings, EMultiplayerSessionAttribute::SchemaVersion, CurrentSchemaVersion);
+	SetInt(*SessionSettings, EMultiplayerSessionAttribute::MatchKey, MatchKey);
+	SetInt(*SessionSettings, EMultiplayerSessionAttribute::Lineage, Lineage != 0 ? Lineage : FMath::Max(GetTypeHash(FGuid::NewGuid()), 1u));
+	SetInt(*SessionSettings, EMultiplayerSessionAttribute::QuickMatch, QuickMatchState.Stage == EQuickMatchStage::Hosting ? 1 : 0);
+	SetInt(*SessionSettings, EMultiplayerSessionAttribute::MatchPhase, static_cast<uint32>(EMultiplayerSessionMatchPhase::Lobby));
+	SetInt(*SessionSettings, EMultiplayerSessionAttribute::Heartbeat, static_cast<uint32>(FDateTime::UtcNow().ToUnixTimestamp()));
+	if (!Region.IsEmpty())
+	{
+		SetInt(*SessionSettings, EMultiplayerSessionAttribute::RegionKey, HashString(Region));
 	}
+	if (!MapName.IsEmpty())
+	{
+		SetString(*SessionSettings, EMultiplayerSessionAttribute::MapName, MapName);
+	}
+	SessionSettings->BuildUniqueId = 1;
+
+	// if there's a current session it is destroyed first, the create waits in the queue until that has finished
+	FMultiplayerSessionOp Op;
+	Op.Type = EMultiplayerSessionOpType::Create;
+	Op.Settings = SessionSettings;
 	
+	EnqueueSessionOp(SessionName, MoveTemp(Op));
+}
+bool UMultiplayerSessionsSubsystem::UpdateHostedSessionInPlace(FName SessionName, int32 NumPublicConnections, uint32 MatchKey, const FString& MapName, bool bDedicated, uint32 Lineage)
+{
+	// a started session can't be taken back to the lobby, and anything queued or in flight is about to change it anyway
+	FMultiplayerSessionSlot* Slot = Sessions.Find(SessionName);
+	if(!Slot || !Slot->Settings.IsValid() || Slot->bLANBeaconSession || !Slot->IsIdle()) { return false; }
+	if(Slot->State != EMultiplayerSessionState::Pending || !SessionInterface->GetNamedSession(SessionName)) { return false; }
+
+	// how the session is hosted and advertised is fixed once it exists
+	FOnlineSessionSettings& Settings = *Slot->Settings;
+	if(Settings.bIsLANMatch != bLANSubsystem || Settings.bIsDedicated != bDedicated) { return false; }
+
+	// another lineage makes it somebody else's session, members looking for it wouldn't find it anymore
+	using namespace MultiplayerSessionAttributes;
+	uint32 CurrentLineage = 0;
+	GetInt(Settings, EMultiplayerSessionAttribute::Lineage, CurrentLineage);
+	if(Lineage != 0 && Lineage != CurrentLineage) { return false; }
+
+	bool bChanged = false;
+	if (Settings.NumPublicConnections != NumPublicConnections || Settings.bAllowJoinInProgress != bAllowJoinInProgress)
+	{
+		Settings.NumPublicConnections = NumPublicConnections;
+		Settings.bAllowJoinInProgress = bAllowJoinInProgress;
+		bChanged = true;
+	}
+	bChanged |= SetInt(Settings, EMultiplayerSessionAttribute::MatchKey, MatchKey);
+	bChanged |= SetInt(Settings, EMultiplayerSessionAttribute::QuickMatch, QuickMatchState.Stage == EQuickMatchStage::Hosting ? 1 : 0);
+	bChanged |= SetInt(Settings, EMultiplayerSessionAttribute::MatchPhase, static_cast<uint32>(EMultiplayerSessionMatchPhase::Lobby));
+
+	// a create leaves out what it isn't given, so does the update
+	if (!Region.IsEmpty())
+	{
+		bChanged |= SetInt(Settings, EMultiplayerSessionAttribute::RegionKey, HashString(Region));
+	}
+	else
+	{
+		bChanged |= Settings.Settings.Remove(GetKey(EMultiplayerSessionAttribute::RegionKey)) > 0;
+	}
+	if (!MapName.IsEmpty())
+	{
+		bChanged |= SetString(Settings, EMultiplayerSessionAttribute::MapName, MapName);
+	}
+	else
+	{
+		bChanged |= Settings.Settings.Remove(GetKey(EMultiplayerSessionAttribute::MapName)) > 0;
+	}
+
+	if (bChanged)
+	{
+		MarkSessionSettingsDirty(SessionName);
+	}
+
+	// the room left may have changed
+	RefreshHostedSession(SessionName, false);
+	return true;
 }
-void UMultiplayerSessionsSubsystem::FindSessions(int32 MaxSearchResults)
+void UMultiplayerSessionsSubsystem::FindSessions(int32 MaxSearchResults, const FMultiplayerSessionSearchFilter& Filter)
 {
 	// check if SessionInterface is valid 
-	if(!SessionInterface.IsValid()) { return; }
+	if(!EnsureSessionInterface()) { return; }
 
-	FindSessionsCompleteDelegateHandle = SessionInterface->AddOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegate);
+	// a running incremental search would otherwise swallow this search's completion
+	CancelFindSessions();
+
+	Journal.Record(EMultiplayerSessionJournalEvent::Requested, EMultiplayerSessionMetricOp::Find, NAME_None);
+
+	// LAN hosts announce themselves, what we've heard is all a broadcast query would find
+	if(ServeSearchFromLANBeacon(MaxSearchResults, Filter))
+	{
+		const TSharedPtr<FOnlineSessionSearch> Search = LastSessionSearch;
+		MultiplayerOnFindSessionsComplete.Broadcast(Search->SearchResults, Search->SearchResults.Num() > 0);
+		return;
+	}
+
+	// same query was answered recently, no need to go online again
+	if(ServeSearchFromCache(MaxSearchResults, Filter))
+	{
+		Metrics.RecordSearchCacheHit();
+		Journal.Record(EMultiplayerSessionJournalEvent::Completed, EMultiplayerSessionMetricOp::Find, NAME_None, EMultiplayerSessionOpOutcome::Success, LastSessionSearch->SearchResults.Num());
 
-	LastSessionSearch = MakeShareable(new FOnlineSessionSearch());
+		// listeners get a view into the results, keep them alive even if a listener starts another search
+		const TSharedPtr<FOnlineSessionSearch> Search = LastSessionSearch;
+		MultiplayerOnFindSessionsComplete.Broadcast(Search->SearchResults, true);
+		return;
+	}
+
+	// the interface runs one search at a time and ours is more important than a background refresh
+	CancelSearchCacheRefresh();
+
+	FindSessionsCompleteDelegateHandle = SessionInterface->AddOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegate);
 
-	LastSessionSearch->MaxSearchResults = MaxSearchResults;
-	LastSessionSearch->bIsLanQuery = IOnlineSubsystem::Get()->GetSubsystemName() == "NULL" ? true : false;
-	LastSessionSearch->QuerySettings.Set(SEARCH_PRESENCE, true, EOnlineComparisonOp::Equals);
+	LastSessionSearch = MakeSessionSearch(MaxSearchResults, Filter);
+	LastSearchFilter = Filter;
+	LastMaxSearchResults = MaxSearchResults;
+	ResetRanking();
+	
+	// results that still come back are checked once while indexing
+	SearchIndex.Reset(Filter, GetOldestLiveHeartbeat());
+	NumSearchResultsIndexed = 0;
 	
 	// Create reference to local player 
-	const ULocalPlayer* LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController();
+	const FUniqueNetIdPtr LocalUserId = GetLocalUserId();
+	SearchStartTime = FPlatformTime::Seconds();
+	Journal.Record(EMultiplayerSessionJournalEvent::Sent, EMultiplayerSessionMetricOp::Find, NAME_None);
 
 	// if session wasn't found...
-	if(!SessionInterface->FindSessions(*LocalPlayer->GetPreferredUniqueNetId(), LastSessionSearch.ToSharedRef()))
+	if(!LocalUserId.IsValid() || !SessionInterface->FindSessions(*LocalUserId, LastSessionSearch.ToSharedRef()))
 	{
+		Metrics.RecordOutcome(EMultiplayerSessionMetricOp::Find, EMultiplayerSessionOpOutcome::Failure);
+		Journal.Record(EMultiplayerSessionJournalEvent::Completed, EMultiplayerSessionMetricOp::Find, NAME_None, EMultiplayerSessionOpOutcome::Failure);
+
 		// remove OnFindSessionsDelegateHandle from OnlineInterface delegate list...
 		SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
 		
 		// broadcast MultiplayerOnFindSessionsCompleteDelegate to execute callbacks in Menu class.
 		// Pass an empty array because we haven't found any session and return false
-		MultiplayerOnFindSessionsComplete.Broadcast(TArray<FOnlineSessionSearchResult>(), false);
+		MultiplayerOnFindSessionsComplete.Broadcast(TArrayView<const FOnlineSessionSearchResult>(), false);
 	}
 }
-void UMultiplayerSessionsSubsystem::JoinSession(const FOnlineSessionSearchResult& SessionResult)
+void UMultiplayerSessionsSubsystem::FindSessionsIncremental(int32 MaxSearchResults, const FMultiplayerSessionSearchFilter& Filter)
 {
 	// check if SessionInterface is valid 
-	if (!SessionInterface.IsValid())
+	if(!EnsureSessionInterface())
 	{
-		MultiplayerOnJoinSessionsComplete.Broadcast(EOnJoinSessionCompleteResult::UnknownError);
+		BroadcastSearchPage(TArrayView<const FOnlineSessionSearchResult>(), true);
 		return;
 	}
 
-	// Add JoinSessionCompleteDelegate to OnlineInterface delegate list  
-	JoinSessionCompleteDelegateHandle = SessionInterface->AddOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegate);
+	// only one search can run at a time, drop whatever is still outstanding
+	CancelFindSessions();
 
-	// get reference to a local player
-	ULocalPlayer* LocalPlayer = GetWorld()->GetFirstLocalPlayerFromController();
+	// don't let a single search keep more results in flight than we are willing to hold
+	MaxSearchResults = FMath::Clamp(MaxSearchResults, 1, FMath::Max(MaxSearchResultsInFlight, 1));
 
-	// if we can't join session for some reason...
-	if(!SessionInterface->JoinSession(*LocalPlayer->GetPreferredUniqueNetId(), NAME_GameSession, SessionResult))
-	{
-		// remove JoinSessionCompleteDelegate from OnlineInterface delegate list
-		SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegateHandle);
+	NumSearchResultsDelivered = 0;
+	bIncrementalSearch = true;
 
-		// pass in to Menu class that join to session is failed and pass result status
-		MultiplayerOnJoinSessionsComplete.Broadcast(EOnJoinSessionCompleteResult::UnknownError);
+	Journal.Record(EMultiplayerSessionJournalEvent::Requested, EMultiplayerSessionMetricOp::Find, NAME_None);
+
+	if(ServeSearchFromLANBeacon(MaxSearchResults, Filter))
+	{
+		DeliverSearchPages(true);
+		return;
 	}
-	
-}
-void UMultiplayerSessionsSubsystem::DestroySession()
-{
-	if(SessionInterface)
+
+	// same query was answered recently, hand the whole result set out right away
+	if(ServeSearchFromCache(MaxSearchResults, Filter))
 	{
-		MultiplayerOnDestroySessionsComplete.Broadcast(false);
+		Metrics.RecordSearchCacheHit();
+		Journal.Record(EMultiplayerSessionJournalEvent::Completed, EMultiplayerSessionMetricOp::Find, NAME_None, EMultiplayerSessionOpOutcome::Success, LastSessionSearch->SearchResults.Num());
+		DeliverSearchPages(true);
 		return;
 	}
 
-	DestroySessionCompleteDelegateHandle = SessionInterface->AddOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegate);
+	// the interface runs one search at a time and ours is more important than a background refresh
+	CancelSearchCacheRefresh();
+
+	FindSessionsCompleteDelegateHandle = SessionInterface->AddOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegate);
+
+	LastSessionSearch = MakeSessionSearch(MaxSearchResults, Filter);
+	LastSearchFilter = Filter;
+	LastMaxSearchResults = MaxSearchResults;
+	ResetRanking();
+
+	// results that still come back are checked once while indexing
+	SearchIndex.Reset(Filter, GetOldestLiveHeartbeat());
+	NumSearchResultsIndexed = 0;
+
+	const FUniqueNetIdPtr LocalUserId = GetLocalUserId();
+	SearchStartTime = FPlatformTime::Seconds();
+	Journal.Record(EMultiplayerSessionJournalEvent::Sent, EMultiplayerSessionMetricOp::Find, NAME_None);
 	
-	if(!SessionInterface->DestroySession(NAME_GameSession))
+	if(!LocalUserId.IsValid() || !SessionInterface->FindSessions(*LocalUserId, LastSessionSearch.ToSharedRef()))
 	{
-		SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegateHandle);
+		Metrics.RecordOutcome(EMultiplayerSessionMetricOp::Find, EMultiplayerSessionOpOutcome::Failure);
+		Journal.Record(EMultiplayerSessionJournalEvent::Completed, EMultiplayerSessionMetricOp::Find, NAME_None, EMultiplayerSessionOpOutcome::Failure);
+		SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+		bIncrementalSearch = false;
 
-		MultiplayerOnDestroySessionsComplete.Broadcast(false);
+		BroadcastSearchPage(TArrayView<const FOnlineSessionSearchResult>(), true);
+		return;
 	}
+
+	// Some online subsystems (e.g. Steam server queries) append results to the search object as each host responds.
+	// Poll it so those results reach listeners before the whole query has completed.
+	SearchPollHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateUObject(this, &ThisClass::TickIncrementalSearch), SearchPollInterval);
 }
-void UMultiplayerSessionsSubsystem::StartSession()
+void UMultiplayerSessionsSubsystem::CancelFindSessions()
 {
-}
+	if(!bIncrementalSearch) { return; }
 
-void UMultiplayerSessionsSubsystem::OnCreateSessionComplete(FName SessionName, bool bWasSuccessful)
+	bIncrementalSearch = false;
+	StopSearchPolling();
+
+	if(!SessionInterface.IsValid()) { return; }
+
+	// results served from the cache have no online query behind them
+	if(!LastSessionSearch.IsValid() || LastSessionSearch->SearchState != EOnlineAsyncTaskState::InProgress) { return; }
+
+	// nobody is waiting for the completion of a cancelled search
+	SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+	SessionInterface->CancelFindSessions();
+
+	Metrics.RecordOutcome(EMultiplayerSessionMetricOp::Find, EMultiplayerSessionOpOutcome::Cancelled);
+	Journal.Record(EMultiplayerSessionJournalEvent::Completed, EMultiplayerSessionMetricOp::Find, NAME_None, EMultiplayerSessionOpOutcome::Cancelled,
+		LastSessionSearch->SearchResults.Num(), MillisecondsSince(SearchStartTime));
+}
+void UMultiplayerSessionsSubsystem::JoinSession(const FOnlineSessionSearchResult& SessionResult)
 {
-	if(SessionInterface)
-	{
-		// clear OnCreateSessionCompleteDelegate from DelegateHandleList
-		SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
+	JoinSession(NAME_GameSession, SessionResult);
+}
+void UMultiplayerSessionsSubsystem::JoinSession(FName SessionName, const FOnlineSessionSearchResult& SessionResult, int32 PartySize)
+{
+	// the caller picked the session, whatever JoinRankedSessions() was going to try next is off
+	StopJoinFailover();
 
-		// Broadcast our own custom delegate
-		MultiplayerOnCreateSessionComplete.Broadcast(true);
+	// no point in the leader getting in if the rest of the party can't follow
+	if (!HasRoomForParty(SessionResult.Session, PartySize))
+	{
+		Metrics.RecordOutcome(EMultiplayerSessionMetricOp::Join, EMultiplayerSessionOpOutcome::Rejected);
+		Journal.Record(EMultiplayerSessionJournalEvent::Completed, EMultiplayerSessionMetricOp::Join, SessionName, EMultiplayerSessionOpOutcome::Rejected);
+		BroadcastSessionOpResult(SessionName, EMultiplayerSessionOpType::Join, false, EOnJoinSessionCompleteResult::SessionIsFull);
+		return;
 	}
+
+	SendJoinSession(SessionName, SessionResult, PartySize);
 }
-void UMultiplayerSessionsSubsystem::OnFindSessionsComplete(bool bWasSuccessful)
+void UMultiplayerSessionsSubsystem::SendJoinSession(FName SessionName, const FOnlineSessionSearchResult& SessionResult, int32 PartySize)
 {
-	if(SessionInterface)
+	// check if SessionInterface is valid 
+	if (!EnsureSessionInterface())
 	{
-		// remove OnFindSessionsDelegateHandle from OnlineInterface delegate list...
-		SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+		Metrics.RecordOutcome(EMultiplayerSessionMetricOp::Join, EMultiplayerSessionOpOutcome::Failure);
+		BroadcastSessionOpResult(SessionName, EMultiplayerSessionOpType::Join, false, EOnJoinSessionCompleteResult::UnknownError);
+		return;
 	}
 
-	// if sessions was found but session array is empty somehow
-	// pass in an empty array and return false
-	if (LastSessionSearch->SearchResults.Num() <= 0)
-	{
-		MultiplayerOnFindSessionsComplete.Broadcast(TArray<FOnlineSessionSearchResult>(), false);
+	// we've picked a session, the rest of the search results are of no use anymore
+	CancelFindSessions();
 
-		// call return here so we can't reach "successful" block 
+	// everything travel needs is prepared while the join handshake is in progress
+	StartJoinPipeline(SessionName, SessionResult);
+	JoinPartySize = FMath::Max(PartySize, 1);
+
+	FMultiplayerSessionOp Op;
+	Op.Type = EMultiplayerSessionOpType::Join;
+	Op.JoinTarget = ShareSearchResult(SessionResult);
+
+	EnqueueSessionOp(SessionName, MoveTemp(Op));
+}
+void UMultiplayerSessionsSubsystem::DestroySession()
+{
+	DestroySession(NAME_GameSession);
+}
+void UMultiplayerSessionsSubsystem::DestroySession(FName SessionName)
+{
+	if(SessionName == JoinFailover.SessionName) { StopJoinFailover(); }
+
+	if(!EnsureSessionInterface())
+	{
+		Metrics.RecordOutcome(EMultiplayerSessionMetricOp::Destroy, EMultiplayerSessionOpOutcome::Failure);
+		BroadcastSessionOpResult(SessionName, EMultiplayerSessionOpType::Destroy, false);
 		return;
 	}
-	
-	// broadcast MultiplayerOnFindSessionsCompleteDelegate to execute callbacks in Menu class
-	// pass an array with found sessions and return true
-	MultiplayerOnFindSessionsComplete.Broadcast(LastSessionSearch->SearchResults, bWasSuccessful);
-	
+
+	FMultiplayerSessionOp Op;
+	Op.Type = EMultiplayerSessionOpType::Destroy;
+
+	EnqueueSessionOp(SessionName, MoveTemp(Op));
 }
-void UMultiplayerSessionsSubsystem::OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result)
+void UMultiplayerSessionsSubsystem::StartSession()
 {
-	// check if SessionInterface is valid 
-	if (SessionInterface)
+	StartSession(NAME_GameSession);
+}
+void UMultiplayerSessionsSubsystem::StartSession(FName SessionName)
+{
+	if(!EnsureSessionInterface())
 	{
-		// remove JoinSessionCompleteDelegate from OnlineInterface delegate list
-		SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegateHandle);
+		Metrics.RecordOutcome(EMultiplayerSessionMetricOp::Start, EMultiplayerSessionOpOutcome::Failure);
+		BroadcastSessionOpResult(SessionName, EMultiplayerSessionOpType::Start, false);
+		return;
+	}
+
+	FMultiplayerSessionOp Op;
+	Op.Type = EMultiplayerSessionOpType::Start;
+
+	EnqueueSessionOp(SessionName, MoveTemp(Op));
+}
+void UMultiplayerSessionsSubsystem::HostSession(int32 NumPublicConnections, FString MatchType, const FString& LobbyPath)
+{
+	HostSessionWithKey(NumPublicConnections, FMultiplayerSessionSearchIndex::MakeMatchKey(MatchType), LobbyPath, 0);
+}
+void UMultiplayerSessionsSubsystem::HostSessionWithKey(int32 NumPublicConnections, uint32 MatchKey, const FString& LobbyPath, uint32 Lineage)
+{
+	ReleasePreloadedMap();
+
+	// superseded creates of an earlier call are cancelled while this one is queued, their serials are below FirstSerial
+	HostPipeline = FHostPipeline();
+	HostPipeline.SessionName = NAME_GameSession;
+	HostPipeline.bActive = true;
+	HostPipeline.FirstSerial = SessionOpSerial + 1;
+	HostPipeline.LobbyPackage = FName(*ToMapPackageName(LobbyPath));
 
-		// pass in to Menu class that the join to a session was successful
-		MultiplayerOnJoinSessionsComplete.Broadcast(EOnJoinSessionCompleteResult::Success);
+	// the map streams in while the online service is busy creating the session
+	const FString LobbyPackageName = PreloadMap(LobbyPath, FLoadPackageAsyncDelegate::CreateUObject(this, &ThisClass::OnLobbyPackageLoaded));
+
+	// advertise the map so joining clients can preload it as well
+	CreateSessionWithKey(HostPipeline.SessionName, NumPublicConnections, MatchKey, LobbyPackageName, false, Lineage);
+}
+void UMultiplayerSessionsSubsystem::HostDedicatedSession(int32 MaxPlayers, FString MatchType, const FString& MapName)
+{
+	HostDedicatedSession(NAME_GameSession, MaxPlayers, MatchType, MapName);
+}
+void UMultiplayerSessionsSubsystem::HostDedicatedSession(FName SessionName, int32 MaxPlayers, FString MatchType, const FString& MapName)
+{
+	FString AdvertisedMap = MapName;
+	if (AdvertisedMap.IsEmpty())
+	{
+		const UWorld* World = GetWorld();
+		AdvertisedMap = World ? World->GetOutermost()->GetName() : FString();
 	}
 
-	// Add JoinSessionCompleteDelegate to OnlineInterface delegate list  
-	JoinSessionCompleteDelegateHandle = SessionInterface->AddOnJoinSessionCompleteDelegate_Handle(JoinSessionCompleteDelegate);
+	CreateSession(SessionName, MaxPlayers, MatchType, AdvertisedMap, true);
+
+	// the map is running already, nothing to wait for before starting. The start is queued behind the create.
+	StartSession(SessionName);
 }
-void UMultiplayerSessionsSubsystem::OnDestroySessionComplete(FName SessionName, bool bWasSuccessful)
+void UMultiplayerSessionsSubsystem::QueuePlayerRegistration(FName SessionName, const FUniqueNetIdRef& PlayerId, bool bRegister)
 {
-	// check if SessionInterface is valid 
-	if(SessionInterface)
+	if(!EnsureSessionInterface()) { return; }
+
+	FPendingPlayerRegistrations& Pending = PendingPlayerRegistrations.FindOrAdd(SessionName);
+	TArray<FUniqueNetIdRef>& Queue = bRegister ? Pending.ToRegister : Pending.ToUnregister;
+	TArray<FUniqueNetIdRef>& Opposite = bRegister ? Pending.ToUnregister : Pending.ToRegister;
+
+	// a player that joins and leaves (or leaves and rejoins) within one batch doesn't change anything
+	const int32 NumCancelled = Opposite.RemoveAll([&PlayerId](const FUniqueNetIdRef& Queued) { return *Queued == *PlayerId; });
+	if (NumCancelled == 0 && !Queue.ContainsByPredicate([&PlayerId](const FUniqueNetIdRef& Queued) { return *Queued == *PlayerId; }))
 	{
-		// remove DestroyDelegate from delegate list
-		SessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegateHandle);
+		Queue.Add(PlayerId);
 	}
-	
-	if (bWasSuccessful && bCreateSessionOnDestroy)
+
+	if (!PlayerRegistrationHandle.IsValid())
+	{
+		PlayerRegistrationHandle = FTSTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateUObject(this, &ThisClass::FlushPlayerRegistrations), FMath::Max(PlayerRegistrationInterval, 0.f));
+	}
+}
+bool UMultiplayerSessionsSubsystem::FlushPlayerRegistrations(float DeltaTime)
+{
+	PlayerRegistrationHandle.Reset();
+
+	TMap<FName, FPendingPlayerRegistrations> Batches = MoveTemp(PendingPlayerRegistrations);
+	PendingPlayerRegistrations.Reset();
+
+	if(!SessionInterface.IsValid()) { return false; }
+
+	for (TPair<FName, FPendingPlayerRegistrations>& Batch : Batches)
 	{
-		bCreateSessionOnDestroy = false;
+		FNamedOnlineSession* Session = SessionInterface->GetNamedSession(Batch.Key);
+		if(!Session || (Batch.Value.ToRegister.Num() == 0 && Batch.Value.ToUnregister.Num() == 0)) { continue; }
 
-		CreateSession(LastNumPublicConnections, LastMatchType);
+		if (Batch.Value.ToUnregister.Num() > 0)
+		{
+			SessionInterface->UnregisterPlayers(Batch.Key, Batch.Value.ToUnregister);
+		}
+		if (Batch.Value.ToRegister.Num() > 0)
+		{
+			SessionInterface->RegisterPlayers(Batch.Key, Batch.Value.ToRegister);
+		}
+
+		// one refresh for the whole batch publishes the new player count to searching clients,
+		// coalesced with whatever else changed about the session this frame
+		RefreshHostedSession(Batch.Key, false);
 	}
 
-	MultiplayerOnDestroySessionsComplete.Broadcast(bWasSuccessful);
-	
+	return false;
 }
-void UMultiplayerSessionsSubsystem::OnStartSessionComplete(FName SessionName, bool bWasSuccessful)
+EMultiplayerSessionState UMultiplayerSessionsSubsystem::GetSessionState(FName SessionName) const
 {
+	const FMultiplayerSessionSlot* Slot = Sessions.Find(SessionName);
+	return Slot ? Slot->State : EMultiplayerSessionState::None;
 }
+void UMultiplayerSessionsSubsystem::SetSessionSetting(FName SessionName, FName Key, const FVariantData& Value)
+{
+	FOnlineSessionSettings* Settings = GetHostedSessionSettings(SessionName);
+	if(!Settings) { return; }
 
+	const FOnlineSessionSetting* Existing = Settings->Settings.Find(Key);
+	if(Existing && Existing->Data == Value) { return; }
 
-
-
+	Settings->Set(Key, FOnlineSessionSetting(Value, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing));
+	MarkSessionSettingsDirty(SessionName);
+}
+void UMultiplayerSessionsSubsystem::SetSessionMatchType(FName SessionName, const FString& MatchType)
+{
+	FOnlineSessionSettings* Settings = GetHostedSessionSettings(SessionName);
+	if (Settings && MultiplayerSessionAttributes::SetInt(*Settings, EMultiplayerSessionAttribute::MatchKey, FMultiplayerSessionSearchIndex::MakeMatchKey(MatchType)))
+	{
+		MarkSessionSettingsDirty(SessionName);
+	}
+}
+void UMultiplayerSessionsSubsystem::SetSessionMapName(FName SessionName, const FString& MapName)
+{
+	FOnlineSessionSettings* Settings = GetHostedSessionSettings(SessionName);
+	if (Settings && MultiplayerSessionAttributes::SetString(*Settings, EMultiplayerSessionAttribute::MapName, MapName))
+	{
+		MarkSessionSettingsDirty(SessionName);
+	}
+}
+void UMultiplayerSessionsSubsystem::SetSessionNumPublicConnections(FName SessionName, int32 NumPublicConnections)
+{
+	FOnlineSessionSettings* Settings = GetHostedSessionSettings(SessionName);
+	if(!Settings || Settings->NumPublicConnections == NumPublicConnections) { return; }
+
+	Settings->NumPublicConnections = NumPublicConnections;
+	MarkSessionSettingsDirty(SessionName);
+
+	// a session that was full may have room now, or the other way round
+	RefreshHostedSession(SessionName, false);
+}
+void UMultiplayerSessionsSubsystem::SetSessionMatchPhase(FName SessionName, EMultiplayerSessionMatchPhase Phase)
+{
+	FOnlineSessionSettings* Settings = GetHostedSessionSettings(SessionName);
+	if (Settings && MultiplayerSessionAttributes::SetInt(*Settings, EMultiplayerSessionAttribute::MatchPhase, static_cast<uint32>(Phase)))
+	{
+		MarkSessionSettingsDirty(SessionName);
+		RefreshHostedSession(SessionName, false);
+	}
+}
+EMultiplayerSessionMatchPhase UMultiplayerSessionsSubsystem::GetSessionMatchPhase(FName SessionName) const
+{
+	const FOnlineSessionSettings* Settings = GetSessionSettings(SessionName);
+
+	uint32 Phase = 0;
+	if(Settings) { MultiplayerSessionAttributes::GetInt(*Settings, EMultiplayerSessionAttribute::MatchPhase, Phase); }
+	return static_cast<EMultiplayerSessionMatchPhase>(Phase);
+}
+FOnlineSessionSettings* UMultiplayerSessionsSubsystem::GetHostedSessionSettings(FName SessionName)
+{
+	// only sessions we've created have settings of our own, a joined session belongs to its host
+	FMultiplayerSessionSlot* Slot = Sessions.Find(SessionName);
+	return Slot ? Slot->Settings.Get() : nullptr;
+}
+void UMultiplayerSessionsSubsystem::MarkSessionSettingsDirty(FName SessionName)
+{
+	FMultiplayerSessionSlot* Slot = Sessions.Find(SessionName);
+	if(!Slot || !Slot->Settings.IsValid()) { return; }
+
+	Slot->bSettingsDirty = true;
+	ScheduleSessionUpdates(0.f);
+}
+void UMultiplayerSessionsSubsystem::ScheduleSessionUpdates(float Delay)
+{
+	// a flush that is scheduled already picks up this change as well
+	if(SessionUpdateHandle.IsValid()) { return; }
+
+	SessionUpdateHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateUObject(this, &ThisClass::FlushSessionUpdates), FMath::Max(Delay, 0.f));
+}
+bool UMultiplayerSessionsSubsystem::FlushSessionUpdates(float DeltaTime)
+{
+	SessionUpdateHandle.Reset();
+	if(!SessionInterface.IsValid()) { return false; }
+
+	const double Now = FPlatformTime::Seconds();
+	double NextFlushDelay = -1.0;
+
+	// collect first, an update may complete from inside the call
+	TArray<FName, TInlineAllocator<16>> ToUpdate;
+	for (const FMultiplayerSessionSlot& Slot : Sessions.GetSlots())
+	{
+		if(!Slot.bSettingsDirty || Slot.bUpdateInFlight || !Slot.Settings.IsValid()) { continue; }
+
+		// the session has to exist online and nothing may be about to replace or remove it. Sessions that aren't
+		// there yet stay dirty, the create completing schedules another flush
+		const bool bExists = Slot.State == EMultiplayerSessionState::Pending || Slot.State == EMultiplayerSessionState::Starting ||
+			Slot.State == EMultiplayerSessionState::InProgress;
+		const bool bAboutToChange = Slot.PendingOps.Num() > 0 || (Slot.InFlight.IsSet() && Slot.InFlight->Type != EMultiplayerSessionOpType::Start);
+
+		if(!bExists || bAboutToChange) { continue; }
+
+		// one update per session and interval, changes made in between wait and go out together
+		const double UntilNextUpdate = Slot.UpdateSentTime > 0.0 ? Slot.UpdateSentTime + SessionUpdateInterval - Now : 0.0;
+		if (UntilNextUpdate > 0.0)
+		{
+			NextFlushDelay = NextFlushDelay < 0.0 ? UntilNextUpdate : FMath::Min(NextFlushDelay, UntilNextUpdate);
+			continue;
+		}
+
+		ToUpdate.Add(Slot.SessionName);
+	}
+
+	for (const FName SessionName : ToUpdate)
+	{
+		FMultiplayerSessionSlot* Slot = Sessions.Find(SessionName);
+		if(!Slot) { continue; }
+
+		Slot->bSettingsDirty = false;
+		Slot->bUpdateInFlight = true;
+		Slot->UpdateSentTime = FPlatformTime::Seconds();
+
+		Journal.Record(EMultiplayerSessionJournalEvent::Sent, EMultiplayerSessionMetricOp::Update, SessionName);
+
+		const TSharedPtr<FOnlineSessionSettings> Settings = Slot->Settings;
+		if (!SessionInterface->UpdateSession(SessionName, *Settings, true))
+		{
+			Metrics.RecordOutcome(EMultiplayerSessionMetricOp::Update, EMultiplayerSessionOpOutcome::Failure);
+			Journal.Record(EMultiplayerSessionJournalEvent::Completed, EMultiplayerSessionMetricOp::Update, SessionName, EMultiplayerSessionOpOutcome::Failure);
+
+			// the settings we hold are still the ones to advertise, try again in a bit
+			Slot = Sessions.Find(SessionName);
+			if (Slot)
+			{
+				Slot->bUpdateInFlight = false;
+				Slot->bSettingsDirty = true;
+				NextFlushDelay = NextFlushDelay < 0.0 ? SessionUpdateRetryDelay : FMath::Min<double>(NextFlushDelay, SessionUpdateRetryDelay);
+			}
+		}
+	}
+
+	if (NextFlushDelay >= 0.0)
+	{
+		ScheduleSessionUpdates(static_cast<float>(NextFlushDelay));
+	}
+
+	return false;
+}
+EMultiplayerSessionState UMultiplayerSessionsSubsystem::GetSessionState(FMultiplayerSessionHandle Handle) const
+{
+	const FMultiplayerSessionSlot* Slot = Sessions.Find(Handle);
+	return Slot ? Slot->State : EMultiplayerSessionState::None;
+}
+const FOnlineSessionSettings* UMultiplayerSessionsSubsystem::GetSessionSettings(FName SessionName) const
+{
+	const FMultiplayerSessionSlot* Slot = Sessions.Find(SessionName);
+	return Slot ? Slot->Settings.Get() : nullptr;
+}
+bool UMultiplayerSessionsSubsystem::IsSessionIdle(FName SessionName) const
+{
+	const FMultiplayerSessionSlot* Slot = Sessions.Find(SessionName);
+	return !Slot || Slot->IsIdle();
+}
+void UMultiplayerSessionsSubsystem::CancelPendingSessionOps(FName SessionName)
+{
+	FMultiplayerSessionSlot* Slot = Sessions.Find(SessionName);
+	if(!Slot) { return; }
+
+	TArray<FMultiplayerSessionOp> Cancelled;
+	Slot->CancelPending(Cancelled);
+
+	for (const FMultiplayerSessionOp& Op : Cancelled)
+	{
+		// a cancelled join is the caller's decision, not a host turning us down
+		if(Op.Type == EMultiplayerSessionOpType::Join && SessionName == JoinFailover.SessionName) { StopJoinFailover(); }
+
+		Metrics.RecordOutcome(ToMetricOp(Op.Type), EMultiplayerSessionOpOutcome::Cancelled);
+		Journal.Record(EMultiplayerSessionJournalEvent::Completed, ToMetricOp(Op.Type), SessionName, EMultiplayerSessionOpOutcome::Cancelled);
+		BroadcastSessionOpResult(SessionName, Op.Type, false, EOnJoinSessionCompleteResult::UnknownError, Op.Serial);
+	}
+}
+
+void UMultiplayerSessionsSubsystem::OnCreateSessionComplete(FName SessionName, bool bWasSuccessful)
+{
+	// somebody else's session, or an op we are no longer waiting for
+	if(!IsSessionOpInFlight(SessionName, EMultiplayerSessionOpType::Create)) { return; }
+
+	FinishSessionOp(SessionName, bWasSuccessful);
+	PumpSessionOps(SessionName);
+}
+void UMultiplayerSessionsSubsystem::OnFindSessionsComplete(bool bWasSuccessful)
+{
+	if(SessionInterface)
+	{
+		// remove OnFindSessionsDelegateHandle from OnlineInterface delegate list...
+		SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(FindSessionsCompleteDelegateHandle);
+	}
+
+	Metrics.RecordCompletion(EMultiplayerSessionMetricOp::Find, bWasSuccessful ? EMultiplayerSessionOpOutcome::Success : EMultiplayerSessionOpOutcome::Failure,
+		SearchStartTime, FPlatformTime::Seconds());
+	if (LastSessionSearch.IsValid())
+	{
+		Metrics.RecordSearchResults(LastSessionSearch->SearchResults.Num());
+	}
+	Journal.Record(EMultiplayerSessionJournalEvent::Completed, EMultiplayerSessionMetricOp::Find, NAME_None,
+		bWasSuccessful ? EMultiplayerSessionOpOutcome::Success : EMultiplayerSessionOpOutcome::Failure,
+		LastSessionSearch.IsValid() ? LastSessionSearch->SearchResults.Num() : 0, MillisecondsSince(SearchStartTime));
+
+	// remember the results so the next identical query doesn't have to go online.
+	// An empty result set isn't worth keeping, somebody may host in the meantime
+	if (bWasSuccessful && LastSessionSearch.IsValid() && LastSessionSearch->SearchResults.Num() > 0)
+	{
+		SearchCache.Store(LastSearchFilter, LastMaxSearchResults, LastSessionSearch.ToSharedRef(), FPlatformTime::Seconds());
+	}
+
+	// incremental search: flush whatever hasn't been delivered yet as the last page
+	if (bIncrementalSearch)
+	{
+		StopSearchPolling();
+		DeliverSearchPages(true);
+		return;
+	}
+
+	// if sessions was found but session array is empty somehow
+	// pass in an empty array and return false
+	if (LastSessionSearch->SearchResults.Num() <= 0)
+	{
+		MultiplayerOnFindSessionsComplete.Broadcast(TArrayView<const FOnlineSessionSearchResult>(), false);
+
+		// call return here so we can't reach "successful" block 
+		return;
+	}
+	
+	IndexSearchResults();
+
+	// broadcast MultiplayerOnFindSessionsCompleteDelegate to execute callbacks in Menu class
+	// pass a view of the found sessions, held alive in case a listener starts another search, and return true
+	const TSharedPtr<FOnlineSessionSearch> Search = LastSessionSearch;
+	MultiplayerOnFindSessionsComplete.Broadcast(Search->SearchResults, bWasSuccessful);
+	
+}
+void UMultiplayerSessionsSubsystem::OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result)
+{
+	if(!IsSessionOpInFlight(SessionName, EMultiplayerSessionOpType::Join)) { return; }
+
+	// the session may have filled up between the search and the join, what we found it with is no use to tell
+	if (Result == EOnJoinSessionCompleteResult::Success && SessionName == JoinPipelineSessionName && JoinPartySize > 1 && CheckRoomForParty(SessionName))
+	{
+		return;
+	}
+
+	CompleteJoinSession(SessionName, Result);
+}
+bool UMultiplayerSessionsSubsystem::CheckRoomForParty(FName SessionName)
+{
+	const FMultiplayerSessionSlot* Slot = Sessions.Find(SessionName);
+	const FNamedOnlineSession* Joined = SessionInterface->GetNamedSession(SessionName);
+	const FUniqueNetIdPtr LocalUserId = GetLocalUserId();
+	if(!Slot || !Slot->InFlight.IsSet() || !Joined || !Joined->SessionInfo.IsValid() || !LocalUserId.IsValid()) { return false; }
+
+	return SessionInterface->FindSessionById(*LocalUserId, Joined->SessionInfo->GetSessionId(), *LocalUserId,
+		FOnSingleSessionResultCompleteDelegate::CreateUObject(this, &ThisClass::OnPartyRoomChecked, SessionName, Slot->InFlight->Serial));
+}
+void UMultiplayerSessionsSubsystem::OnPartyRoomChecked(int32 LocalUserNum, bool bWasSuccessful, const FOnlineSessionSearchResult& SessionResult, FName SessionName, uint32 Serial)
+{
+	// the join was given up on while we waited
+	const FMultiplayerSessionSlot* Slot = Sessions.Find(SessionName);
+	if(!Slot || !Slot->InFlight.IsSet() || Slot->InFlight->Serial != Serial || !SessionInterface.IsValid()) { return; }
+
+	// we hold one of the open slots ourselves now, if the host has counted us in already. A lookup that failed tells
+	// nothing, the members find out for themselves then.
+	const FOnlineSession& Session = SessionResult.Session;
+	const bool bPartyFits = !bWasSuccessful || !SessionResult.IsValid() ||
+		(Session.SessionSettings.NumPublicConnections >= JoinPartySize && Session.NumOpenPublicConnections + 1 >= JoinPartySize);
+
+	if (bPartyFits)
+	{
+		CompleteJoinSession(SessionName, EOnJoinSessionCompleteResult::Success);
+		return;
+	}
+
+	// leave again before anybody travels, a failover tries the next candidate behind the leave in the session queue
+	FMultiplayerSessionOp Leave;
+	Leave.Type = EMultiplayerSessionOpType::Destroy;
+	EnqueueSessionOp(SessionName, MoveTemp(Leave));
+
+	CompleteJoinSession(SessionName, EOnJoinSessionCompleteResult::SessionIsFull);
+}
+void UMultiplayerSessionsSubsystem::CompleteJoinSession(FName SessionName, EOnJoinSessionCompleteResult::Type Result)
+{
+	if (Result == EOnJoinSessionCompleteResult::Success && SessionName == JoinPipelineSessionName)
+	{
+		JoinTimings.JoinCompletedTime = FPlatformTime::Seconds();
+
+		// some online subsystems only know the address once we're in the session
+		if (JoinConnectAddress.IsEmpty() && SessionInterface->GetResolvedConnectString(SessionName, JoinConnectAddress))
+		{
+			JoinTimings.AddressResolvedTime = JoinTimings.JoinCompletedTime;
+		}
+	}
+
+	FinishSessionOp(SessionName, Result == EOnJoinSessionCompleteResult::Success, Result);
+	PumpSessionOps(SessionName);
+}
+void UMultiplayerSessionsSubsystem::OnDestroySessionComplete(FName SessionName, bool bWasSuccessful)
+{
+	if(!IsSessionOpInFlight(SessionName, EMultiplayerSessionOpType::Destroy)) { return; }
+
+	FinishSessionOp(SessionName, bWasSuccessful);
+	PumpSessionOps(SessionName);
+}
+void UMultiplayerSessionsSubsystem::OnStartSessionComplete(FName SessionName, bool bWasSuccessful)
+{
+	if(!IsSessionOpInFlight(SessionName, EMultiplayerSessionOpType::Start)) { return; }
+
+	FinishSessionOp(SessionName, bWasSuccessful);
+	PumpSessionOps(SessionName);
+}
+void UMultiplayerSessionsSubsystem::OnUpdateSessionComplete(FName SessionName, bool bWasSuccessful)
+{
+	FMultiplayerSessionSlot* Slot = Sessions.Find(SessionName);
+	if(!Slot || !Slot->bUpdateInFlight) { return; }
+
+	Slot->bUpdateInFlight = false;
+	Metrics.RecordCompletion(EMultiplayerSessionMetricOp::Update, bWasSuccessful ? EMultiplayerSessionOpOutcome::Success : EMultiplayerSessionOpOutcome::Failure,
+		Slot->UpdateSentTime, FPlatformTime::Seconds());
+	Journal.Record(EMultiplayerSessionJournalEvent::Completed, EMultiplayerSessionMetricOp::Update, SessionName,
+		bWasSuccessful ? EMultiplayerSessionOpOutcome::Success : EMultiplayerSessionOpOutcome::Failure, 0, MillisecondsSince(Slot->UpdateSentTime));
+
+	// the settings we hold are still the ones to advertise, try again in a bit
+	if (!bWasSuccessful)
+	{
+		Slot->bSettingsDirty = true;
+		ScheduleSessionUpdates(SessionUpdateRetryDelay);
+		return;
+	}
+
+	// changed again while the update was in flight
+	if (Slot->bSettingsDirty)
+	{
+		ScheduleSessionUpdates(0.f);
+	}
+}
+
+/* SESSION OPERATION QUEUE
+ * ====================================================================================================================
+ *
+ *	Every named session has a slot with at most one operation in flight at the online service and a queue of
+ *	operations waiting behind it. Public calls only enqueue, PumpSessionOps() sends the next operation once the
+ *	previous one has completed and the completion callbacks above finish it.
+ *
+ *	Some online subsystems (e.g. NULL) complete synchronously from inside the call, so slots are always looked up
+ *	again by name after talking to the online service or broadcasting.
+ *
+ * ====================================================================================================================
+ */
+FMultiplayerSessionSlot& UMultiplayerSessionsSubsystem::FindOrAddSessionSlot(FName SessionName)
+{
+	return Sessions.FindOrAdd(SessionName);
+}
+void UMultiplayerSessionsSubsystem::EnqueueSessionOp(FName SessionName, FMultiplayerSessionOp&& Op)
+{
+	const EMultiplayerSessionOpType Type = Op.Type;
+	const uint32 Serial = Op.Serial = ++SessionOpSerial;
+	Journal.Record(EMultiplayerSessionJournalEvent::Requested, ToMetricOp(Type), SessionName);
+
+	FMultiplayerSessionSlot& Slot = FindOrAddSessionSlot(SessionName);
+
+	// a session the slot doesn't know about (created behind our back, or left over after its slot was dropped) still
+	// has to go before another one can take its name, the slot takes it over so the destroy is queued first
+	const bool bSetsUpSession = Type == EMultiplayerSessionOpType::Create || Type == EMultiplayerSessionOpType::Join;
+	if (bSetsUpSession && Slot.IsIdle() && !Slot.WillExist() && !Slot.bLANBeaconSession && SessionInterface.IsValid() && SessionInterface->GetNamedSession(SessionName))
+	{
+		Slot.State = EMultiplayerSessionState::Pending;
+	}
+
+	TArray<FMultiplayerSessionOp> Cancelled;
+	const EMultiplayerSessionEnqueueResult Result = Slot.Enqueue(MoveTemp(Op), Cancelled);
+
+	// whoever asked for the superseded ops has to know they won't happen
+	for (const FMultiplayerSessionOp& CancelledOp : Cancelled)
+	{
+		if(CancelledOp.Type == EMultiplayerSessionOpType::Join && SessionName == JoinFailover.SessionName) { StopJoinFailover(); }
+
+		Metrics.RecordOutcome(ToMetricOp(CancelledOp.Type), EMultiplayerSessionOpOutcome::Cancelled);
+		Journal.Record(EMultiplayerSessionJournalEvent::Completed, ToMetricOp(CancelledOp.Type), SessionName, EMultiplayerSessionOpOutcome::Cancelled);
+		BroadcastSessionOpResult(SessionName, CancelledOp.Type, false, EOnJoinSessionCompleteResult::UnknownError, CancelledOp.Serial);
+	}
+
+	if (Result == EMultiplayerSessionEnqueueResult::Rejected)
+	{
+		Metrics.RecordOutcome(ToMetricOp(Type), EMultiplayerSessionOpOutcome::Rejected);
+		Journal.Record(EMultiplayerSessionJournalEvent::Completed, ToMetricOp(Type), SessionName, EMultiplayerSessionOpOutcome::Rejected);
+		BroadcastSessionOpResult(SessionName, Type, false, EOnJoinSessionCompleteResult::UnknownError, Serial);
+	}
+
+	PumpSessionOps(SessionName);
+}
+void UMultiplayerSessionsSubsystem::PumpSessionOps(FName SessionName)
+{
+	FMultiplayerSessionSlot* Slot = Sessions.Find(SessionName);
+
+	while (Slot && !Slot->InFlight.IsSet() && Slot->PendingOps.Num() > 0)
+	{
+		FMultiplayerSessionOp Op = MoveTemp(Slot->PendingOps[0]);
+		Slot->PendingOps.RemoveAt(0);
+
+		// destroys the slot puts in front of a create or join weren't requested by anybody and get theirs here
+		if(Op.Serial == 0) { Op.Serial = ++SessionOpSerial; }
+
+		const uint32 Serial = Op.Serial;
+		const TSharedPtr<FOnlineSessionSettings> OpSettings = Op.Settings;
+		const TSharedPtr<const FOnlineSessionSearchResult> OpJoinTarget = Op.JoinTarget;
+		const EMultiplayerSessionOpType Type = Op.Type;
+
+		Slot->StateBeforeOp = Slot->State;
+		Op.SentTime = FPlatformTime::Seconds();
+		Slot->InFlight = MoveTemp(Op);
+
+		// before the call, the completion may run from inside it
+		Journal.Record(EMultiplayerSessionJournalEvent::Sent, ToMetricOp(Type), SessionName);
+
+		bool bStarted = false;
+		const FUniqueNetIdPtr LocalUserId = GetLocalUserId();
+
+		// nothing at the online subsystem stands behind a session joined through the LAN beacon
+		if (Slot->bLANBeaconSession || (Type == EMultiplayerSessionOpType::Join && FMultiplayerSessionLANBeacon::IsBeaconResult(*OpJoinTarget)))
+		{
+			Slot->bLANBeaconSession = true;
+			bStarted = SendLANBeaconSessionOp(SessionName, Type);
+		}
+		else
+		{
+			switch (Type)
+			{
+			case EMultiplayerSessionOpType::Create:
+				Slot->State = EMultiplayerSessionState::Creating;
+				Slot->Settings = OpSettings;
+
+				// the create carries every change made to the settings so far
+				Slot->bSettingsDirty = false;
+				if (OpSettings->bIsDedicated)
+				{
+					// there's no local player on a dedicated server, the online subsystem hosts under the server's identity
+					bStarted = SessionInterface->CreateSession(0, SessionName, *OpSettings);
+				}
+				else
+				{
+					bStarted = LocalUserId.IsValid() && SessionInterface->CreateSession(*LocalUserId, SessionName, *OpSettings);
+				}
+				break;
+			case EMultiplayerSessionOpType::Join:
+				Slot->State = EMultiplayerSessionState::Joining;
+				bStarted = LocalUserId.IsValid() && SessionInterface->JoinSession(*LocalUserId, SessionName, *OpJoinTarget);
+				break;
+			case EMultiplayerSessionOpType::Start:
+				Slot->State = EMultiplayerSessionState::Starting;
+				bStarted = SessionInterface->StartSession(SessionName);
+				break;
+			case EMultiplayerSessionOpType::Destroy:
+				Slot->State = EMultiplayerSessionState::Destroying;
+				bStarted = SessionInterface->DestroySession(SessionName);
+				break;
+			}
+		}
+
+		// the completion may have run from inside the call and the op may already be finished
+		Slot = Sessions.Find(SessionName);
+		if (!bStarted && Slot && Slot->InFlight.IsSet() && Slot->InFlight->Serial == Serial)
+		{
+			// the online service refused, nothing is coming back for this op and there's no latency to speak of
+			Slot->InFlight->SentTime = 0.0;
+			FinishSessionOp(SessionName, false);
+			Slot = Sessions.Find(SessionName);
+		}
+		else if (bStarted && Slot && Slot->InFlight.IsSet() && Slot->InFlight->Serial == Serial)
+		{
+			MultiplayerOnSessionStateChanged.Broadcast(SessionName, GetSessionState(SessionName));
+			Slot = Sessions.Find(SessionName);
+		}
+	}
+
+	// nothing left to track for a session that is gone and has nothing queued
+	if (Slot && Slot->State == EMultiplayerSessionState::None && Slot->IsIdle())
+	{
+		Sessions.Remove(SessionName);
+	}
+}
+void UMultiplayerSessionsSubsystem::FinishSessionOp(FName SessionName, bool bWasSuccessful, EOnJoinSessionCompleteResult::Type JoinResult)
+{
+	FMultiplayerSessionSlot* Slot = Sessions.Find(SessionName);
+	if(!Slot || !Slot->InFlight.IsSet()) { return; }
+
+	const EMultiplayerSessionOpType Type = Slot->InFlight->Type;
+	const double SentTime = Slot->InFlight->SentTime;
+	const uint32 Serial = Slot->InFlight->Serial;
+	Slot->InFlight.Reset();
+
+	if (SentTime > 0.0)
+	{
+		Metrics.RecordCompletion(ToMetricOp(Type), ToOutcome(bWasSuccessful, JoinResult), SentTime, FPlatformTime::Seconds());
+	}
+	else
+	{
+		Metrics.RecordOutcome(ToMetricOp(Type), ToOutcome(bWasSuccessful, JoinResult));
+	}
+	Journal.Record(EMultiplayerSessionJournalEvent::Completed, ToMetricOp(Type), SessionName, ToOutcome(bWasSuccessful, JoinResult), 0, MillisecondsSince(SentTime));
+
+	switch (Type)
+	{
+	case EMultiplayerSessionOpType::Create:
+		Slot->State = bWasSuccessful ? EMultiplayerSessionState::Pending : EMultiplayerSessionState::None;
+		if(!bWasSuccessful) { Slot->Settings.Reset(); }
+		break;
+	case EMultiplayerSessionOpType::Join:
+		Slot->State = bWasSuccessful ? EMultiplayerSessionState::Pending : EMultiplayerSessionState::None;
+		break;
+	case EMultiplayerSessionOpType::Start:
+		Slot->State = bWasSuccessful ? EMultiplayerSessionState::InProgress : Slot->StateBeforeOp;
+
+		// a started match takes players only if the session allows joining in progress
+		if (bWasSuccessful && Slot->Settings.IsValid())
+		{
+			if (MultiplayerSessionAttributes::SetInt(*Slot->Settings, EMultiplayerSessionAttribute::MatchPhase, static_cast<uint32>(EMultiplayerSessionMatchPhase::InProgress)))
+			{
+				MarkSessionSettingsDirty(SessionName);
+			}
+			RefreshHostedSession(SessionName, false);
+		}
+		break;
+	case EMultiplayerSessionOpType::Destroy:
+		Slot->State = bWasSuccessful ? EMultiplayerSessionState::None : Slot->StateBeforeOp;
+		if(bWasSuccessful) { Slot->Settings.Reset(); }
+		break;
+	}
+
+	// settings changed while the op was in flight or queued, the session may be able to take the update now
+	if(Slot->bSettingsDirty && Slot->Settings.IsValid()) { ScheduleSessionUpdates(0.f); }
+
+	// LAN listeners hear about a session we now host, or no longer do, right away instead of with the next beacon
+	if(bWasSuccessful && (Type == EMultiplayerSessionOpType::Create || Type == EMultiplayerSessionOpType::Destroy)) { LANBeacon.RequestAnnounce(); }
+
+	MultiplayerOnSessionStateChanged.Broadcast(SessionName, GetSessionState(SessionName));
+	BroadcastSessionOpResult(SessionName, Type, bWasSuccessful, JoinResult, Serial);
+}
+bool UMultiplayerSessionsSubsystem::IsSessionOpInFlight(FName SessionName, EMultiplayerSessionOpType Type) const
+{
+	const FMultiplayerSessionSlot* Slot = Sessions.Find(SessionName);
+	return Slot && Slot->InFlight.IsSet() && Slot->InFlight->Type == Type;
+}
+void UMultiplayerSessionsSubsystem::BroadcastSessionOpResult(FName SessionName, EMultiplayerSessionOpType Type, bool bWasSuccessful, EOnJoinSessionCompleteResult::Type JoinResult, uint32 Serial)
+{
+	// every outcome, including rejected and cancelled ops, moves a running host pipeline along
+	if(HostPipeline.bActive && SessionName == HostPipeline.SessionName)
+	{
+		OnHostPipelineSessionOp(Type, bWasSuccessful, Serial);
+	}
+
+	// a join that fails over to the next candidate isn't over yet
+	if (Type == EMultiplayerSessionOpType::Join && JoinFailover.bActive && SessionName == JoinFailover.SessionName &&
+		ContinueJoinFailover(bWasSuccessful, JoinResult))
+	{
+		return;
+	}
+
+	MultiplayerOnSessionOpComplete.Broadcast(SessionName, Type, bWasSuccessful);
+
+	// the menu delegates only speak for the game session, other sessions are followed through MultiplayerOnSessionStateChanged
+	if(SessionName != NAME_GameSession) { return; }
+
+	// a host migration drives the game session itself until everybody is back together
+	if (IsHostMigrationActive())
+	{
+		if(Type == EMultiplayerSessionOpType::Join) { OnHostMigrationJoined(bWasSuccessful); }
+		return;
+	}
+
+	// a quick match drives the game session itself and reports only its final outcome
+	if (IsQuickMatchActive())
+	{
+		if(Type == EMultiplayerSessionOpType::Join) { OnQuickMatchJoined(bWasSuccessful); }
+		return;
+	}
+
+	switch (Type)
+	{
+	case EMultiplayerSessionOpType::Create:
+		MultiplayerOnCreateSessionComplete.Broadcast(bWasSuccessful);
+		break;
+	case EMultiplayerSessionOpType::Join:
+		MultiplayerOnJoinSessionsComplete.Broadcast(bWasSuccessful ? EOnJoinSessionCompleteResult::Success : JoinResult);
+		break;
+	case EMultiplayerSessionOpType::Start:
+		MultiplayerOnStartSessionsComplete.Broadcast(bWasSuccessful);
+		break;
+	case EMultiplayerSessionOpType::Destroy:
+		MultiplayerOnDestroySessionsComplete.Broadcast(bWasSuccessful);
+		break;
+	}
+}
+void UMultiplayerSessionsSubsystem::OnHostPipelineSessionOp(EMultiplayerSessionOpType Type, bool bWasSuccessful, uint32 Serial)
+{
+	// a create cancelled in favour of this pipeline's own isn't its failure
+	if(Serial != 0 && Serial < HostPipeline.FirstSerial) { return; }
+
+	if (Type == EMultiplayerSessionOpType::Create && !HostPipeline.bStarting)
+	{
+		if (!bWasSuccessful)
+		{
+			HostPipeline.bActive = false;
+			BroadcastHostReady(false);
+			return;
+		}
+
+		HostPipeline.bSessionCreated = true;
+		AdvanceHostPipeline();
+	}
+	else if (Type == EMultiplayerSessionOpType::Start && HostPipeline.bStarting)
+	{
+		// a session that failed to start is still created and advertised, travelling into it is fine
+		HostPipeline.bActive = false;
+		BroadcastHostReady(true);
+	}
+}
+void UMultiplayerSessionsSubsystem::BroadcastHostReady(bool bWasSuccessful)
+{
+	if (IsHostMigrationActive())
+	{
+		OnHostMigrationHostReady(bWasSuccessful);
+		return;
+	}
+
+	if (IsQuickMatchActive())
+	{
+		OnQuickMatchHostReady(bWasSuccessful);
+		return;
+	}
+
+	MultiplayerOnHostReady.Broadcast(bWasSuccessful);
+}
+void UMultiplayerSessionsSubsystem::StartJoinPipeline(FName SessionName, const FOnlineSessionSearchResult& SessionResult)
+{
+	JoinPipelineSessionName = SessionName;
+	JoinTimings = FMultiplayerJoinTimings();
+	JoinTimings.RequestedTime = FPlatformTime::Seconds();
+
+	// the connect string of a search result is known before we've joined, on most online subsystems
+	JoinConnectAddress.Reset();
+	if (ResolveConnectString(SessionResult, JoinConnectAddress))
+	{
+		JoinTimings.AddressResolvedTime = FPlatformTime::Seconds();
+	}
+	else
+	{
+		JoinConnectAddress.Reset();
+	}
+
+	// hosts advertise their map, stream it in so ClientTravel doesn't have to load it from scratch
+	FString MapName;
+	if (MultiplayerSessionAttributes::GetString(SessionResult.Session.SessionSettings, EMultiplayerSessionAttribute::MapName, MapName) && !MapName.IsEmpty())
+	{
+		JoinTimings.MapLoadStartedTime = FPlatformTime::Seconds();
+		PreloadMap(MapName, FLoadPackageAsyncDelegate::CreateUObject(this, &ThisClass::OnJoinMapLoaded));
+	}
+}
+void UMultiplayerSessionsSubsystem::OnJoinMapLoaded(const FName& PackageName, UPackage* LoadedPackage, EAsyncLoadingResult::Type Result)
+{
+	JoinTimings.MapLoadedTime = FPlatformTime::Seconds();
+
+	// if travel beat us to it the map is loaded already and there's nothing left to keep alive
+	if(!PostLoadMapHandle.IsValid()) { return; }
+
+	PreloadedMapPackage = Result == EAsyncLoadingResult::Succeeded ? LoadedPackage : nullptr;
+}
+bool UMultiplayerSessionsSubsystem::ClientTravelToSession()
+{
+	const UGameInstance* GameInstance = GetGameInstance();
+	APlayerController* PlayerController = GameInstance ? GameInstance->GetFirstLocalPlayerController() : nullptr;
+
+	if(!PlayerController || JoinConnectAddress.IsEmpty()) { return false; }
+
+	JoinTimings.TravelStartedTime = FPlatformTime::Seconds();
+	PlayerController->ClientTravel(JoinConnectAddress, TRAVEL_Absolute);
+
+	return true;
+}
+FString UMultiplayerSessionsSubsystem::PreloadMap(const FString& MapPath, FLoadPackageAsyncDelegate OnLoaded)
+{
+	const FString PackageName = ToMapPackageName(MapPath);
+
+	// the reference to the loaded package is dropped once the next map has loaded
+	if (!PostLoadMapHandle.IsValid())
+	{
+		PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &ThisClass::OnPostLoadMapWithWorld);
+	}
+	LoadPackageAsync(PackageName, MoveTemp(OnLoaded));
+
+	return PackageName;
+}
+void UMultiplayerSessionsSubsystem::OnLobbyPackageLoaded(const FName& PackageName, UPackage* LoadedPackage, EAsyncLoadingResult::Type Result)
+{
+	// a lobby preloaded by an earlier HostSession() call can finish after this pipeline started
+	if(!HostPipeline.bActive || PackageName != HostPipeline.LobbyPackage) { return; }
+
+	// keep the map in memory until the travel has picked it up. If the load failed travel simply loads it itself
+	PreloadedMapPackage = Result == EAsyncLoadingResult::Succeeded ? LoadedPackage : nullptr;
+
+	HostPipeline.bMapLoaded = true;
+	AdvanceHostPipeline();
+}
+void UMultiplayerSessionsSubsystem::AdvanceHostPipeline()
+{
+	if(!HostPipeline.bActive || HostPipeline.bStarting) { return; }
+	if(!HostPipeline.bSessionCreated || !HostPipeline.bMapLoaded) { return; }
+
+	HostPipeline.bStarting = true;
+	StartSession(HostPipeline.SessionName);
+}
+void UMultiplayerSessionsSubsystem::OnPostLoadMapWithWorld(UWorld* LoadedWorld)
+{
+	ReleasePreloadedMap();
+}
+void UMultiplayerSessionsSubsystem::ReleasePreloadedMap()
+{
+	PreloadedMapPackage = nullptr;
+
+	if(PostLoadMapHandle.IsValid())
+	{
+		FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+		PostLoadMapHandle.Reset();
+	}
+}
+FMultiplayerSessionMetrics UMultiplayerSessionsSubsystem::GetSessionMetrics() const
+{
+	FMultiplayerSessionMetrics Snapshot = Metrics;
+
+	// the current search is usually one of the cached ones, don't count it twice
+	Snapshot.SearchBytesRetained = SearchCache.GetAllocatedSize() + SearchIndex.GetAllocatedSize() + RankedCandidates.GetAllocatedSize();
+	if (LastSessionSearch.IsValid() && !SearchCache.Contains(LastSessionSearch))
+	{
+		Snapshot.SearchBytesRetained += FMultiplayerSessionMetrics::GetSearchAllocatedSize(*LastSessionSearch);
+	}
+	if (SearchCacheRefresh.IsValid())
+	{
+		Snapshot.SearchBytesRetained += FMultiplayerSessionMetrics::GetSearchAllocatedSize(*SearchCacheRefresh);
+	}
+
+	return Snapshot;
+}
+FUniqueNetIdPtr UMultiplayerSessionsSubsystem::GetLocalUserId() const
+{
+	if(LocalUserIdOverride.IsValid()) { return LocalUserIdOverride; }
+
+	const UWorld* World = GetWorld();
+	const ULocalPlayer* LocalPlayer = World ? World->GetFirstLocalPlayerFromController() : nullptr;
+
+	return LocalPlayer ? LocalPlayer->GetPreferredUniqueNetId().GetUniqueNetId() : nullptr;
+}
+bool UMultiplayerSessionsSubsystem::TickIncrementalSearch(float DeltaTime)
+{
+	if(!bIncrementalSearch || !LastSessionSearch.IsValid())
+	{
+		SearchPollHandle.Reset();
+		return false;
+	}
+
+	DeliverSearchPages(false);
+
+	// keep polling until OnFindSessionsComplete (or a cancel) stops us
+	return bIncrementalSearch;
+}
+void UMultiplayerSessionsSubsystem::DeliverSearchPages(bool bSearchFinished)
+{
+	// hold a reference so a listener starting a new search can't free the array we are handing out views into
+	const TSharedPtr<FOnlineSessionSearch> Search = LastSessionSearch;
+	if(!Search.IsValid()) { return; }
+
+	const TArray<FOnlineSessionSearchResult>& Results = Search->SearchResults;
+	const int32 PageSize = FMath::Max(SearchPageSize, 1);
+
+	// everything that has arrived so far is indexed before any of it is handed out
+	IndexSearchResults();
+
+	// a listener may cancel the search (e.g. by joining) or start a new one from inside the broadcast, both end the loop
+	while (bIncrementalSearch && Search == LastSessionSearch && NumSearchResultsDelivered < Results.Num())
+	{
+		const int32 NumPending = Results.Num() - NumSearchResultsDelivered;
+
+		// wait for a full page unless there is nothing more to come
+		if (NumPending < PageSize && !bSearchFinished) { return; }
+
+		const int32 NumInPage = FMath::Min(NumPending, PageSize);
+		const TArrayView<const FOnlineSessionSearchResult> Page(Results.GetData() + NumSearchResultsDelivered, NumInPage);
+		NumSearchResultsDelivered += NumInPage;
+
+		const bool bIsLastPage = bSearchFinished && NumSearchResultsDelivered == Results.Num();
+		if (bIsLastPage)
+		{
+			// search is over before listeners hear about it, so they are free to start another one
+			bIncrementalSearch = false;
+		}
+		
+		BroadcastSearchPage(Page, bIsLastPage);
+	}
+
+	// search finished with nothing left over (or with no results at all) - still let listeners know it's over
+	if (bSearchFinished && bIncrementalSearch && Search == LastSessionSearch)
+	{
+		bIncrementalSearch = false;
+		BroadcastSearchPage(TArrayView<const FOnlineSessionSearchResult>(), true);
+	}
+}
+void UMultiplayerSessionsSubsystem::BroadcastSearchPage(TArrayView<const FOnlineSessionSearchResult> Page, bool bIsLastPage)
+{
+	if (IsHostMigrationActive())
+	{
+		OnHostMigrationSearchPage(bIsLastPage);
+		return;
+	}
+
+	if (IsQuickMatchActive())
+	{
+		OnQuickMatchSearchPage(bIsLastPage);
+		return;
+	}
+
+	MultiplayerOnFindSessionsPage.Broadcast(Page, bIsLastPage);
+}
+void UMultiplayerSessionsSubsystem::IndexSearchResults()
+{
+	if(!LastSessionSearch.IsValid()) { return; }
+
+	const TArray<FOnlineSessionSearchResult>& Results = LastSessionSearch->SearchResults;
+	if(NumSearchResultsIndexed >= Results.Num()) { return; }
+
+	SearchIndex.Append(TArrayView<const FOnlineSessionSearchResult>(Results).Slice(NumSearchResultsIndexed, Results.Num() - NumSearchResultsIndexed), NumSearchResultsIndexed);
+	NumSearchResultsIndexed = Results.Num();
+}
+const FOnlineSessionSearchResult* UMultiplayerSessionsSubsystem::FindSearchResult(uint32 MatchKey) const
+{
+	if(!LastSessionSearch.IsValid()) { return nullptr; }
+
+	const int32 ResultIndex = SearchIndex.FindFirst(MatchKey);
+	return LastSessionSearch->SearchResults.IsValidIndex(ResultIndex) ? &LastSessionSearch->SearchResults[ResultIndex] : nullptr;
+}
+const FOnlineSessionSearchResult* UMultiplayerSessionsSubsystem::GetSearchResult(int32 ResultIndex) const
+{
+	return LastSessionSearch.IsValid() && LastSessionSearch->SearchResults.IsValidIndex(ResultIndex) ? &LastSessionSearch->SearchResults[ResultIndex] : nullptr;
+}
+void UMultiplayerSessionsSubsystem::RankSessions(uint32 MatchKey)
+{
+	// ranking works on what we have so far, stop an incremental search so the results array can't change under us.
+	// A plain FindSessions() keeps going, its caller is still waiting for the completion
+	const bool bWasIncremental = bIncrementalSearch;
+	CancelFindSessions();
+	IndexSearchResults();
+
+	// the online service may take a while to wind a cancelled search down and keeps it in progress until then. Take the
+	// results over into a search of our own, nothing appends to that one and the result indices stay the same
+	if (bWasIncremental && LastSessionSearch.IsValid() && LastSessionSearch->SearchState == EOnlineAsyncTaskState::InProgress)
+	{
+		const TSharedRef<FOnlineSessionSearch> Detached = MakeSessionSearch(LastMaxSearchResults, LastSearchFilter);
+		Detached->SearchResults = MoveTemp(LastSessionSearch->SearchResults);
+		Detached->SearchState = EOnlineAsyncTaskState::Done;
+		LastSessionSearch = Detached;
+	}
+
+	// a newer call supersedes any ranking that is still being scored or waiting for pings
+	ResetRanking();
+
+	TArray<int32> ResultIndices;
+	if(LastSessionSearch.IsValid())
+	{
+		SearchIndex.ForEach(MatchKey, [&ResultIndices](int32 ResultIndex) { ResultIndices.Add(ResultIndex); });
+	}
+
+	// a host that has just turned us down would most likely do so again
+	TSet<FString> ExcludedSessionIds;
+	for (const TPair<FString, double>& RejectedHost : RejectedHosts)
+	{
+		if(IsHostRecentlyRejected(RejectedHost.Key)) { ExcludedSessionIds.Add(RejectedHost.Key); }
+	}
+
+	// pre-rank with the latency reported by the online service, then measure the most promising ones ourselves
+	const int32 MaxCandidates = FMath::Max(MaxRankedCandidates, MaxCandidatesToPing);
+
+	// the online service may still append to the results of a search in progress, only the game thread may read them then
+	const bool bSearchInProgress = LastSessionSearch.IsValid() && LastSessionSearch->SearchState == EOnlineAsyncTaskState::InProgress;
+
+	const int32 Threshold = FMath::Clamp(AsyncRankingThreshold, 1, FMath::Max(MaxSearchResultsInFlight / 4, 1));
+
+	if (bSearchInProgress || ResultIndices.Num() < Threshold)
+	{
+		TArrayView<const FOnlineSessionSearchResult> Results;
+		if(LastSessionSearch.IsValid()) { Results = LastSessionSearch->SearchResults; }
+
+		MultiplayerSessionRanking::SelectTopCandidates(Results, ResultIndices, ExcludedSessionIds, RankingWeights, MaxCandidates, RankedCandidates);
+		RankedSearch = LastSessionSearch;
+		PingRankedCandidates();
+		return;
+	}
+
+	// the task keeps the search alive, it's over so its results don't change anymore
+	Async(EAsyncExecution::TaskGraph, [WeakThis = TWeakObjectPtr<ThisClass>(this), Serial = RankingSerial, Search = LastSessionSearch.ToSharedRef(),
+		ResultIndices = MoveTemp(ResultIndices), ExcludedSessionIds = MoveTemp(ExcludedSessionIds), Weights = RankingWeights, MaxCandidates]()
+	{
+		TArray<FMultiplayerSessionCandidate> Candidates;
+		MultiplayerSessionRanking::SelectTopCandidates(Search->SearchResults, ResultIndices, ExcludedSessionIds, Weights, MaxCandidates, Candidates);
+
+		// only the best few go back to the game thread
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, Serial, Search, Candidates = MoveTemp(Candidates)]() mutable
+		{
+			ThisClass* This = WeakThis.Get();
+			if(!This || This->RankingSerial != Serial || This->LastSessionSearch.Get() != &Search.Get()) { return; }
+
+			This->RankedCandidates = MoveTemp(Candidates);
+			This->RankedSearch = Search;
+			This->PingRankedCandidates();
+		});
+	});
+}
+void UMultiplayerSessionsSubsystem::ResetRanking()
+{
+	// pings and scoring tasks that are still out are ignored once the serial has moved on
+	++RankingSerial;
+	NumPingsOutstanding = 0;
+	RankedCandidates.Reset();
+	RankedSearch.Reset();
+}
+void UMultiplayerSessionsSubsystem::PingRankedCandidates()
+{
+	const int32 NumToPing = SessionInterface.IsValid() ? FMath::Min(RankedCandidates.Num(), MaxCandidatesToPing) : 0;
+
+	// collect the addresses first, a reply can't arrive before every ping has been sent
+	TArray<TPair<int32, FString>> PingTargets;
+	for (int32 CandidateIndex = 0; CandidateIndex < NumToPing; ++CandidateIndex)
+	{
+		FString ConnectString;
+		FString Address;
+		const FOnlineSessionSearchResult& Result = LastSessionSearch->SearchResults[RankedCandidates[CandidateIndex].ResultIndex];
+
+		// P2P connect strings (e.g. "steam.<id>") have no address we could ping
+		if (ResolveConnectString(Result, ConnectString) &&
+			ConnectString.Split(TEXT(":"), &Address, nullptr, ESearchCase::CaseSensitive, ESearchDir::FromEnd))
+		{
+			PingTargets.Emplace(CandidateIndex, MoveTemp(Address));
+		}
+	}
+
+	if (PingTargets.Num() == 0)
+	{
+		FinishRanking();
+		return;
+	}
+
+	// issue every ping at once, replies come back on the game thread
+	NumPingsOutstanding = PingTargets.Num();
+	const uint32 Serial = RankingSerial;
+
+	for (const TPair<int32, FString>& Target : PingTargets)
+	{
+		FIcmp::IcmpEcho(Target.Value, PingTimeout, [WeakThis = TWeakObjectPtr<ThisClass>(this), Serial, CandidateIndex = Target.Key](FIcmpEchoResult EchoResult)
+		{
+			ThisClass* This = WeakThis.Get();
+			if (!This || This->RankingSerial != Serial) { return; }
+
+			// a host that didn't answer keeps the latency the online service reported for it
+			if (EchoResult.Status == EIcmpResponseStatus::Success)
+			{
+				This->RankedCandidates[CandidateIndex].PingInMs = FMath::RoundToInt(EchoResult.Time * 1000.f);
+			}
+
+			if (--This->NumPingsOutstanding == 0)
+			{
+				This->FinishRanking();
+			}
+		});
+	}
+}
+void UMultiplayerSessionsSubsystem::FinishRanking()
+{
+	MultiplayerSessionRanking::RankCandidates(RankedCandidates, RankingWeights);
+
+	if (IsQuickMatchActive())
+	{
+		OnQuickMatchRanked();
+		return;
+	}
+
+	MultiplayerOnSessionsRanked.Broadcast(RankedCandidates);
+}
+TSharedPtr<const FOnlineSessionSearchResult> UMultiplayerSessionsSubsystem::ShareSearchResult(const FOnlineSessionSearchResult& SessionResult) const
+{
+	// a result of the last search is shared in place, the reference keeps the whole search alive. A search that is
+	// still running may reallocate its results, so those (and results from anywhere else) are copied
+	if (LastSessionSearch.IsValid() && LastSessionSearch->SearchState != EOnlineAsyncTaskState::InProgress)
+	{
+		const TArray<FOnlineSessionSearchResult>& Results = LastSessionSearch->SearchResults;
+		if (Results.Num() > 0 && &SessionResult >= Results.GetData() && &SessionResult < Results.GetData() + Results.Num())
+		{
+			return TSharedPtr<const FOnlineSessionSearchResult>(LastSessionSearch, &SessionResult);
+		}
+	}
+
+	return MakeShared<const FOnlineSessionSearchResult>(SessionResult);
+}
+TSharedRef<FOnlineSessionSearch> UMultiplayerSessionsSubsystem::MakeSessionSearch(int32 MaxSearchResults, const FMultiplayerSessionSearchFilter& Filter)
+{
+	TSharedRef<FOnlineSessionSearch> Search = ObjectPool.AcquireSearch();
+
+	Search->MaxSearchResults = MaxSearchResults;
+	Search->bIsLanQuery = bLANSubsystem;
+
+	// player hosted sessions are presence lobbies, dedicated servers aren't
+	if (!Filter.bDedicatedServers)
+	{
+		Search->QuerySettings.Set(SEARCH_PRESENCE, true, EOnlineComparisonOp::Equals);
+	}
+
+	// let the online service do the filtering
+	Filter.ApplyTo(*Search);
+
+	return Search;
+}
+bool UMultiplayerSessionsSubsystem::ServeSearchFromCache(int32 MaxSearchResults, const FMultiplayerSessionSearchFilter& Filter)
+{
+	const TSharedPtr<FOnlineSessionSearch> CachedSearch = SearchCache.Find(Filter, MaxSearchResults, FPlatformTime::Seconds());
+	if(!CachedSearch.IsValid()) { return false; }
+
+	LastSessionSearch = CachedSearch;
+	LastSearchFilter = Filter;
+	LastMaxSearchResults = MaxSearchResults;
+	ResetRanking();
+
+	SearchIndex.Reset(Filter, GetOldestLiveHeartbeat());
+	NumSearchResultsIndexed = 0;
+	IndexSearchResults();
+
+	return true;
+}
+bool UMultiplayerSessionsSubsystem::TickSearchCache(float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+	SearchCache.RemoveStale(Now);
+
+	// never compete with a search somebody is actually waiting for
+	const bool bSearchInFlight = LastSessionSearch.IsValid() && LastSessionSearch->SearchState == EOnlineAsyncTaskState::InProgress;
+	if(SearchCacheRefresh.IsValid() || bSearchInFlight || !SessionInterface.IsValid()) { return true; }
+
+	const FMultiplayerSessionSearchCache::FEntry* Entry = SearchCache.FindEntryToRefresh(Now, SearchCacheRefreshInterval);
+	const FUniqueNetIdPtr LocalUserId = GetLocalUserId();
+	if(!Entry || !LocalUserId.IsValid()) { return true; }
+
+	SearchCacheRefresh = MakeSessionSearch(Entry->MaxSearchResults, Entry->Filter);
+	SearchCacheRefreshFilter = Entry->Filter;
+	SearchCacheRefreshMaxResults = Entry->MaxSearchResults;
+
+	SearchCacheRefreshDelegateHandle = SessionInterface->AddOnFindSessionsCompleteDelegate_Handle(SearchCacheRefreshCompleteDelegate);
+	SearchCacheRefreshStartTime = FPlatformTime::Seconds();
+
+	if(!SessionInterface->FindSessions(*LocalUserId, SearchCacheRefresh.ToSharedRef()))
+	{
+		Metrics.RecordOutcome(EMultiplayerSessionMetricOp::Find, EMultiplayerSessionOpOutcome::Failure);
+		SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(SearchCacheRefreshDelegateHandle);
+		SearchCacheRefresh.Reset();
+	}
+
+	return true;
+}
+void UMultiplayerSessionsSubsystem::CancelSearchCacheRefresh()
+{
+	if(!SearchCacheRefresh.IsValid()) { return; }
+
+	if(SessionInterface.IsValid())
+	{
+		SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(SearchCacheRefreshDelegateHandle);
+
+		if(SearchCacheRefresh->SearchState == EOnlineAsyncTaskState::InProgress)
+		{
+			SessionInterface->CancelFindSessions();
+			Metrics.RecordOutcome(EMultiplayerSessionMetricOp::Find, EMultiplayerSessionOpOutcome::Cancelled);
+		}
+	}
+
+	SearchCacheRefresh.Reset();
+}
+void UMultiplayerSessionsSubsystem::OnSearchCacheRefreshComplete(bool bWasSuccessful)
+{
+	if(SessionInterface)
+	{
+		SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle(SearchCacheRefreshDelegateHandle);
+	}
+
+	// a refresh is a search like any other as far as the online service is concerned
+	Metrics.RecordCompletion(EMultiplayerSessionMetricOp::Find, bWasSuccessful ? EMultiplayerSessionOpOutcome::Success : EMultiplayerSessionOpOutcome::Failure,
+		SearchCacheRefreshStartTime, FPlatformTime::Seconds());
+	if (SearchCacheRefresh.IsValid())
+	{
+		Metrics.RecordSearchResults(SearchCacheRefresh->SearchResults.Num());
+	}
+
+	// a failed refresh keeps the old results until they expire
+	if(bWasSuccessful && SearchCacheRefresh.IsValid() && SearchCacheRefresh->SearchResults.Num() > 0)
+	{
+		SearchCache.Store(SearchCacheRefreshFilter, SearchCacheRefreshMaxResults, SearchCacheRefresh.ToSharedRef(), FPlatformTime::Seconds());
+	}
+
+	SearchCacheRefresh.Reset();
+}
+void UMultiplayerSessionsSubsystem::StopSearchPolling()
+{
+	if(SearchPollHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(SearchPollHandle);
+		SearchPollHandle.Reset();
+	}
+}
+
+/* JOIN FAILOVER
+ * ====================================================================================================================
+ *
+ *	JoinRankedSessions() keeps the ranked candidates of the last search and works through them best first. A host
+ *	that turns the join down is remembered for a while and left out of later rankings, the next candidate is tried
+ *	after a backoff that doubles with every attempt. Listeners only hear about the join that finally succeeded, or
+ *	the last failure once candidates or attempts have run out.
+ *
+ * ====================================================================================================================
+ */
+bool UMultiplayerSessionsSubsystem::JoinRankedSessions(FName SessionName, int32 PartySize)
+{
+	StopJoinFailover();
+
+	// candidates ranked from another search would point at the wrong results
+	if(!LastSessionSearch.IsValid() || RankedSearch.Pin() != LastSessionSearch) { return false; }
+
+	JoinFailover.SessionName = SessionName;
+	JoinFailover.PartySize = FMath::Max(PartySize, 1);
+	JoinFailover.Search = LastSessionSearch;
+	JoinFailover.ResultIndices.Reserve(RankedCandidates.Num());
+	for (const FMultiplayerSessionCandidate& Candidate : RankedCandidates)
+	{
+		JoinFailover.ResultIndices.Add(Candidate.ResultIndex);
+	}
+	JoinFailover.bActive = true;
+
+	// the first join may already have completed (and ended the failover) when this returns
+	if (!JoinNextCandidate())
+	{
+		StopJoinFailover();
+		return false;
+	}
+
+	return true;
+}
+bool UMultiplayerSessionsSubsystem::IsHostRecentlyRejected(const FString& SessionId) const
+{
+	const double* RejectedUntil = RejectedHosts.Find(SessionId);
+	return RejectedUntil && *RejectedUntil > FPlatformTime::Seconds();
+}
+bool UMultiplayerSessionsSubsystem::JoinNextCandidate()
+{
+	const TArray<FOnlineSessionSearchResult>& Results = JoinFailover.Search->SearchResults;
+
+	while (JoinFailover.NextCandidate < JoinFailover.ResultIndices.Num() && JoinFailover.NumAttempts < FMath::Max(MaxJoinAttempts, 1))
+	{
+		// the failover holds the very search the candidates were ranked from, their indices are always in range
+		const int32 ResultIndex = JoinFailover.ResultIndices[JoinFailover.NextCandidate++];
+		if(!ensure(Results.IsValidIndex(ResultIndex))) { continue; }
+
+		const FOnlineSessionSearchResult& Result = Results[ResultIndex];
+		if(!HasRoomForParty(Result.Session, JoinFailover.PartySize)) { continue; }
+
+		// a candidate further down may share its host with one that has turned us down already
+		FString SessionId = Result.GetSessionIdStr();
+		if(IsHostRecentlyRejected(SessionId)) { continue; }
+
+		++JoinFailover.NumAttempts;
+		JoinFailover.CurrentSessionId = MoveTemp(SessionId);
+
+		SendJoinSession(JoinFailover.SessionName, Result, JoinFailover.PartySize);
+		return true;
+	}
+
+	return false;
+}
+bool UMultiplayerSessionsSubsystem::ContinueJoinFailover(bool bWasSuccessful, EOnJoinSessionCompleteResult::Type JoinResult)
+{
+	if (bWasSuccessful)
+	{
+		StopJoinFailover();
+		return false;
+	}
+
+	switch (JoinResult)
+	{
+	case EOnJoinSessionCompleteResult::SessionIsFull:
+	case EOnJoinSessionCompleteResult::SessionDoesNotExist:
+	case EOnJoinSessionCompleteResult::CouldNotRetrieveAddress:
+		RememberRejectedHost(JoinFailover.CurrentSessionId);
+		break;
+	case EOnJoinSessionCompleteResult::AlreadyInSession:
+		// our own problem, another host won't change that
+		StopJoinFailover();
+		return false;
+	default:
+		break;
+	}
+
+	JoinFailover.LastResult = JoinResult;
+
+	const bool bCandidatesLeft = JoinFailover.NextCandidate < JoinFailover.ResultIndices.Num() && JoinFailover.NumAttempts < FMath::Max(MaxJoinAttempts, 1);
+	if (!bCandidatesLeft)
+	{
+		Metrics.RecordJoinFailover(true);
+		StopJoinFailover();
+		return false;
+	}
+
+	// don't hammer the online service when several hosts fail in a row, e.g. because our connection is the problem
+	const float Delay = FMath::Min(JoinRetryBaseDelay * FMath::Pow(2.f, static_cast<float>(JoinFailover.NumAttempts - 1)), JoinRetryMaxDelay);
+	JoinFailover.RetryHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateUObject(this, &ThisClass::OnJoinRetryDue), FMath::Max(Delay, 0.f));
+
+	Metrics.RecordJoinFailover(false);
+	return true;
+}
+bool UMultiplayerSessionsSubsystem::OnJoinRetryDue(float DeltaTime)
+{
+	JoinFailover.RetryHandle.Reset();
+
+	if (!JoinNextCandidate())
+	{
+		// the remaining candidates have all turned us down in the meantime, report the failure we've held back
+		const FName SessionName = JoinFailover.SessionName;
+		const EOnJoinSessionCompleteResult::Type LastResult = JoinFailover.LastResult;
+
+		Metrics.RecordJoinFailover(true);
+		StopJoinFailover();
+		BroadcastSessionOpResult(SessionName, EMultiplayerSessionOpType::Join, false, LastResult);
+	}
+
+	return false;
+}
+void UMultiplayerSessionsSubsystem::StopJoinFailover()
+{
+	if(JoinFailover.RetryHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(JoinFailover.RetryHandle);
+	}
+
+	JoinFailover = FJoinFailover();
+}
+void UMultiplayerSessionsSubsystem::RememberRejectedHost(const FString& SessionId)
+{
+	if(SessionId.IsEmpty()) { return; }
+
+	const double Now = FPlatformTime::Seconds();
+	for (auto It = RejectedHosts.CreateIterator(); It; ++It)
+	{
+		if(It->Value <= Now) { It.RemoveCurrent(); }
+	}
+
+	RejectedHosts.Add(SessionId, Now + RejectedHostCooldown);
+}
+
+/* QUICK MATCH
+ * ====================================================================================================================
+ *
+ *	Search for a session of the match type and join the best ranked one. If nothing has turned up by the deadline,
+ *	or the search comes back empty, host through HostSession() instead.
+ *
+ *	Two players that both find nothing at the same moment would each host and sit in a lobby of one. So once our
+ *	session is ready we search once more for a short while. Every host that sees the session of another quick
+ *	match host (see EMultiplayerSessionAttribute::QuickMatch) of the same match type with a lower session id (compared
+ *	case sensitively, so every client agrees) and free slots leaves its own session and joins that one, as long as
+ *	nobody has joined it yet. The host with the lowest id never leaves, so everyone
+ *	who hosted concurrently ends up in the same lobby.
+ *
+ *	The menu delegates stay quiet while a quick match is running, BroadcastSearchPage(), FinishRanking(),
+ *	BroadcastSessionOpResult() and BroadcastHostReady() route everything here instead.
+ *
+ * ====================================================================================================================
+ */
+void UMultiplayerSessionsSubsystem::QuickMatch(int32 NumPublicConnections, FString MatchType, const FString& LobbyPath)
+{
+	CancelQuickMatch();
+
+	QuickMatchState = FQuickMatchState();
+	QuickMatchState.NumPublicConnections = NumPublicConnections;
+	QuickMatchState.MatchType = MatchType;
+	QuickMatchState.LobbyPath = LobbyPath;
+	QuickMatchState.MatchKey = FMultiplayerSessionSearchIndex::MakeMatchKey(MatchType);
+
+	QuickMatchSearch(EQuickMatchStage::Searching, QuickMatchSearchDeadline);
+}
+void UMultiplayerSessionsSubsystem::CancelQuickMatch()
+{
+	switch (QuickMatchState.Stage)
+	{
+	case EQuickMatchStage::None:
+		return;
+	case EQuickMatchStage::Searching:
+	case EQuickMatchStage::Merging:
+		CancelFindSessions();
+		break;
+	case EQuickMatchStage::Ranking:
+		// pings that are still out are ignored once the serial has moved on
+		++RankingSerial;
+		break;
+	case EQuickMatchStage::Hosting:
+		// the session is still created, but nobody travels into it
+		HostPipeline.bActive = false;
+		break;
+	default:
+		break;
+	}
+
+	FinishQuickMatch(EMultiplayerQuickMatchResult::Cancelled);
+}
+void UMultiplayerSessionsSubsystem::QuickMatchSearch(EQuickMatchStage Stage, float Deadline)
+{
+	// a search answered from the cache (or failing right away) reports back from inside FindSessionsIncremental()
+	QuickMatchState.Stage = Stage;
+
+	ClearQuickMatchDeadline();
+	QuickMatchState.DeadlineHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateUObject(this, &ThisClass::OnQuickMatchDeadline), FMath::Max(Deadline, 0.f));
+
+	FMultiplayerSessionSearchFilter Filter;
+	Filter.MatchType = QuickMatchState.MatchType;
+
+	FindSessionsIncremental(QuickMatchMaxSearchResults, Filter);
+}
+void UMultiplayerSessionsSubsystem::QuickMatchHost()
+{
+	ClearQuickMatchDeadline();
+	CancelFindSessions();
+
+	QuickMatchState.Stage = EQuickMatchStage::Hosting;
+	HostSession(QuickMatchState.NumPublicConnections, QuickMatchState.MatchType, QuickMatchState.LobbyPath);
+}
+void UMultiplayerSessionsSubsystem::OnQuickMatchSearchPage(bool bIsLastPage)
+{
+	if (QuickMatchState.Stage == EQuickMatchStage::Searching)
+	{
+		// join as soon as there is anything to join, RankSessions() stops the search
+		if (FindSearchResult(QuickMatchState.MatchKey))
+		{
+			ClearQuickMatchDeadline();
+			QuickMatchState.Stage = EQuickMatchStage::Ranking;
+			RankSessions(QuickMatchState.MatchKey);
+		}
+		else if (bIsLastPage)
+		{
+			QuickMatchHost();
+		}
+	}
+	else if (QuickMatchState.Stage == EQuickMatchStage::Merging && bIsLastPage)
+	{
+		ResolveQuickMatchMerge();
+	}
+}
+void UMultiplayerSessionsSubsystem::OnQuickMatchRanked()
+{
+	if(QuickMatchState.Stage != EQuickMatchStage::Ranking) { return; }
+
+	// the candidates are tried best first, OnQuickMatchJoined() only hears about the last one
+	QuickMatchState.Stage = EQuickMatchStage::Joining;
+	if (!JoinRankedSessions(NAME_GameSession))
+	{
+		// every candidate was rejected (e.g. full)
+		QuickMatchHost();
+	}
+}
+void UMultiplayerSessionsSubsystem::OnQuickMatchJoined(bool bWasSuccessful)
+{
+	if(QuickMatchState.Stage != EQuickMatchStage::Joining && QuickMatchState.Stage != EQuickMatchStage::MergeJoining) { return; }
+
+	if (bWasSuccessful)
+	{
+		FinishQuickMatch(EMultiplayerQuickMatchResult::Joined);
+		return;
+	}
+
+	// nobody would have us, host ourselves instead. If we've just left our own session for a merge, the new one doesn't try to merge again
+	QuickMatchHost();
+}
+void UMultiplayerSessionsSubsystem::OnQuickMatchHostReady(bool bWasSuccessful)
+{
+	if(QuickMatchState.Stage != EQuickMatchStage::Hosting) { return; }
+
+	if (!bWasSuccessful)
+	{
+		FinishQuickMatch(EMultiplayerQuickMatchResult::Failed);
+		return;
+	}
+
+	const FNamedOnlineSession* OwnSession = SessionInterface.IsValid() ? SessionInterface->GetNamedSession(NAME_GameSession) : nullptr;
+	if (QuickMatchMergeWindow <= 0.f || QuickMatchState.bMergeAttempted || !OwnSession)
+	{
+		FinishQuickMatch(EMultiplayerQuickMatchResult::Hosted);
+		return;
+	}
+
+	QuickMatchState.OpenSlotsWhenHosted = OwnSession->NumOpenPublicConnections;
+
+	// cached results are from before we hosted and can't contain anybody who hosted at the same time as us
+	SearchCache.Invalidate();
+	QuickMatchSearch(EQuickMatchStage::Merging, QuickMatchMergeWindow);
+}
+bool UMultiplayerSessionsSubsystem::OnQuickMatchDeadline(float DeltaTime)
+{
+	QuickMatchState.DeadlineHandle.Reset();
+
+	if (QuickMatchState.Stage == EQuickMatchStage::Searching)
+	{
+		// the search is still running, take what has arrived so far or give up on finding anything
+		if (FindSearchResult(QuickMatchState.MatchKey))
+		{
+			QuickMatchState.Stage = EQuickMatchStage::Ranking;
+			RankSessions(QuickMatchState.MatchKey);
+		}
+		else
+		{
+			QuickMatchHost();
+		}
+	}
+	else if (QuickMatchState.Stage == EQuickMatchStage::Merging)
+	{
+		ResolveQuickMatchMerge();
+	}
+
+	return false;
+}
+void UMultiplayerSessionsSubsystem::ResolveQuickMatchMerge()
+{
+	ClearQuickMatchDeadline();
+	CancelFindSessions();
+
+	const FOnlineSessionSearchResult* Target = FindQuickMatchMergeTarget();
+	if (!Target)
+	{
+		FinishQuickMatch(EMultiplayerQuickMatchResult::Hosted);
+		return;
+	}
+
+	QuickMatchState.Stage = EQuickMatchStage::MergeJoining;
+	QuickMatchState.bMergeAttempted = true;
+
+	// our own session is destroyed first, the join waits behind that in the session queue
+	JoinSession(NAME_GameSession, *Target);
+}
+const FOnlineSessionSearchResult* UMultiplayerSessionsSubsystem::FindQuickMatchMergeTarget() const
+{
+	const FNamedOnlineSession* OwnSession = SessionInterface.IsValid() ? SessionInterface->GetNamedSession(NAME_GameSession) : nullptr;
+	if(!OwnSession || !LastSessionSearch.IsValid()) { return nullptr; }
+
+	// somebody has joined us already, leaving would strand them
+	if(OwnSession->NumOpenPublicConnections < QuickMatchState.OpenSlotsWhenHosted) { return nullptr; }
+
+	// our own session may be among the results, it never compares lower than itself
+	const FOnlineSessionSearchResult* Target = nullptr;
+	FString TargetId = OwnSession->GetSessionIdStr();
+
+	SearchIndex.ForEach(QuickMatchState.MatchKey, [this, &Target, &TargetId](int32 ResultIndex)
+	{
+		const FOnlineSessionSearchResult& Result = LastSessionSearch->SearchResults[ResultIndex];
+		if(Result.Session.NumOpenPublicConnections <= 0) { return; }
+
+		// only other quick match hosts run this same tie-break, a lobby somebody hosted on purpose stays put
+		uint32 HostedByQuickMatch = 0;
+		if(!MultiplayerSessionAttributes::GetInt(Result.Session.SessionSettings, EMultiplayerSessionAttribute::QuickMatch, HostedByQuickMatch) || !HostedByQuickMatch) { return; }
+
+		FString SessionId = Result.GetSessionIdStr();
+		if (SessionId.Compare(TargetId, ESearchCase::CaseSensitive) < 0)
+		{
+			Target = &Result;
+			TargetId = MoveTemp(SessionId);
+		}
+	});
+
+	return Target;
+}
+void UMultiplayerSessionsSubsystem::FinishQuickMatch(EMultiplayerQuickMatchResult Result)
+{
+	ClearQuickMatchDeadline();
+
+	// listeners are free to start the next quick match from inside the broadcast
+	QuickMatchState.Stage = EQuickMatchStage::None;
+	MultiplayerOnQuickMatchComplete.Broadcast(Result);
+}
+void UMultiplayerSessionsSubsystem::ClearQuickMatchDeadline()
+{
+	if(QuickMatchState.DeadlineHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(QuickMatchState.DeadlineHandle);
+		QuickMatchState.DeadlineHandle.Reset();
+	}
+}
+
+/* LAN BEACON
+ * ====================================================================================================================
+ *
+ *	With bUseLANBeacon on the NULL online subsystem, every process runs a FMultiplayerSessionLANBeacon. A process
+ *	that hosts a LAN session announces it a few times a second and every process keeps a table of the hosts it hears.
+ *	Searches are answered from that table on the spot instead of broadcasting a query and waiting for it to time out.
+ *	Until the beacon has listened for a whole host timeout, or while it hasn't heard anybody, searches still broadcast.
+ *
+ *	The NULL subsystem can't join a session it hasn't found itself, and it doesn't need to: on a LAN all a join gives
+ *	us is the host's address, which the beacon already told us. So the ops of a session joined through the beacon
+ *	complete locally, right away, and ClientTravelToSession() goes straight to the announced address. Hosts still
+ *	create their sessions with the NULL subsystem, clients without the beacon find them the usual way.
+ *
+ * ====================================================================================================================
+ */
+void UMultiplayerSessionsSubsystem::StartLANBeacon()
+{
+	if(!bUseLANBeacon || !bLANSubsystem || LANBeacon.IsRunning()) { return; }
+
+	FMultiplayerSessionLANBeaconConfig Config;
+	Config.GroupAddress = LANBeaconGroupAddress;
+	Config.Port = LANBeaconPort;
+	Config.MulticastInterface = LANBeaconMulticastInterface;
+	Config.AnnounceInterval = LANBeaconInterval;
+	Config.HostTimeout = LANBeaconHostTimeout;
+
+	// searches fall back to broadcast queries
+	if(!LANBeacon.Start(Config)) { return; }
+
+	LANBeaconTickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::TickLANBeacon));
+}
+void UMultiplayerSessionsSubsystem::StopLANBeacon()
+{
+	if(LANBeaconTickHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(LANBeaconTickHandle);
+		LANBeaconTickHandle.Reset();
+	}
+
+	LANBeacon.Stop();
+}
+bool UMultiplayerSessionsSubsystem::TickLANBeacon(float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+	LANBeacon.Tick(Now);
+
+	if (LANBeacon.IsAnnounceDue(Now))
+	{
+		FMultiplayerSessionLANHost Announcement;
+		if (MakeLANBeaconAnnouncement(Announcement))
+		{
+			LANBeacon.Announce(Announcement, Now);
+		}
+		else
+		{
+			LANBeacon.Withdraw(Now);
+		}
+	}
+
+	return true;
+}
+bool UMultiplayerSessionsSubsystem::MakeLANBeaconAnnouncement(FMultiplayerSessionLANHost& OutHost)
+{
+	if(!SessionInterface.IsValid()) { return false; }
+
+	for (const FMultiplayerSessionSlot& Slot : Sessions.GetSlots())
+	{
+		// a session we host, once the online subsystem has created it and for as long as it's up
+		if(!Slot.Settings.IsValid() || !Slot.Settings->bShouldAdvertise || !Slot.Settings->bIsLANMatch) { continue; }
+		if(Slot.State != EMultiplayerSessionState::Pending && Slot.State != EMultiplayerSessionState::Starting &&
+			Slot.State != EMultiplayerSessionState::InProgress) { continue; }
+
+		const FNamedOnlineSession* Session = SessionInterface->GetNamedSession(Slot.SessionName);
+		if(!Session) { continue; }
+
+		const FOnlineSessionSettings& Settings = Session->SessionSettings;
+		uint32 QuickMatch = 0;
+
+		using namespace MultiplayerSessionAttributes;
+		GetInt(Settings, EMultiplayerSessionAttribute::MatchKey, OutHost.MatchKey);
+		OutHost.bHasRegion = GetInt(Settings, EMultiplayerSessionAttribute::RegionKey, OutHost.RegionKey);
+		OutHost.bQuickMatch = GetInt(Settings, EMultiplayerSessionAttribute::QuickMatch, QuickMatch) && QuickMatch;
+		GetString(Settings, EMultiplayerSessionAttribute::MapName, OutHost.MapName);
+
+		OutHost.BuildUniqueId = Settings.BuildUniqueId;
+		OutHost.NumPublicConnections = Settings.NumPublicConnections;
+		OutHost.NumOpenPublicConnections = Session->NumOpenPublicConnections;
+		OutHost.bIsDedicated = Settings.bIsDedicated;
+
+		// the port we actually listen on, it differs from the configured one when several hosts share a machine
+		UWorld* World = GetWorld();
+		UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+		const TSharedPtr<const FInternetAddr> LocalAddr = NetDriver ? NetDriver->GetLocalAddr() : nullptr;
+		OutHost.Port = static_cast<uint16>(LocalAddr.IsValid() ? LocalAddr->GetPort() : (World ? World->URL.Port : FURL::UrlConfig.DefaultPort));
+
+		return true;
+	}
+
+	return false;
+}
+bool UMultiplayerSessionsSubsystem::ServeSearchFromLANBeacon(int32 MaxSearchResults, const FMultiplayerSessionSearchFilter& Filter)
+{
+	if(!LANBeacon.IsRunning()) { return false; }
+
+	const double Now = FPlatformTime::Seconds();
+
+	// take in whatever arrived since the last tick
+	LANBeacon.Tick(Now);
+
+	// a beacon that only just started may not have heard the hosts yet, and with nobody heard from at all there may be
+	// hosts that don't send beacons (other builds, other games' settings). The broadcast query finds both.
+	if(!LANBeacon.HasHeardEveryHost(Now) || LANBeacon.GetHosts().Num() == 0) { return false; }
+
+	const TSharedRef<FOnlineSessionSearch> Search = MakeSessionSearch(MaxSearchResults, Filter);
+	LANBeacon.MakeSearchResults(Filter, MaxSearchResults, Search->SearchResults);
+	Search->SearchState = EOnlineAsyncTaskState::Done;
+
+	Metrics.RecordCompletion(EMultiplayerSessionMetricOp::Find, EMultiplayerSessionOpOutcome::Success, Now, Now);
+	Metrics.RecordSearchResults(Search->SearchResults.Num());
+	Journal.Record(EMultiplayerSessionJournalEvent::Completed, EMultiplayerSessionMetricOp::Find, NAME_None, EMultiplayerSessionOpOutcome::Success, Search->SearchResults.Num());
+
+	LastSessionSearch = Search;
+	LastSearchFilter = Filter;
+	LastMaxSearchResults = MaxSearchResults;
+	ResetRanking();
+
+	SearchIndex.Reset(Filter, GetOldestLiveHeartbeat());
+	NumSearchResultsIndexed = 0;
+	IndexSearchResults();
+
+	return true;
+}
+bool UMultiplayerSessionsSubsystem::SendLANBeaconSessionOp(FName SessionName, EMultiplayerSessionOpType Type)
+{
+	FMultiplayerSessionSlot* Slot = Sessions.Find(SessionName);
+	if(!Slot) { return false; }
+
+	// complete from inside the call like the NULL subsystem itself does
+	switch (Type)
+	{
+	case EMultiplayerSessionOpType::Join:
+		Slot->State = EMultiplayerSessionState::Joining;
+		OnJoinSessionComplete(SessionName, EOnJoinSessionCompleteResult::Success);
+		return true;
+	case EMultiplayerSessionOpType::Start:
+		Slot->State = EMultiplayerSessionState::Starting;
+		OnStartSessionComplete(SessionName, true);
+		return true;
+	case EMultiplayerSessionOpType::Destroy:
+		// the name is free for a session of the online subsystem again
+		Slot->State = EMultiplayerSessionState::Destroying;
+		Slot->bLANBeaconSession = false;
+		OnDestroySessionComplete(SessionName, true);
+		return true;
+	default:
+		// a create is always queued behind the destroy of what's there, which has cleared the flag
+		return false;
+	}
+}
+bool UMultiplayerSessionsSubsystem::ResolveConnectString(const FOnlineSessionSearchResult& SessionResult, FString& OutConnectString) const
+{
+	// the online subsystem would misread the session info of a result it didn't make
+	if (FMultiplayerSessionLANBeacon::IsBeaconResult(SessionResult))
+	{
+		return FMultiplayerSessionLANBeacon::GetConnectString(SessionResult, OutConnectString);
+	}
+
+	return SessionInterface.IsValid() && SessionInterface->GetResolvedConnectString(SessionResult, NAME_GamePort, OutConnectString);
+}
+
+/* PARTY JOIN
+ * ====================================================================================================================
+ *
+ *	A party joins as a whole or not at all. The leader only picks sessions with a free public slot for every member,
+ *	from JoinSession(), JoinRankedSessions() or a search with FMultiplayerSessionSearchFilter::MinOpenSlots set to
+ *	the party size. Once it's in it looks the session up again, the search result may be stale by then: if the session
+ *	filled up in the meantime the leader leaves before anybody travels. The members then follow the leader with
+ *	JoinSessionById(), a single lookup instead of a search and join round-trip each. On the host they arrive like
+ *	any other player, batched into one registration if the game passes them to QueuePlayerRegistration().
+ *
+ *	IOnlineSession has no way to hold slots for players that haven't joined yet, so a stranger can still take a slot
+ *	between the leader and the members joining. Members that find the session full are told so like any failed join.
+ *
+ * ====================================================================================================================
+ */
+void UMultiplayerSessionsSubsystem::JoinSessionById(FName SessionName, const FString& SessionId)
+{
+	const bool bBound = EnsureSessionInterface();
+	const FUniqueNetIdPtr LocalUserId = GetLocalUserId();
+	const FUniqueNetIdPtr SessionNetId = bBound ? SessionInterface->CreateSessionIdFromString(SessionId) : nullptr;
+
+	const bool bStarted = LocalUserId.IsValid() && SessionNetId.IsValid() && SessionInterface->FindSessionById(*LocalUserId, *SessionNetId, *LocalUserId,
+		FOnSingleSessionResultCompleteDelegate::CreateUObject(this, &ThisClass::OnFindSessionByIdComplete, SessionName));
+
+	if (!bStarted)
+	{
+		Metrics.RecordOutcome(EMultiplayerSessionMetricOp::Join, EMultiplayerSessionOpOutcome::SessionDoesNotExist);
+		BroadcastSessionOpResult(SessionName, EMultiplayerSessionOpType::Join, false, EOnJoinSessionCompleteResult::SessionDoesNotExist);
+	}
+}
+void UMultiplayerSessionsSubsystem::OnFindSessionByIdComplete(int32 LocalUserNum, bool bWasSuccessful, const FOnlineSessionSearchResult& SessionResult, FName SessionName)
+{
+	if (!bWasSuccessful || !SessionResult.IsValid())
+	{
+		Metrics.RecordOutcome(EMultiplayerSessionMetricOp::Join, EMultiplayerSessionOpOutcome::SessionDoesNotExist);
+		BroadcastSessionOpResult(SessionName, EMultiplayerSessionOpType::Join, false, EOnJoinSessionCompleteResult::SessionDoesNotExist);
+		return;
+	}
+
+	// the leader has made sure there's room for everybody, each member only needs its own slot
+	JoinSession(SessionName, SessionResult);
+}
+FString UMultiplayerSessionsSubsystem::GetSessionId(FName SessionName)
+{
+	const FNamedOnlineSession* Session = EnsureSessionInterface() ? SessionInterface->GetNamedSession(SessionName) : nullptr;
+	return Session ? Session->GetSessionIdStr() : FString();
+}
+bool UMultiplayerSessionsSubsystem::HasRoomForParty(const FOnlineSession& Session, int32 PartySize)
+{
+	// a single player is left to the online service, which knows better than a search result that may be stale
+	if(PartySize <= 1) { return true; }
+
+	return Session.SessionSettings.NumPublicConnections >= PartySize && Session.NumOpenPublicConnections >= PartySize;
+}
+
+/* HOST HEARTBEAT
+ * ====================================================================================================================
+ *
+ *	Online services keep listing a session as it was created, so searches see sessions that are full, over or whose
+ *	host has died, and players waste join attempts on them. Every HostHeartbeatInterval seconds each session we host
+ *	republishes its player count, match phase and whether it takes players (the Closed attribute) along with the
+ *	current UTC time. Changes in between (registrations, StartSession(), SetSessionMatchPhase()) are published right
+ *	away, but no session sees more than one UpdateSession per SessionUpdateInterval, everything else waits for it.
+ *
+ *	A host that crashed can't take its session down, so searches leave out results whose last heartbeat is older than
+ *	HostHeartbeatTimeout. A host that is still running but no longer serving its session (e.g. it travelled back to
+ *	the menu without destroying it) stops advertising it after MaxHeartbeatsNotServing heartbeats, and picks it up
+ *	again once it serves again.
+ *
+ * ====================================================================================================================
+ */
+void UMultiplayerSessionsSubsystem::RefreshHostedSession(FName SessionName, bool bHeartbeat)
+{
+	FMultiplayerSessionSlot* Slot = Sessions.Find(SessionName);
+	if(!Slot || !Slot->Settings.IsValid()) { return; }
+
+	using namespace MultiplayerSessionAttributes;
+	FOnlineSessionSettings& Settings = *Slot->Settings;
+
+	// online subsystems either track the players or the slots they take, take whichever counts more
+	const FNamedOnlineSession* Session = SessionInterface.IsValid() ? SessionInterface->GetNamedSession(SessionName) : nullptr;
+	const int32 NumPlayers = Session ? FMath::Max(Session->RegisteredPlayers.Num(), Settings.NumPublicConnections - Session->NumOpenPublicConnections) : 0;
+
+	uint32 Phase = 0;
+	GetInt(Settings, EMultiplayerSessionAttribute::MatchPhase, Phase);
+	const bool bPhaseAllowsJoining = Phase == static_cast<uint32>(EMultiplayerSessionMatchPhase::Lobby) ||
+		(Phase == static_cast<uint32>(EMultiplayerSessionMatchPhase::InProgress) && Settings.bAllowJoinInProgress);
+
+	const bool bAdvertise = Slot->NumHeartbeatsNotServing <= MaxHeartbeatsNotServing;
+	const bool bClosed = !bAdvertise || !bPhaseAllowsJoining || NumPlayers >= Settings.NumPublicConnections;
+
+	bool bChanged = SetInt(Settings, EMultiplayerSessionAttribute::PlayerCount, static_cast<uint32>(FMath::Max(NumPlayers, 0)));
+	bChanged |= SetInt(Settings, EMultiplayerSessionAttribute::Closed, bClosed ? 1 : 0);
+	if (Settings.bShouldAdvertise != bAdvertise)
+	{
+		Settings.bShouldAdvertise = bAdvertise;
+		bChanged = true;
+	}
+	if (bHeartbeat)
+	{
+		bChanged |= SetInt(Settings, EMultiplayerSessionAttribute::Heartbeat, static_cast<uint32>(FDateTime::UtcNow().ToUnixTimestamp()));
+	}
+
+	if (bChanged)
+	{
+		MarkSessionSettingsDirty(SessionName);
+	}
+}
+bool UMultiplayerSessionsSubsystem::IsServingSessions() const
+{
+	const UWorld* World = GetWorld();
+	const ENetMode NetMode = World ? World->GetNetMode() : NM_Standalone;
+	return NetMode == NM_ListenServer || NetMode == NM_DedicatedServer;
+}
+bool UMultiplayerSessionsSubsystem::TickHostHeartbeat(float DeltaTime)
+{
+	const bool bServing = IsServingSessions();
+
+	// collect first, refreshing looks the sessions up again
+	TArray<FName, TInlineAllocator<4>> Hosted;
+	for (FMultiplayerSessionSlot& Slot : Sessions.GetSlots())
+	{
+		// joined sessions belong to their host
+		if(!Slot.Settings.IsValid()) { continue; }
+
+		const bool bExists = Slot.State == EMultiplayerSessionState::Pending || Slot.State == EMultiplayerSessionState::Starting ||
+			Slot.State == EMultiplayerSessionState::InProgress;
+		if(!bExists) { continue; }
+
+		Slot.NumHeartbeatsNotServing = bServing ? 0 : static_cast<uint8>(FMath::Min(Slot.NumHeartbeatsNotServing + 1, MAX_uint8));
+		Hosted.Add(Slot.SessionName);
+	}
+
+	for (const FName SessionName : Hosted)
+	{
+		RefreshHostedSession(SessionName, true);
+	}
+
+	return true;
+}
+uint32 UMultiplayerSessionsSubsystem::GetOldestLiveHeartbeat() const
+{
+	if(HostHeartbeatTimeout <= 0.f) { return 0; }
+
+	return static_cast<uint32>(FMath::Max<int64>(FDateTime::UtcNow().ToUnixTimestamp() - FMath::CeilToInt(HostHeartbeatTimeout), 1));
+}
+
+/* HOST MIGRATION
+ * ====================================================================================================================
+ *
+ *	Every session we host carries a random lineage id, which joined members read from the settings of their
+ *	session. When the host goes away the members that are left elect the one with the lowest unique id (compared
+ *	case sensitively, the same way the quick match merge does). They all see the same players, so they agree
+ *	without talking to each other.
+ *
+ *	The successor hosts the session again through the fast host path under the same match key and lineage, with the
+ *	map we were in as its lobby. The others query for that lineage every HostMigrationRetryInterval seconds until the
+ *	successor's session shows up, join it and ClientTravel there. The old host's listing can linger with the same
+ *	lineage and a recent heartbeat, results it owns are passed over. Nobody runs a search for
+ *	the match type or goes back through the menu, the lobby is back after a create on one side and a query and join
+ *	on the other.
+ *
+ *	Losing the host sends the engine back to the entry map. Hosting and searching run while it loads, travelling
+ *	waits for it. A session whose host predates the lineage id, or a dedicated server's, can't migrate.
+ *
+ * ====================================================================================================================
+ */
+bool UMultiplayerSessionsSubsystem::MigrateHost(TArrayView<const FUniqueNetIdRef> RemainingMembers)
+{
+	return StartHostMigration(RemainingMembers, false);
+}
+void UMultiplayerSessionsSubsystem::CancelHostMigration()
+{
+	switch (HostMigrationState.Stage)
+	{
+	case EHostMigrationStage::None:
+		return;
+	case EHostMigrationStage::Hosting:
+		// the session is still created, but nobody travels into it
+		HostPipeline.bActive = false;
+		break;
+	case EHostMigrationStage::Searching:
+		CancelFindSessions();
+		break;
+	default:
+		break;
+	}
+
+	FinishHostMigration(EMultiplayerHostMigrationResult::Cancelled);
+}
+bool UMultiplayerSessionsSubsystem::StartHostMigration(TArrayView<const FUniqueNetIdRef> RemainingMembers, bool bAwaitEntryMap)
+{
+	if(IsHostMigrationActive()) { return false; }
+
+	const FNamedOnlineSession* Session = EnsureSessionInterface() ? SessionInterface->GetNamedSession(NAME_GameSession) : nullptr;
+	const FUniqueNetIdPtr LocalUserId = GetLocalUserId();
+	if(!Session || !LocalUserId.IsValid() || Session->SessionSettings.bIsDedicated) { return false; }
+
+	uint32 Lineage = 0;
+	uint32 MatchKey = 0;
+	if(!MultiplayerSessionAttributes::GetInt(Session->SessionSettings, EMultiplayerSessionAttribute::Lineage, Lineage) || Lineage == 0) { return false; }
+	if(!MultiplayerSessionAttributes::GetInt(Session->SessionSettings, EMultiplayerSessionAttribute::MatchKey, MatchKey)) { return false; }
+
+	// we count as a member whether or not the caller listed us, the old host doesn't
+	FString SuccessorId = LocalUserId->ToString();
+	for (const FUniqueNetIdRef& Member : RemainingMembers)
+	{
+		if(Session->OwningUserId.IsValid() && *Member == *Session->OwningUserId) { continue; }
+
+		FString MemberId = Member->ToString();
+		if (MemberId.Compare(SuccessorId, ESearchCase::CaseSensitive) < 0)
+		{
+			SuccessorId = MoveTemp(MemberId);
+		}
+	}
+
+	// host the map we were in again, or the lobby the old host advertised if we can't tell
+	const UWorld* World = GetWorld();
+	FString MapName = World ? UWorld::RemovePIEPrefix(World->GetOutermost()->GetName()) : FString();
+	if (MapName.IsEmpty())
+	{
+		MultiplayerSessionAttributes::GetString(Session->SessionSettings, EMultiplayerSessionAttribute::MapName, MapName);
+	}
+
+	const bool bSuccessor = SuccessorId == LocalUserId->ToString();
+	if(bSuccessor && MapName.IsEmpty()) { return false; }
+
+	const int32 NumPublicConnections = Session->SessionSettings.NumPublicConnections;
+
+	CancelQuickMatch();
+	StopJoinFailover();
+
+	HostMigrationState = FHostMigrationState();
+	HostMigrationState.MatchKey = MatchKey;
+	HostMigrationState.Lineage = Lineage;
+	HostMigrationState.OldHostId = Session->OwningUserId;
+	HostMigrationState.LobbyPath = MapName + TEXT("?listen");
+	HostMigrationState.Deadline = FPlatformTime::Seconds() + HostMigrationTimeout;
+	HostMigrationState.bAwaitingEntryMap = bAwaitEntryMap;
+
+	if (bAwaitEntryMap)
+	{
+		HostMigrationState.MapLoadedHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &ThisClass::OnHostMigrationMapLoaded);
+	}
+
+	if (bSuccessor)
+	{
+		// the session we had joined is left first, the create waits behind that in the session queue
+		HostMigrationState.Stage = EHostMigrationStage::Hosting;
+		HostSessionWithKey(NumPublicConnections, MatchKey, HostMigrationState.LobbyPath, Lineage);
+	}
+	else
+	{
+		HostMigrationSearch();
+	}
+
+	return true;
+}
+void UMultiplayerSessionsSubsystem::HostMigrationSearch()
+{
+	// a search answered right away reports back from inside FindSessionsIncremental()
+	HostMigrationState.Stage = EHostMigrationStage::Searching;
+
+	FMultiplayerSessionSearchFilter Filter;
+	Filter.Lineage = static_cast<int32>(HostMigrationState.Lineage);
+
+	// a lineage has a single live session, a few more results leave room for stale ones of the old host
+	FindSessionsIncremental(8, Filter);
+}
+bool UMultiplayerSessionsSubsystem::OnHostMigrationRetry(float DeltaTime)
+{
+	HostMigrationState.RetryHandle.Reset();
+
+	if (HostMigrationState.Stage == EHostMigrationStage::Searching)
+	{
+		HostMigrationSearch();
+	}
+
+	return false;
+}
+void UMultiplayerSessionsSubsystem::OnHostMigrationSearchPage(bool bIsLastPage)
+{
+	if(HostMigrationState.Stage != EHostMigrationStage::Searching) { return; }
+
+	// the old host's listing carries the same lineage and looked alive a moment ago, only the successor's will do
+	const FOnlineSessionSearchResult* Successor = nullptr;
+	SearchIndex.ForEach(HostMigrationState.MatchKey, [this, &Successor](int32 ResultIndex)
+	{
+		const FOnlineSessionSearchResult* Result = GetSearchResult(ResultIndex);
+		if(Successor || !Result) { return; }
+
+		const FUniqueNetIdPtr& OwnerId = Result->Session.OwningUserId;
+		if(OwnerId.IsValid() && HostMigrationState.OldHostId.IsValid() && *OwnerId == *HostMigrationState.OldHostId) { return; }
+
+		Successor = Result;
+	});
+
+	if (Successor)
+	{
+		CancelFindSessions();
+
+		HostMigrationState.Stage = EHostMigrationStage::Joining;
+		JoinSession(NAME_GameSession, *Successor);
+		return;
+	}
+
+	if(!bIsLastPage) { return; }
+
+	// the successor may not be done hosting yet
+	if (FPlatformTime::Seconds() + HostMigrationRetryInterval > HostMigrationState.Deadline)
+	{
+		FinishHostMigration(EMultiplayerHostMigrationResult::Failed);
+		return;
+	}
+
+	HostMigrationState.RetryHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateUObject(this, &ThisClass::OnHostMigrationRetry), FMath::Max(HostMigrationRetryInterval, 0.f));
+}
+void UMultiplayerSessionsSubsystem::OnHostMigrationJoined(bool bWasSuccessful)
+{
+	if(HostMigrationState.Stage != EHostMigrationStage::Joining) { return; }
+
+	if (!bWasSuccessful)
+	{
+		// e.g. still full of the old host's registrations, look again while there's time
+		HostMigrationState.Stage = EHostMigrationStage::Searching;
+		OnHostMigrationSearchPage(true);
+		return;
+	}
+
+	HostMigrationState.bSessionReady = true;
+	TravelAfterHostMigration();
+}
+void UMultiplayerSessionsSubsystem::OnHostMigrationHostReady(bool bWasSuccessful)
+{
+	if(HostMigrationState.Stage != EHostMigrationStage::Hosting) { return; }
+
+	if (!bWasSuccessful)
+	{
+		FinishHostMigration(EMultiplayerHostMigrationResult::Failed);
+		return;
+	}
+
+	HostMigrationState.bSessionReady = true;
+	TravelAfterHostMigration();
+}
+void UMultiplayerSessionsSubsystem::OnHostMigrationMapLoaded(UWorld* LoadedWorld)
+{
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(HostMigrationState.MapLoadedHandle);
+	HostMigrationState.MapLoadedHandle.Reset();
+
+	HostMigrationState.bAwaitingEntryMap = false;
+	TravelAfterHostMigration();
+}
+void UMultiplayerSessionsSubsystem::TravelAfterHostMigration()
+{
+	if(!HostMigrationState.bSessionReady || HostMigrationState.bAwaitingEntryMap) { return; }
+
+	if (HostMigrationState.Stage == EHostMigrationStage::Hosting)
+	{
+		UWorld* World = GetWorld();
+		if (!World)
+		{
+			FinishHostMigration(EMultiplayerHostMigrationResult::Failed);
+			return;
+		}
+
+		World->ServerTravel(HostMigrationState.LobbyPath);
+		FinishHostMigration(EMultiplayerHostMigrationResult::Hosted);
+		return;
+	}
+
+	FinishHostMigration(ClientTravelToSession() ? EMultiplayerHostMigrationResult::Joined : EMultiplayerHostMigrationResult::Failed);
+}
+void UMultiplayerSessionsSubsystem::FinishHostMigration(EMultiplayerHostMigrationResult Result)
+{
+	if(HostMigrationState.RetryHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(HostMigrationState.RetryHandle);
+	}
+	if(HostMigrationState.MapLoadedHandle.IsValid())
+	{
+		FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(HostMigrationState.MapLoadedHandle);
+	}
+
+	// listeners are free to start the next migration from inside the broadcast
+	HostMigrationState = FHostMigrationState();
+	MultiplayerOnHostMigrationComplete.Broadcast(Result);
+}
+void UMultiplayerSessionsSubsystem::OnNetworkFailure(UWorld* World, UNetDriver* NetDriver, ENetworkFailure::Type FailureType, const FString& ErrorString)
+{
+	if(!bMigrateHostOnDisconnect || IsHostMigrationActive()) { return; }
+
+	// only the connection of our game to its host, not a server losing a client or some other net driver
+	if(!World || World != GetWorld() || !NetDriver || NetDriver->NetDriverName != NAME_GameNetDriver || !NetDriver->ServerConnection) { return; }
+	if(FailureType != ENetworkFailure::ConnectionLost && FailureType != ENetworkFailure::ConnectionTimeout) { return; }
+
+	// the players are still around until the engine takes us back to the entry map
+	TArray<FUniqueNetIdRef> Members;
+	if (const AGameStateBase* GameState = World->GetGameState())
+	{
+		for (const APlayerState* PlayerState : GameState->PlayerArray)
+		{
+			if (PlayerState && PlayerState->GetUniqueId().IsValid())
+			{
+				Members.Add(PlayerState->GetUniqueId().GetUniqueNetId().ToSharedRef());
+			}
+		}
+	}
+
+	StartHostMigration(Members, true);
+}
@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionAllocationCounter.h"
+#include "HAL/MemoryBase.h"
+
+namespace
+{
+	thread_local int32 IgnoreDepth = 0;
+
+	// the counters only move on threads that have a FScopedCount alive
+	thread_local int32 CountDepth = 0;
+	thread_local uint64 NumAllocations = 0;
+	thread_local uint64 BytesAllocated = 0;
+
+	// Pass-through allocator that counts what threads inside a FScopedCount allocate
+	class FCountingMalloc final : public FMalloc
+	{
+	public:
+
+		explicit FCountingMalloc(FMalloc* InInner) : Inner(InInner) {}
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			Record(Count);
+			return Inner->Malloc(Count, Alignment);
+		}
+		virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+		{
+			Record(Count);
+			return Inner->TryMalloc(Count, Alignment);
+		}
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			Record(Count);
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+		virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			Record(Count);
+			return Inner->TryRealloc(Original, Count, Alignment);
+		}
+		virtual void Free(void* Original) override { Inner->Free(Original); }
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+		virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+		virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+		virtual void InitializeStatsMetadata() override { Inner->InitializeStatsMetadata(); }
+		virtual void UpdateStats() override { Inner->UpdateStats(); }
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { Inner->GetAllocatorStats(OutStats); }
+		virtual void DumpAllocatorStats(FOutputDevice& Ar) override { Inner->DumpAllocatorStats(Ar); }
+		virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+		virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+		virtual const TCHAR* GetDescriptiveName() override { return Inner->GetDescriptiveName(); }
+
+	private:
+
+		static void Record(SIZE_T Size)
+		{
+			if(CountDepth == 0 || IgnoreDepth > 0) { return; }
+
+			++NumAllocations;
+			BytesAllocated += Size;
+		}
+
+		FMalloc* Inner;
+	};
+
+	void InstallCountingMalloc()
+	{
+		// never uninstalled nor freed, other threads may hold on to GMalloc at any time
+		static FCountingMalloc* const CountingMalloc = []()
+		{
+			FCountingMalloc* NewMalloc = new FCountingMalloc(GMalloc);
+			GMalloc = NewMalloc;
+			return NewMalloc;
+		}();
+	}
+}
+
+MultiplayerSessionAllocations::FScopedIgnore::FScopedIgnore()
+{
+	++IgnoreDepth;
+}
+
+MultiplayerSessionAllocations::FScopedIgnore::~FScopedIgnore()
+{
+	--IgnoreDepth;
+}
+
+bool MultiplayerSessionAllocations::IsIgnored()
+{
+	return IgnoreDepth > 0;
+}
+
+MultiplayerSessionAllocations::FScopedCount::FScopedCount()
+{
+	InstallCountingMalloc();
+
+	++CountDepth;
+	NumAllocationsBefore = NumAllocations;
+	BytesAllocatedBefore = BytesAllocated;
+}
+
+MultiplayerSessionAllocations::FScopedCount::~FScopedCount()
+{
+	--CountDepth;
+}
+
+uint64 MultiplayerSessionAllocations::FScopedCount::GetNumAllocations() const
+{
+	return NumAllocations - NumAllocationsBefore;
+}
+
+uint64 MultiplayerSessionAllocations::FScopedCount::GetBytesAllocated() const
+{
+	return BytesAllocated - BytesAllocatedBefore;
+}
@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace MultiplayerSessionAllocations
+{
+	// Allocations the current thread makes while one of these is alive aren't counted by the benchmark, e.g. the work
+	// of the mock online service, which a real one does on its own threads or servers
+	struct FScopedIgnore
+	{
+		FScopedIgnore();
+		~FScopedIgnore();
+	};
+
+	bool IsIgnored();
+
+	// Counts what the current thread allocates while it's alive, other threads aren't counted. The first one puts a
+	// pass-through allocator in front of GMalloc that stays there for the rest of the process, so a thread that picked
+	// it up can never end up calling into an allocator that's gone. Counting itself is thread local.
+	class FScopedCount
+	{
+	public:
+
+		FScopedCount();
+		~FScopedCount();
+
+		uint64 GetNumAllocations() const;
+		uint64 GetBytesAllocated() const;
+
+	private:
+
+		uint64 NumAllocationsBefore;
+		uint64 BytesAllocatedBefore;
+	};
+}
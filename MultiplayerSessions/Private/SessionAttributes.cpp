@@ -0,0 +1,143 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionAttributes.h"
+#include "Misc/Crc.h"
+
+namespace
+{
+	using namespace MultiplayerSessionAttributes;
+
+	uint64 GetFieldMask(const FMultiplayerSessionAttributeDesc& Desc)
+	{
+		return ((uint64(1) << Desc.BitWidth) - 1) << Desc.BitOffset;
+	}
+
+	bool GetPackedWord(const FOnlineSessionSettings& Settings, FName Key, uint64& OutWord)
+	{
+		const FOnlineSessionSetting* Setting = Settings.Settings.Find(Key);
+		if(!Setting || Setting->Data.GetType() != EOnlineKeyValuePairDataType::Int64) { return false; }
+
+		int64 Word = 0;
+		Setting->Data.GetValue(Word);
+		OutWord = static_cast<uint64>(Word);
+		return true;
+	}
+
+	bool SetSetting(FOnlineSessionSettings& Settings, EMultiplayerSessionAttribute Attribute, const FVariantData& Value)
+	{
+		const FName Key = GetKey(Attribute);
+
+		const FOnlineSessionSetting* Existing = Settings.Settings.Find(Key);
+		if(Existing && Existing->Data == Value) { return false; }
+
+		Settings.Set(Key, FOnlineSessionSetting(Value, Describe(Attribute).Advertisement));
+		return true;
+	}
+}
+
+FName MultiplayerSessionAttributes::GetKey(EMultiplayerSessionAttribute Attribute)
+{
+	struct FKeys
+	{
+		FName Names[UE_ARRAY_COUNT(Schema)];
+
+		FKeys()
+		{
+			for (int32 Index = 0; Index < UE_ARRAY_COUNT(Schema); ++Index)
+			{
+				Names[Index] = FName(Schema[Index].Key);
+			}
+		}
+	};
+
+	static const FKeys Keys;
+	return Keys.Names[static_cast<int32>(Attribute)];
+}
+
+uint32 MultiplayerSessionAttributes::HashString(const FString& Value)
+{
+	// hosts and clients may run different engine builds, GetTypeHash() isn't guaranteed to agree between them
+	return FCrc::StrCrc32(*Value.ToLower());
+}
+
+bool MultiplayerSessionAttributes::SetInt(FOnlineSessionSettings& Settings, EMultiplayerSessionAttribute Attribute, uint32 Value)
+{
+	const FMultiplayerSessionAttributeDesc& Desc = Describe(Attribute);
+
+	if (Desc.Type == EMultiplayerSessionAttributeType::Int32)
+	{
+		return SetSetting(Settings, Attribute, FVariantData(static_cast<int32>(Value)));
+	}
+
+	if(!ensure(Desc.Type == EMultiplayerSessionAttributeType::Packed)) { return false; }
+
+	// read-modify-write the shared word, the other packed attributes keep their bits
+	const uint64 Mask = GetFieldMask(Desc);
+	ensureMsgf(((uint64(Value) << Desc.BitOffset) & ~Mask) == 0, TEXT("%u doesn't fit the %d bits of attribute %d"), Value, Desc.BitWidth, static_cast<int32>(Attribute));
+
+	uint64 Word = 0;
+	GetPackedWord(Settings, GetKey(Attribute), Word);
+	Word = (Word & ~Mask) | ((uint64(Value) << Desc.BitOffset) & Mask);
+
+	return SetSetting(Settings, Attribute, FVariantData(static_cast<int64>(Word)));
+}
+
+bool MultiplayerSessionAttributes::GetInt(const FOnlineSessionSettings& Settings, EMultiplayerSessionAttribute Attribute, uint32& OutValue)
+{
+	const FMultiplayerSessionAttributeDesc& Desc = Describe(Attribute);
+
+	if (Desc.Type == EMultiplayerSessionAttributeType::Int32)
+	{
+		const FOnlineSessionSetting* Setting = Settings.Settings.Find(GetKey(Attribute));
+		if(!Setting || Setting->Data.GetType() != EOnlineKeyValuePairDataType::Int32) { return false; }
+
+		int32 Value = 0;
+		Setting->Data.GetValue(Value);
+		OutValue = static_cast<uint32>(Value);
+		return true;
+	}
+
+	if(!ensure(Desc.Type == EMultiplayerSessionAttributeType::Packed)) { return false; }
+
+	uint64 Word = 0;
+	if(!GetPackedWord(Settings, GetKey(Attribute), Word)) { return false; }
+
+	OutValue = static_cast<uint32>((Word & GetFieldMask(Desc)) >> Desc.BitOffset);
+	return true;
+}
+
+bool MultiplayerSessionAttributes::SetString(FOnlineSessionSettings& Settings, EMultiplayerSessionAttribute Attribute, const FString& Value)
+{
+	if(!ensure(Describe(Attribute).Type == EMultiplayerSessionAttributeType::String)) { return false; }
+
+	return SetSetting(Settings, Attribute, FVariantData(Value));
+}
+
+bool MultiplayerSessionAttributes::GetString(const FOnlineSessionSettings& Settings, EMultiplayerSessionAttribute Attribute, FString& OutValue)
+{
+	if(!ensure(Describe(Attribute).Type == EMultiplayerSessionAttributeType::String)) { return false; }
+
+	const FOnlineSessionSetting* Setting = Settings.Settings.Find(GetKey(Attribute));
+	if(!Setting || Setting->Data.GetType() != EOnlineKeyValuePairDataType::String) { return false; }
+
+	Setting->Data.GetValue(OutValue);
+	return true;
+}
+
+void MultiplayerSessionAttributes::SetQuery(FOnlineSearchSettings& QuerySettings, EMultiplayerSessionAttribute Attribute, uint32 Value)
+{
+	// packed attributes can't be filtered by the online service, the search index checks those
+	if(!ensure(Describe(Attribute).Type == EMultiplayerSessionAttributeType::Int32)) { return; }
+
+	QuerySettings.Set(GetKey(Attribute), static_cast<int32>(Value), EOnlineComparisonOp::Equals);
+}
+
+bool MultiplayerSessionAttributes::MatchesQuery(const FOnlineSearchSettings& QuerySettings, const FOnlineSessionSettings& Settings, EMultiplayerSessionAttribute Attribute)
+{
+	int32 QueryValue = 0;
+	if(!QuerySettings.Get(GetKey(Attribute), QueryValue)) { return true; }
+
+	uint32 Value = 0;
+	return GetInt(Settings, Attribute, Value) && Value == static_cast<uint32>(QueryValue);
+}
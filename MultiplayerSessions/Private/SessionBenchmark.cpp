@@ -0,0 +1,335 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CoreMinimal.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "MockOnlineSession.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "OnlineSessionSettings.h"
+#include "SessionAllocationCounter.h"
+#include "SessionRanking.h"
+
+#if !UE_BUILD_SHIPPING
+
+/* SESSION BENCHMARK
+ * ====================================================================================================================
+ *
+ *	Drives UMultiplayerSessionsSubsystem through create/destroy, find and join/leave cycles against a FMockOnlineSession,
+ *	then searches once more the way the menu does, incrementally and ranking on the first matching page. Runs without network, e.g. headless on a CI box:
+ *
+ *		UnrealEditor-Cmd <Project>.uproject -game -nullrhi -nosound -unattended
+ *			-ExecCmds="MultiplayerSessions.Benchmark 5000 200 0.02 0.01, Quit"
+ *
+ *	Arguments: cycles, advertised sessions, simulated latency in seconds, failure rate. The mock is ticked manually in
+ *	simulated time, so a run takes as long as the CPU work does and the reported times are the subsystem's own cost.
+ *	Large rankings finish on the task graph, the Rank phase waits for them in real time and only counts what the game
+ *	thread itself spends. Game thread time per search (find plus rank) should level off as advertised sessions grow,
+ *	for both kinds of search.
+ *	Allocations are counted on the game thread only, that's where the subsystem runs, and leave out what the mock
+ *	allocates to simulate the online service. A search and join should allocate a bounded amount, however many sessions
+ *	are advertised.
+ *
+ * ====================================================================================================================
+ */
+namespace
+{
+	enum class EBenchmarkPhase : uint8
+	{
+		Create,
+		Destroy,
+		Find,
+		Rank,
+		Join,
+		Leave,
+		FindIncremental,
+		RankIncremental,
+		Num
+	};
+
+	const TCHAR* GetPhaseName(EBenchmarkPhase Phase)
+	{
+		switch (Phase)
+		{
+		case EBenchmarkPhase::Create: return TEXT("Create");
+		case EBenchmarkPhase::Destroy: return TEXT("Destroy");
+		case EBenchmarkPhase::Find: return TEXT("Find");
+		case EBenchmarkPhase::Rank: return TEXT("Rank");
+		case EBenchmarkPhase::Join: return TEXT("Join");
+		case EBenchmarkPhase::Leave: return TEXT("Leave");
+		case EBenchmarkPhase::FindIncremental: return TEXT("FindInc");
+		case EBenchmarkPhase::RankIncremental: return TEXT("RankInc");
+		default: return TEXT("Unknown");
+		}
+	}
+
+	struct FPhaseSamples
+	{
+		// Wall time of every run of the phase, in microseconds
+		TArray<double> Times;
+
+		// Part of it the game thread was busy, in microseconds. Differs from Times where workers do part of the job.
+		TArray<double> GameThreadTimes;
+		uint64 NumAllocations{0};
+		uint64 BytesAllocated{0};
+		int32 NumTimedOut{0};
+	};
+
+	class FSessionBenchmark
+	{
+	public:
+
+		FSessionBenchmark(UMultiplayerSessionsSubsystem& InSubsystem, const FMockOnlineSessionConfig& Config) :
+			Subsystem(InSubsystem),
+			Mock(MakeShared<FMockOnlineSession, ESPMode::ThreadSafe>(Config))
+		{
+			// enough simulated ticks for the slowest call to complete several times over
+			MaxTicksPerPhase = FMath::Max(FMath::CeilToInt(Config.MaxLatency * 4.0 / TickSeconds), 16);
+
+			Subsystem.OverrideSessionInterface(Mock, Mock->GetLocalUserId());
+			FindHandle = Subsystem.MultiplayerOnFindSessionsComplete.AddLambda([this](TArrayView<const FOnlineSessionSearchResult>, bool) { bFindComplete = true; });
+			PageHandle = Subsystem.MultiplayerOnFindSessionsPage.AddLambda([this](TArrayView<const FOnlineSessionSearchResult>, bool bIsLastPage) { bFindComplete |= bIsLastPage; });
+			RankHandle = Subsystem.MultiplayerOnSessionsRanked.AddLambda([this](TArrayView<const FMultiplayerSessionCandidate>) { bRanked = true; });
+		}
+
+		~FSessionBenchmark()
+		{
+			Subsystem.MultiplayerOnFindSessionsComplete.Remove(FindHandle);
+			Subsystem.MultiplayerOnFindSessionsPage.Remove(PageHandle);
+			Subsystem.MultiplayerOnSessionsRanked.Remove(RankHandle);
+			Subsystem.OverrideSessionInterface(nullptr);
+		}
+
+		void Run(int32 NumCycles, bool bUseSearchCache, FOutputDevice& Ar)
+		{
+			for (FPhaseSamples& Phase : Phases)
+			{
+				Phase.Times.Reserve(NumCycles);
+				Phase.GameThreadTimes.Reserve(NumCycles);
+			}
+
+			FMultiplayerSessionSearchFilter Filter;
+			Filter.MatchType = Mock->GetConfig().AdvertisedMatchType;
+			const uint32 MatchKey = FMultiplayerSessionSearchIndex::MakeMatchKey(Filter.MatchType);
+
+			Subsystem.ResetSessionMetrics();
+			MultiplayerSessionAllocations::FScopedCount Allocations;
+			const double StartTime = FPlatformTime::Seconds();
+
+			for (int32 Cycle = 0; Cycle < NumCycles; ++Cycle)
+			{
+				RunPhase(EBenchmarkPhase::Create, Allocations, [this]() { Subsystem.CreateSession(SessionName, 4, Mock->GetConfig().AdvertisedMatchType); }, [this]() { return Subsystem.IsSessionIdle(SessionName); });
+				RunPhase(EBenchmarkPhase::Destroy, Allocations, [this]() { Subsystem.DestroySession(SessionName); }, [this]() { return Subsystem.IsSessionIdle(SessionName); });
+
+				if (!bUseSearchCache)
+				{
+					Subsystem.InvalidateSearchCache();
+				}
+
+				bFindComplete = false;
+				RunPhase(EBenchmarkPhase::Find, Allocations, [this, &Filter]() { Subsystem.FindSessions(MaxSearchResults, Filter); }, [this]() { return bFindComplete; });
+
+				const FOnlineSessionSearchResult* Result = Subsystem.FindSearchResult(MatchKey);
+				if(!Result) { continue; }
+
+				bRanked = false;
+				RunTaskPhase(EBenchmarkPhase::Rank, Allocations, [this, MatchKey]() { Subsystem.RankSessions(MatchKey); }, [this]() { return bRanked; });
+
+				RunPhase(EBenchmarkPhase::Join, Allocations, [this, Result]() { Subsystem.JoinSession(SessionName, *Result); }, [this]() { return Subsystem.IsSessionIdle(SessionName); });
+				RunPhase(EBenchmarkPhase::Leave, Allocations, [this]() { Subsystem.DestroySession(SessionName); }, [this]() { return Subsystem.IsSessionIdle(SessionName); });
+
+				if (!bUseSearchCache)
+				{
+					Subsystem.InvalidateSearchCache();
+				}
+
+				// the menu ranks as soon as a page holds a match, with the rest of the search still outstanding
+				bFindComplete = false;
+				RunPhase(EBenchmarkPhase::FindIncremental, Allocations, [this, &Filter]() { Subsystem.FindSessionsIncremental(MaxSearchResults, Filter); },
+					[this, MatchKey]() { return bFindComplete || Subsystem.FindSearchResult(MatchKey) != nullptr; });
+
+				if(!Subsystem.FindSearchResult(MatchKey)) { continue; }
+
+				bRanked = false;
+				RunTaskPhase(EBenchmarkPhase::RankIncremental, Allocations, [this, MatchKey]() { Subsystem.RankSessions(MatchKey); }, [this]() { return bRanked; });
+			}
+
+			const double Elapsed = FPlatformTime::Seconds() - StartTime;
+			Report(NumCycles, Elapsed, Allocations, Ar);
+		}
+
+	private:
+
+		template<typename StartType, typename DoneType>
+		void RunPhase(EBenchmarkPhase Phase, const MultiplayerSessionAllocations::FScopedCount& Allocations, StartType&& Start, DoneType&& IsDone)
+		{
+			FPhaseSamples& Samples = Phases[static_cast<int32>(Phase)];
+
+			const uint64 AllocationsBefore = Allocations.GetNumAllocations();
+			const uint64 BytesBefore = Allocations.GetBytesAllocated();
+			const double PhaseStart = FPlatformTime::Seconds();
+
+			Start();
+
+			int32 Tick = 0;
+			for (; Tick < MaxTicksPerPhase && !IsDone(); ++Tick)
+			{
+				Mock->Tick(TickSeconds);
+			}
+
+			// everything ran right here
+			const double Time = (FPlatformTime::Seconds() - PhaseStart) * 1000000.0;
+			Samples.Times.Add(Time);
+			Samples.GameThreadTimes.Add(Time);
+			Samples.NumAllocations += Allocations.GetNumAllocations() - AllocationsBefore;
+			Samples.BytesAllocated += Allocations.GetBytesAllocated() - BytesBefore;
+
+			if (!IsDone())
+			{
+				++Samples.NumTimedOut;
+
+				// don't let a stuck op leak into the next phase
+				Subsystem.CancelPendingSessionOps(SessionName);
+				Subsystem.CancelFindSessions();
+			}
+		}
+
+		// A phase finished by tasks the game thread hands off. Waits in real time, only Start() and the game thread
+		// tasks it gets back count as game thread time.
+		template<typename StartType, typename DoneType>
+		void RunTaskPhase(EBenchmarkPhase Phase, const MultiplayerSessionAllocations::FScopedCount& Allocations, StartType&& Start, DoneType&& IsDone)
+		{
+			FPhaseSamples& Samples = Phases[static_cast<int32>(Phase)];
+
+			const uint64 AllocationsBefore = Allocations.GetNumAllocations();
+			const uint64 BytesBefore = Allocations.GetBytesAllocated();
+			const double PhaseStart = FPlatformTime::Seconds();
+
+			Start();
+
+			double GameThreadTime = FPlatformTime::Seconds() - PhaseStart;
+			while (!IsDone() && FPlatformTime::Seconds() - PhaseStart < MaxTaskPhaseSeconds)
+			{
+				FPlatformProcess::SleepNoStats(TaskPollSeconds);
+
+				const double PumpStart = FPlatformTime::Seconds();
+				FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+				GameThreadTime += FPlatformTime::Seconds() - PumpStart;
+			}
+
+			Samples.Times.Add((FPlatformTime::Seconds() - PhaseStart) * 1000000.0);
+			Samples.GameThreadTimes.Add(GameThreadTime * 1000000.0);
+			Samples.NumAllocations += Allocations.GetNumAllocations() - AllocationsBefore;
+			Samples.BytesAllocated += Allocations.GetBytesAllocated() - BytesBefore;
+
+			if (!IsDone())
+			{
+				++Samples.NumTimedOut;
+			}
+		}
+
+		void Report(int32 NumCycles, double Elapsed, const MultiplayerSessionAllocations::FScopedCount& Allocations, FOutputDevice& Ar)
+		{
+			const FMockOnlineSessionConfig& Config = Mock->GetConfig();
+			Ar.Logf(TEXT("MultiplayerSessions benchmark: %d cycles, %d advertised sessions, %.0f-%.0fms simulated latency, %.1f%% failures"),
+				NumCycles, Config.NumAdvertisedSessions, Config.MinLatency * 1000.0, Config.MaxLatency * 1000.0, Config.FailureRate * 100.f);
+			Ar.Logf(TEXT("%.3fs wall, %.1f cycles/s, %llu allocations (%llu bytes) on the game thread"),
+				Elapsed, NumCycles / FMath::Max(Elapsed, 1e-9), Allocations.GetNumAllocations(), Allocations.GetBytesAllocated());
+
+			// the number to watch: it must not grow with the number of advertised sessions
+			const FPhaseSamples& Find = Phases[static_cast<int32>(EBenchmarkPhase::Find)];
+			const FPhaseSamples& Join = Phases[static_cast<int32>(EBenchmarkPhase::Join)];
+			Ar.Logf(TEXT("search and join: %.1f allocs (%.0f bytes) per cycle"),
+				static_cast<double>(Find.NumAllocations + Join.NumAllocations) / NumCycles,
+				static_cast<double>(Find.BytesAllocated + Join.BytesAllocated) / NumCycles);
+
+			for (FPhaseSamples& Samples : Phases)
+			{
+				Samples.Times.Sort();
+				Samples.GameThreadTimes.Sort();
+			}
+
+			const auto Percentile = [](const TArray<double>& Times, double P)
+			{
+				return Times.Num() ? Times[FMath::Clamp(FMath::CeilToInt(P * Times.Num()) - 1, 0, Times.Num() - 1)] : 0.0;
+			};
+
+			// and this one must level off: decoding and scoring a large result set happens on worker threads
+			const FPhaseSamples& Rank = Phases[static_cast<int32>(EBenchmarkPhase::Rank)];
+			Ar.Logf(TEXT("game thread per search: find p50=%.1fus rank p50=%.1fus"), Percentile(Find.GameThreadTimes, 0.5), Percentile(Rank.GameThreadTimes, 0.5));
+
+			const FPhaseSamples& FindIncremental = Phases[static_cast<int32>(EBenchmarkPhase::FindIncremental)];
+			const FPhaseSamples& RankIncremental = Phases[static_cast<int32>(EBenchmarkPhase::RankIncremental)];
+			Ar.Logf(TEXT("game thread per incremental search: find p50=%.1fus rank p50=%.1fus"),
+				Percentile(FindIncremental.GameThreadTimes, 0.5), Percentile(RankIncremental.GameThreadTimes, 0.5));
+
+			for (int32 Phase = 0; Phase < static_cast<int32>(EBenchmarkPhase::Num); ++Phase)
+			{
+				const FPhaseSamples& Samples = Phases[Phase];
+				if(Samples.Times.Num() == 0) { continue; }
+
+				const int32 Num = Samples.Times.Num();
+				Ar.Logf(TEXT("%-8s n=%d p50=%.1fus p95=%.1fus p99=%.1fus game thread p50=%.1fus %.1f allocs/op %.0f bytes/op timed out=%d"),
+					GetPhaseName(static_cast<EBenchmarkPhase>(Phase)), Num, Percentile(Samples.Times, 0.5), Percentile(Samples.Times, 0.95),
+					Percentile(Samples.Times, 0.99), Percentile(Samples.GameThreadTimes, 0.5),
+					static_cast<double>(Samples.NumAllocations) / Num, static_cast<double>(Samples.BytesAllocated) / Num, Samples.NumTimedOut);
+			}
+
+			// outcomes by result code as the subsystem saw them
+			Subsystem.GetSessionMetrics().Dump(Ar);
+		}
+
+		static constexpr float TickSeconds = 0.005f;
+		static constexpr int32 MaxSearchResults = 10000;
+		static constexpr double MaxTaskPhaseSeconds = 5.0;
+		static constexpr float TaskPollSeconds = 0.0005f;
+		const FName SessionName{TEXT("MultiplayerSessionsBenchmark")};
+
+		UMultiplayerSessionsSubsystem& Subsystem;
+		TSharedRef<FMockOnlineSession, ESPMode::ThreadSafe> Mock;
+		int32 MaxTicksPerPhase{16};
+
+		FDelegateHandle FindHandle;
+		FDelegateHandle PageHandle;
+		FDelegateHandle RankHandle;
+		bool bFindComplete{false};
+		bool bRanked{false};
+
+		FPhaseSamples Phases[static_cast<int32>(EBenchmarkPhase::Num)];
+	};
+
+	FAutoConsoleCommandWithWorldArgsAndOutputDevice BenchmarkCommand(
+		TEXT("MultiplayerSessions.Benchmark"),
+		TEXT("Run create/find/join cycles against a mock online session. Args: [Cycles=1000] [Sessions=100] [LatencySeconds=0.02] [FailureRate=0] [cache]"),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+		{
+			const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+			UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+			if (!Subsystem)
+			{
+				Ar.Log(TEXT("MultiplayerSessions.Benchmark needs a game instance"));
+				return;
+			}
+
+			const int32 NumCycles = Args.IsValidIndex(0) ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 1000;
+
+			FMockOnlineSessionConfig Config;
+			Config.bManualTick = true;
+			Config.NumAdvertisedSessions = Args.IsValidIndex(1) ? FMath::Max(FCString::Atoi(*Args[1]), 0) : 100;
+			Config.MaxLatency = Args.IsValidIndex(2) ? FMath::Max(FCString::Atod(*Args[2]), 0.0) : 0.02;
+			Config.MinLatency = Config.MaxLatency * 0.5;
+			Config.FailureRate = Args.IsValidIndex(3) ? FMath::Clamp(FCString::Atof(*Args[3]), 0.f, 1.f) : 0.f;
+
+			// real pings would make the ranking wait on the network
+			Config.bPingableHosts = false;
+
+			const bool bUseSearchCache = Args.Contains(TEXT("cache"));
+
+			FSessionBenchmark Benchmark(*Subsystem, Config);
+			Benchmark.Run(NumCycles, bUseSearchCache, Ar);
+		}));
+}
+
+#endif
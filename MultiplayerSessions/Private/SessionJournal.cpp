@@ -0,0 +1,285 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionJournal.h"
+
+#include "HAL/Event.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+/*
+ * File layout, little endian:
+ *
+ *	header		uint32 magic, uint8 version, int64 UTC ticks of the start
+ *	name		uint8 0xFF, uint16 index, uint8 length, UTF-8 bytes. Precedes the first entry of every session name.
+ *	entry		uint8 event, uint8 op, uint8 outcome, uint16 name index, uint64 microseconds since the start,
+ *				int32 value, float latency in ms
+ *
+ * A crash can cut the last entry short, loading stops at the first incomplete one.
+ */
+namespace
+{
+	// "MSJN"
+	constexpr uint32 JournalMagic = 0x4D534A4E;
+	constexpr uint8 JournalVersion = 1;
+
+	constexpr uint8 NameRecord = 0xFF;
+	constexpr uint16 NoName = MAX_uint16;
+}
+
+class FMultiplayerSessionJournal::FWriter : public FRunnable
+{
+public:
+
+	FWriter(FMultiplayerSessionJournal& InJournal, IFileHandle* InFile, float InFlushInterval) :
+		Journal(InJournal),
+		File(InFile),
+		FlushIntervalMs(FMath::Max(FMath::RoundToInt(InFlushInterval * 1000.f), 1)),
+		WakeUp(FPlatformProcess::GetSynchEventFromPool(false))
+	{
+		uint32 Magic = JournalMagic;
+		uint8 Version = JournalVersion;
+		int64 StartTicks = FDateTime::UtcNow().GetTicks();
+
+		FMemoryWriter Ar(Buffer);
+		Ar << Magic << Version << StartTicks;
+		WriteBuffer();
+	}
+
+	virtual ~FWriter() override
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WakeUp);
+		delete File;
+	}
+
+	virtual uint32 Run() override
+	{
+		while (!bStopping.load(std::memory_order_acquire))
+		{
+			WakeUp->Wait(FlushIntervalMs);
+			Drain();
+		}
+
+		// whatever was recorded before Stop() returned
+		Drain();
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		bStopping.store(true, std::memory_order_release);
+		WakeUp->Trigger();
+	}
+
+private:
+
+	void Drain()
+	{
+		const uint64 End = Journal.Head.load(std::memory_order_acquire);
+		uint64 Read = Journal.Tail.load(std::memory_order_relaxed);
+		if(Read == End) { return; }
+
+		FMemoryWriter Ar(Buffer);
+		for (; Read != End; ++Read)
+		{
+			WriteEntry(Ar, Journal.Ring[Read & Journal.RingMask]);
+		}
+
+		// everything is copied out, the game thread may reuse the slots
+		Journal.Tail.store(End, std::memory_order_release);
+
+		WriteBuffer();
+	}
+
+	void WriteEntry(FArchive& Ar, const FMultiplayerSessionJournalEntry& Entry)
+	{
+		uint16 NameIndex = NoName;
+		if (!Entry.SessionName.IsNone())
+		{
+			if (const uint16* Existing = NameIndices.Find(Entry.SessionName))
+			{
+				NameIndex = *Existing;
+			}
+			else if (NameIndices.Num() < NoName)
+			{
+				NameIndex = static_cast<uint16>(NameIndices.Num());
+				NameIndices.Add(Entry.SessionName, NameIndex);
+
+				const FString Name = Entry.SessionName.ToString();
+				FTCHARToUTF8 Utf8(*Name);
+				uint8 Kind = NameRecord;
+				uint8 Length = static_cast<uint8>(FMath::Min(Utf8.Length(), static_cast<int32>(MAX_uint8)));
+
+				Ar << Kind << NameIndex << Length;
+				Ar.Serialize(const_cast<ANSICHAR*>(Utf8.Get()), Length);
+			}
+		}
+
+		uint8 Event = static_cast<uint8>(Entry.Event);
+		uint8 Op = static_cast<uint8>(Entry.Op);
+		uint8 Outcome = static_cast<uint8>(Entry.Outcome);
+		uint64 TimeMicros = static_cast<uint64>(FMath::Max(Entry.Time, 0.0) * 1000000.0);
+		int32 Value = Entry.Value;
+		float LatencyMs = Entry.LatencyMs;
+
+		Ar << Event << Op << Outcome << NameIndex << TimeMicros << Value << LatencyMs;
+	}
+
+	void WriteBuffer()
+	{
+		if (Buffer.Num() > 0)
+		{
+			File->Write(Buffer.GetData(), Buffer.Num());
+			File->Flush();
+		}
+		Buffer.Reset();
+	}
+
+	FMultiplayerSessionJournal& Journal;
+	IFileHandle* File;
+	uint32 FlushIntervalMs;
+	FEvent* WakeUp;
+	std::atomic<bool> bStopping{false};
+
+	TMap<FName, uint16> NameIndices;
+	TArray<uint8> Buffer;
+};
+
+FMultiplayerSessionJournal::FMultiplayerSessionJournal() = default;
+
+FMultiplayerSessionJournal::~FMultiplayerSessionJournal()
+{
+	Stop();
+}
+
+bool FMultiplayerSessionJournal::Start(const FString& InPath, int32 Capacity, float FlushInterval)
+{
+	Stop();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(InPath));
+
+	IFileHandle* File = PlatformFile.OpenWrite(*InPath);
+	if(!File) { return false; }
+
+	Path = InPath;
+	StartTime = FPlatformTime::Seconds();
+
+	Ring.SetNum(FMath::RoundUpToPowerOfTwo(static_cast<uint32>(FMath::Max(Capacity, 2))));
+	RingMask = Ring.Num() - 1;
+	Head.store(0, std::memory_order_relaxed);
+	Tail.store(0, std::memory_order_relaxed);
+	NumDropped.store(0, std::memory_order_relaxed);
+
+	Writer = MakeUnique<FWriter>(*this, File, FlushInterval);
+	Thread = FRunnableThread::Create(Writer.Get(), TEXT("MultiplayerSessionsJournal"), 0, TPri_BelowNormal);
+	if (!Thread)
+	{
+		Writer.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+void FMultiplayerSessionJournal::Stop()
+{
+	if(!Thread) { return; }
+
+	// stops the writer and waits for its last drain
+	Thread->Kill(true);
+	delete Thread;
+	Thread = nullptr;
+	Writer.Reset();
+}
+
+void FMultiplayerSessionJournal::Record(EMultiplayerSessionJournalEvent Event, EMultiplayerSessionMetricOp Op, FName SessionName,
+	EMultiplayerSessionOpOutcome Outcome, int32 Value, double LatencyMs)
+{
+	if(!Thread || bSuspended) { return; }
+
+	const uint64 Write = Head.load(std::memory_order_relaxed);
+	if (Write - Tail.load(std::memory_order_acquire) > RingMask)
+	{
+		NumDropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	FMultiplayerSessionJournalEntry& Entry = Ring[Write & RingMask];
+	Entry.Time = FPlatformTime::Seconds() - StartTime;
+	Entry.SessionName = SessionName;
+	Entry.Event = Event;
+	Entry.Op = Op;
+	Entry.Outcome = Outcome;
+	Entry.Value = Value;
+	Entry.LatencyMs = static_cast<float>(LatencyMs);
+
+	Head.store(Write + 1, std::memory_order_release);
+}
+
+bool FMultiplayerSessionJournal::Load(const FString& Path, TArray<FMultiplayerSessionJournalEntry>& OutEntries)
+{
+	TArray<uint8> Data;
+	if(!FFileHelper::LoadFileToArray(Data, *Path)) { return false; }
+
+	FMemoryReader Ar(Data);
+
+	uint32 Magic = 0;
+	uint8 Version = 0;
+	int64 StartTicks = 0;
+	Ar << Magic << Version << StartTicks;
+	if(Ar.IsError() || Magic != JournalMagic || Version != JournalVersion) { return false; }
+
+	TArray<FName> Names;
+
+	while (!Ar.AtEnd())
+	{
+		uint8 Kind = 0;
+		Ar << Kind;
+
+		if (Kind == NameRecord)
+		{
+			uint16 NameIndex = 0;
+			uint8 Length = 0;
+			Ar << NameIndex << Length;
+			if(Ar.IsError() || Ar.Tell() + Length > Data.Num()) { break; }
+
+			const FUTF8ToTCHAR Name(reinterpret_cast<const ANSICHAR*>(Data.GetData() + Ar.Tell()), Length);
+			Ar.Seek(Ar.Tell() + Length);
+
+			Names.SetNum(FMath::Max(Names.Num(), NameIndex + 1));
+			Names[NameIndex] = FName(Name.Length(), Name.Get());
+			continue;
+		}
+
+		uint8 Op = 0;
+		uint8 Outcome = 0;
+		uint16 NameIndex = NoName;
+		uint64 TimeMicros = 0;
+		int32 Value = 0;
+		float LatencyMs = 0.f;
+		Ar << Op << Outcome << NameIndex << TimeMicros << Value << LatencyMs;
+
+		if(Ar.IsError()) { break; }
+
+		// written by a newer build, or not a journal past this point
+		if(Kind >= static_cast<uint8>(EMultiplayerSessionJournalEvent::Num) || Op >= static_cast<uint8>(EMultiplayerSessionMetricOp::Num) ||
+			Outcome >= static_cast<uint8>(EMultiplayerSessionOpOutcome::Num)) { break; }
+
+		FMultiplayerSessionJournalEntry& Entry = OutEntries.AddDefaulted_GetRef();
+		Entry.Time = TimeMicros / 1000000.0;
+		Entry.SessionName = Names.IsValidIndex(NameIndex) ? Names[NameIndex] : NAME_None;
+		Entry.Event = static_cast<EMultiplayerSessionJournalEvent>(Kind);
+		Entry.Op = static_cast<EMultiplayerSessionMetricOp>(Op);
+		Entry.Outcome = static_cast<EMultiplayerSessionOpOutcome>(Outcome);
+		Entry.Value = Value;
+		Entry.LatencyMs = LatencyMs;
+	}
+
+	return true;
+}
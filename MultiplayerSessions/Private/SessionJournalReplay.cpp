@@ -0,0 +1,272 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "MockOnlineSession.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "SessionJournal.h"
+
+#if !UE_BUILD_SHIPPING
+
+/* JOURNAL REPLAY
+ * ====================================================================================================================
+ *
+ *	Feeds a journal recorded by FMultiplayerSessionJournal back into UMultiplayerSessionsSubsystem against a
+ *	FMockOnlineSession, to reproduce a timing problem a player or a test box ran into on one machine:
+ *
+ *		MultiplayerSessions.ReplayJournal Saved/Logs/MultiplayerSessions-2024.01.01-12.00.00-1234-0.msjournal
+ *
+ *	Every op the journal saw the online service complete is scripted into the mock in order, with the latency,
+ *	outcome and (for searches) result count it had. The ops that were requested are then issued again at the time
+ *	they were requested, in real time, so the subsystem's own timers (quick match deadlines, update batching, join
+ *	retries) interleave with the completions the way they did. A join goes to the first result of the last search.
+ *	Ops the subsystem didn't send when the journal was recorded (rejected, coalesced, served from the cache) aren't
+ *	scripted, if the replay sends them anyway the mock rolls their latency as usual.
+ *
+ *	Once everything has been issued and completed the recorded and replayed metrics are logged side by side.
+ *	The live journal is suspended while a replay runs.
+ *
+ * ====================================================================================================================
+ */
+namespace
+{
+	class FSessionJournalReplay
+	{
+	public:
+
+		FSessionJournalReplay(UMultiplayerSessionsSubsystem& InSubsystem, TArray<FMultiplayerSessionJournalEntry>&& InEntries) :
+			Subsystem(&InSubsystem),
+			Entries(MoveTemp(InEntries))
+		{
+			FMockOnlineSessionConfig Config;
+
+			// enough advertised sessions for the largest search of the journal
+			Config.NumAdvertisedSessions = 1;
+			for (const FMultiplayerSessionJournalEntry& Entry : Entries)
+			{
+				if (Entry.Op == EMultiplayerSessionMetricOp::Find && Entry.Event == EMultiplayerSessionJournalEvent::Completed)
+				{
+					Config.NumAdvertisedSessions = FMath::Max(Config.NumAdvertisedSessions, Entry.Value);
+				}
+			}
+
+			Mock = MakeShared<FMockOnlineSession, ESPMode::ThreadSafe>(Config);
+			ScriptMock();
+
+			Filter.MatchType = Config.AdvertisedMatchType;
+
+			InSubsystem.GetSessionJournal().SetSuspended(true);
+			InSubsystem.OverrideSessionInterface(Mock, Mock->GetLocalUserId());
+			InSubsystem.ResetSessionMetrics();
+
+			StartTime = FPlatformTime::Seconds();
+			EndTime = (Entries.Num() ? Entries.Last().Time : 0.0) + ReplayTimeout;
+		}
+
+		~FSessionJournalReplay()
+		{
+			if (UMultiplayerSessionsSubsystem* Live = Subsystem.Get())
+			{
+				Live->OverrideSessionInterface(nullptr);
+				Live->GetSessionJournal().SetSuspended(false);
+			}
+		}
+
+		// False once the replay has finished
+		bool Tick()
+		{
+			UMultiplayerSessionsSubsystem* Live = Subsystem.Get();
+			if(!Live) { return false; }
+
+			const double Time = FPlatformTime::Seconds() - StartTime;
+
+			for (; NextEntry < Entries.Num() && Entries[NextEntry].Time <= Time; ++NextEntry)
+			{
+				const FMultiplayerSessionJournalEntry& Entry = Entries[NextEntry];
+				if (Entry.Event == EMultiplayerSessionJournalEvent::Requested)
+				{
+					Issue(*Live, Entry);
+				}
+			}
+
+			const bool bAllIssued = NextEntry >= Entries.Num();
+			const bool bAllIdle = Mock->GetNumPendingCalls() == 0 && !SessionNames.ContainsByPredicate(
+				[Live](FName SessionName) { return !Live->IsSessionIdle(SessionName); });
+
+			if ((bAllIssued && bAllIdle) || Time > EndTime)
+			{
+				Report(*Live, Time, *GLog);
+				return false;
+			}
+
+			return true;
+		}
+
+		int32 GetNumEntries() const { return Entries.Num(); }
+		double GetDuration() const { return Entries.Num() ? Entries.Last().Time : 0.0; }
+
+	private:
+
+		void ScriptMock()
+		{
+			// ops sent to the online service and not completed yet, by op and session
+			TMap<TPair<EMultiplayerSessionMetricOp, FName>, int32> InFlight;
+
+			for (const FMultiplayerSessionJournalEntry& Entry : Entries)
+			{
+				const TPair<EMultiplayerSessionMetricOp, FName> Key(Entry.Op, Entry.SessionName);
+
+				if (Entry.Event == EMultiplayerSessionJournalEvent::Sent)
+				{
+					++InFlight.FindOrAdd(Key);
+				}
+				else if (Entry.Event == EMultiplayerSessionJournalEvent::Completed)
+				{
+					int32* NumInFlight = InFlight.Find(Key);
+					if(!NumInFlight || *NumInFlight <= 0) { continue; }
+					--*NumInFlight;
+
+					// cancelled by the subsystem, not turned down by the service
+					const EMultiplayerSessionOpOutcome Outcome = Entry.Outcome == EMultiplayerSessionOpOutcome::Cancelled ?
+						EMultiplayerSessionOpOutcome::Success : Entry.Outcome;
+					const int32 NumResults = Entry.Op == EMultiplayerSessionMetricOp::Find ? Entry.Value : INDEX_NONE;
+
+					Mock->AddScriptedCall(Entry.Op, Entry.LatencyMs / 1000.0, Outcome, NumResults);
+				}
+			}
+		}
+
+		void Issue(UMultiplayerSessionsSubsystem& Live, const FMultiplayerSessionJournalEntry& Entry)
+		{
+			if (!Entry.SessionName.IsNone())
+			{
+				SessionNames.AddUnique(Entry.SessionName);
+			}
+
+			switch (Entry.Op)
+			{
+			case EMultiplayerSessionMetricOp::Create:
+				Live.CreateSession(Entry.SessionName, Mock->GetConfig().MaxSlotsPerSession, Filter.MatchType);
+				break;
+			case EMultiplayerSessionMetricOp::Find:
+				Live.FindSessions(MaxSearchResults, Filter);
+				break;
+			case EMultiplayerSessionMetricOp::Join:
+				if (const FOnlineSessionSearchResult* Result = Live.GetSearchResult(0))
+				{
+					Live.JoinSession(Entry.SessionName, *Result);
+				}
+				else
+				{
+					++NumSkipped;
+				}
+				break;
+			case EMultiplayerSessionMetricOp::Destroy:
+				Live.DestroySession(Entry.SessionName);
+				break;
+			case EMultiplayerSessionMetricOp::Start:
+				Live.StartSession(Entry.SessionName);
+				break;
+			default:
+				// updates are sent by the subsystem itself, nobody requests them
+				break;
+			}
+		}
+
+		void Report(const UMultiplayerSessionsSubsystem& Live, double Elapsed, FOutputDevice& Ar) const
+		{
+			FMultiplayerSessionMetrics Recorded;
+			for (const FMultiplayerSessionJournalEntry& Entry : Entries)
+			{
+				if(Entry.Event != EMultiplayerSessionJournalEvent::Completed) { continue; }
+
+				if (Entry.LatencyMs > 0.f)
+				{
+					Recorded.RecordCompletion(Entry.Op, Entry.Outcome, 0.0, Entry.LatencyMs / 1000.0);
+				}
+				else
+				{
+					Recorded.RecordOutcome(Entry.Op, Entry.Outcome);
+				}
+			}
+
+			Ar.Logf(TEXT("MultiplayerSessions journal replay: %d events over %.2fs replayed in %.2fs, %d joins skipped without a search result, %d scripted calls unused"),
+				Entries.Num(), GetDuration(), Elapsed, NumSkipped, Mock->GetNumScriptedCalls());
+			Ar.Log(TEXT("recorded:"));
+			Recorded.Dump(Ar);
+			Ar.Log(TEXT("replayed:"));
+			Live.GetSessionMetrics().Dump(Ar);
+		}
+
+		// Seconds a replay may run past the last event before it's given up on
+		static constexpr double ReplayTimeout = 30.0;
+		static constexpr int32 MaxSearchResults = 10000;
+
+		TWeakObjectPtr<UMultiplayerSessionsSubsystem> Subsystem;
+		TSharedPtr<FMockOnlineSession, ESPMode::ThreadSafe> Mock;
+		TArray<FMultiplayerSessionJournalEntry> Entries;
+		FMultiplayerSessionSearchFilter Filter;
+
+		TArray<FName> SessionNames;
+		int32 NextEntry{0};
+		int32 NumSkipped{0};
+		double StartTime{0.0};
+		double EndTime{0.0};
+	};
+
+	TUniquePtr<FSessionJournalReplay> ActiveReplay;
+	FTSTicker::FDelegateHandle ReplayTickHandle;
+
+	void StopReplay()
+	{
+		if (ReplayTickHandle.IsValid())
+		{
+			FTSTicker::GetCoreTicker().RemoveTicker(ReplayTickHandle);
+			ReplayTickHandle.Reset();
+		}
+		ActiveReplay.Reset();
+	}
+
+	FAutoConsoleCommandWithWorldArgsAndOutputDevice ReplayJournalCommand(
+		TEXT("MultiplayerSessions.ReplayJournal"),
+		TEXT("Replay a session journal against a mock online session in real time and log recorded vs replayed metrics. Args: <Path> | stop"),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+		{
+			StopReplay();
+			if(Args.Num() == 0 || Args[0] == TEXT("stop")) { return; }
+
+			const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+			UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+			if (!Subsystem)
+			{
+				Ar.Log(TEXT("MultiplayerSessions.ReplayJournal needs a game instance"));
+				return;
+			}
+
+			TArray<FMultiplayerSessionJournalEntry> Entries;
+			if (!FMultiplayerSessionJournal::Load(Args[0], Entries))
+			{
+				Ar.Logf(TEXT("MultiplayerSessions.ReplayJournal: %s isn't a session journal"), *Args[0]);
+				return;
+			}
+
+			ActiveReplay = MakeUnique<FSessionJournalReplay>(*Subsystem, MoveTemp(Entries));
+			Ar.Logf(TEXT("MultiplayerSessions.ReplayJournal: replaying %d events over %.2fs"), ActiveReplay->GetNumEntries(), ActiveReplay->GetDuration());
+
+			ReplayTickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([](float DeltaTime)
+			{
+				if (ActiveReplay.IsValid() && ActiveReplay->Tick()) { return true; }
+
+				// returning false removes the ticker
+				ReplayTickHandle.Reset();
+				ActiveReplay.Reset();
+				return false;
+			}));
+		}));
+}
+
+#endif
@@ -0,0 +1,339 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionLANBeacon.h"
+
+#include "Common/UdpSocketBuilder.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "IPAddress.h"
+#include "OnlineSessionSettings.h"
+#include "OnlineSubsystemTypes.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "SessionAttributes.h"
+#include "SessionSearchIndex.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+namespace
+{
+	const FName LANBeaconNetIdType(TEXT("LANBEACON"));
+
+	// "MSLB"
+	constexpr uint32 BeaconMagic = 0x4D534C42;
+
+	// header and fixed fields plus a map name of up to 255 bytes
+	constexpr int32 MaxBeaconSize = 512;
+
+	enum EBeaconFlags : uint8
+	{
+		Dedicated = 1 << 0,
+		QuickMatch = 1 << 1,
+		HasRegion = 1 << 2,
+		Withdrawn = 1 << 3
+	};
+
+	class FLANBeaconSessionInfo : public FOnlineSessionInfo
+	{
+	public:
+
+		FLANBeaconSessionInfo(const FMultiplayerSessionLANHost& Host) :
+			SessionId(FUniqueNetIdString::Create(Host.HostId.ToString(), LANBeaconNetIdType)), ConnectAddress(Host.ConnectAddress) {}
+
+		virtual const uint8* GetBytes() const override { return nullptr; }
+		virtual int32 GetSize() const override { return sizeof(FLANBeaconSessionInfo); }
+		virtual bool IsValid() const override { return true; }
+		virtual FString ToString() const override { return SessionId->ToString(); }
+		virtual FString ToDebugString() const override { return FString::Printf(TEXT("%s at %s"), *SessionId->ToString(), *ConnectAddress); }
+		virtual const FUniqueNetId& GetSessionId() const override { return *SessionId; }
+
+		const FString& GetConnectAddress() const { return ConnectAddress; }
+
+	private:
+
+		FUniqueNetIdRef SessionId;
+		FString ConnectAddress;
+	};
+}
+
+FMultiplayerSessionLANBeacon::~FMultiplayerSessionLANBeacon()
+{
+	Stop();
+}
+
+bool FMultiplayerSessionLANBeacon::Start(const FMultiplayerSessionLANBeaconConfig& InConfig)
+{
+	Stop();
+	Config = InConfig;
+
+	FIPv4Address GroupAddress;
+	if(!FIPv4Address::Parse(Config.GroupAddress, GroupAddress) || !GroupAddress.IsMulticastAddress()) { return false; }
+
+	FIPv4Address InterfaceAddress = FIPv4Address::Any;
+	if(!Config.MulticastInterface.IsEmpty() && !FIPv4Address::Parse(Config.MulticastInterface, InterfaceAddress)) { return false; }
+
+	// reusable so every process on the machine can bind the port and gets its own copy of each beacon
+	FUdpSocketBuilder Builder(TEXT("MultiplayerSessionsLANBeacon"));
+	Builder.AsNonBlocking()
+		.AsReusable()
+		.BoundToPort(static_cast<uint16>(Config.Port))
+		.JoinedToGroup(GroupAddress, InterfaceAddress)
+		.WithMulticastLoopback()
+		.WithMulticastTtl(1);
+
+	if (InterfaceAddress != FIPv4Address::Any)
+	{
+		Builder.WithMulticastInterface(InterfaceAddress);
+	}
+
+	Socket = Builder.Build();
+	if(!Socket) { return false; }
+
+	GroupAddr = FIPv4Endpoint(GroupAddress, static_cast<uint16>(Config.Port)).ToInternetAddr();
+	SenderAddr = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+	ReceiveBuffer.SetNumUninitialized(MaxBeaconSize);
+	OwnHostId = FGuid::NewGuid();
+	StartTime = FPlatformTime::Seconds();
+	NextAnnounceTime = 0.0;
+
+	return true;
+}
+
+void FMultiplayerSessionLANBeacon::Stop()
+{
+	if(!Socket) { return; }
+
+	// a last word so listeners don't keep offering a host that's gone
+	if (Announcement.IsSet())
+	{
+		SendBeacon(Announcement.GetValue(), true);
+		Announcement.Reset();
+	}
+
+	ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+	Socket = nullptr;
+
+	Hosts.Reset();
+	HostIndices.Reset();
+}
+
+void FMultiplayerSessionLANBeacon::Tick(double Now)
+{
+	if(!Socket) { return; }
+
+	uint32 PendingSize = 0;
+	while (Socket->HasPendingData(PendingSize))
+	{
+		int32 BytesRead = 0;
+		if(!Socket->RecvFrom(ReceiveBuffer.GetData(), ReceiveBuffer.Num(), BytesRead, *SenderAddr)) { break; }
+
+		ReceiveBeacon(ReceiveBuffer.GetData(), BytesRead, *SenderAddr, Now);
+	}
+
+	// walking backwards, the host moved into a removed one's place has been looked at already
+	for (int32 HostIndex = Hosts.Num() - 1; HostIndex >= 0; --HostIndex)
+	{
+		if (Now - Hosts[HostIndex].LastHeardTime > Config.HostTimeout)
+		{
+			RemoveHost(HostIndex);
+		}
+	}
+}
+
+void FMultiplayerSessionLANBeacon::Announce(const FMultiplayerSessionLANHost& Host, double Now)
+{
+	Announcement = Host;
+	Announcement->HostId = OwnHostId;
+
+	SendBeacon(Announcement.GetValue(), false);
+	NextAnnounceTime = Now + Config.AnnounceInterval;
+}
+
+void FMultiplayerSessionLANBeacon::Withdraw(double Now)
+{
+	if (Announcement.IsSet())
+	{
+		SendBeacon(Announcement.GetValue(), true);
+		Announcement.Reset();
+	}
+
+	NextAnnounceTime = Now + Config.AnnounceInterval;
+}
+
+const FMultiplayerSessionLANHost* FMultiplayerSessionLANBeacon::FindHost(const FGuid& HostId) const
+{
+	const int32* HostIndex = HostIndices.Find(HostId);
+	return HostIndex ? &Hosts[*HostIndex] : nullptr;
+}
+
+void FMultiplayerSessionLANBeacon::MakeSearchResults(const FMultiplayerSessionSearchFilter& Filter, int32 MaxSearchResults, TArray<FOnlineSessionSearchResult>& OutResults) const
+{
+	const uint32 MatchKey = FMultiplayerSessionSearchIndex::MakeMatchKey(Filter.MatchType);
+	const uint32 RegionKey = MultiplayerSessionAttributes::HashString(Filter.Region);
+
+	for (const FMultiplayerSessionLANHost& Host : Hosts)
+	{
+		if(OutResults.Num() >= MaxSearchResults) { break; }
+
+		// the same checks FMultiplayerSessionSearchFilter::ApplyTo() asks an online service for
+		if(!Filter.MatchType.IsEmpty() && Host.MatchKey != MatchKey) { continue; }
+		if(!Filter.Region.IsEmpty() && (!Host.bHasRegion || Host.RegionKey != RegionKey)) { continue; }
+		if(Host.NumOpenPublicConnections < Filter.MinOpenSlots) { continue; }
+		if(Host.bIsDedicated != Filter.bDedicatedServers) { continue; }
+		if(Filter.BuildUniqueId != 0 && Host.BuildUniqueId != Filter.BuildUniqueId) { continue; }
+
+		FOnlineSessionSearchResult& Result = OutResults.AddDefaulted_GetRef();
+
+		// a LAN host answers right away, actual pings are measured while ranking
+		Result.PingInMs = 0;
+		Result.Session.NumOpenPublicConnections = Host.NumOpenPublicConnections;
+		Result.Session.SessionInfo = MakeShared<FLANBeaconSessionInfo>(Host);
+
+		// encoded like the host's own settings, so the search index reads them the same way
+		FOnlineSessionSettings& Settings = Result.Session.SessionSettings;
+		Settings.NumPublicConnections = Host.NumPublicConnections;
+		Settings.bIsLANMatch = true;
+		Settings.bShouldAdvertise = true;
+		Settings.bIsDedicated = Host.bIsDedicated;
+		Settings.bUsesPresence = !Host.bIsDedicated;
+		Settings.BuildUniqueId = Host.BuildUniqueId;
+
+		using namespace MultiplayerSessionAttributes;
+		SetInt(Settings, EMultiplayerSessionAttribute::SchemaVersion, CurrentSchemaVersion);
+		SetInt(Settings, EMultiplayerSessionAttribute::MatchKey, Host.MatchKey);
+		SetInt(Settings, EMultiplayerSessionAttribute::QuickMatch, Host.bQuickMatch ? 1 : 0);
+		if (Host.bHasRegion)
+		{
+			SetInt(Settings, EMultiplayerSessionAttribute::RegionKey, Host.RegionKey);
+		}
+		if (!Host.MapName.IsEmpty())
+		{
+			SetString(Settings, EMultiplayerSessionAttribute::MapName, Host.MapName);
+		}
+	}
+}
+
+bool FMultiplayerSessionLANBeacon::IsBeaconResult(const FOnlineSessionSearchResult& Result)
+{
+	return Result.Session.SessionInfo.IsValid() && Result.Session.SessionInfo->GetSessionId().GetType() == LANBeaconNetIdType;
+}
+
+bool FMultiplayerSessionLANBeacon::GetConnectString(const FOnlineSessionSearchResult& Result, FString& OutConnectString)
+{
+	if(!IsBeaconResult(Result)) { return false; }
+
+	OutConnectString = static_cast<const FLANBeaconSessionInfo*>(Result.Session.SessionInfo.Get())->GetConnectAddress();
+	return true;
+}
+
+SIZE_T FMultiplayerSessionLANBeacon::GetAllocatedSize() const
+{
+	SIZE_T Size = Hosts.GetAllocatedSize() + HostIndices.GetAllocatedSize() + SendBuffer.GetAllocatedSize() + ReceiveBuffer.GetAllocatedSize();
+
+	for (const FMultiplayerSessionLANHost& Host : Hosts)
+	{
+		Size += Host.ConnectAddress.GetAllocatedSize() + Host.MapName.GetAllocatedSize();
+	}
+
+	return Size;
+}
+
+void FMultiplayerSessionLANBeacon::SendBeacon(const FMultiplayerSessionLANHost& Host, bool bWithdrawn)
+{
+	if(!Socket) { return; }
+
+	uint32 Magic = BeaconMagic;
+	uint8 Version = static_cast<uint8>(MultiplayerSessionAttributes::CurrentSchemaVersion);
+	FGuid HostId = Host.HostId;
+	uint16 Port = Host.Port;
+	uint32 MatchKey = Host.MatchKey;
+	uint32 RegionKey = Host.RegionKey;
+	int32 BuildUniqueId = Host.BuildUniqueId;
+	uint16 NumPublicConnections = static_cast<uint16>(FMath::Clamp(Host.NumPublicConnections, 0, MAX_uint16));
+	uint16 NumOpenPublicConnections = static_cast<uint16>(FMath::Clamp(Host.NumOpenPublicConnections, 0, MAX_uint16));
+	uint8 Flags = static_cast<uint8>((Host.bIsDedicated ? Dedicated : 0) | (Host.bQuickMatch ? QuickMatch : 0) | (Host.bHasRegion ? HasRegion : 0) | (bWithdrawn ? Withdrawn : 0));
+
+	// map package names are plain ASCII, a longer one than fits is left out rather than cut
+	FTCHARToUTF8 MapName(*Host.MapName);
+	uint8 MapNameLength = MapName.Length() <= MAX_uint8 ? static_cast<uint8>(MapName.Length()) : 0;
+
+	SendBuffer.Reset();
+	FMemoryWriter Writer(SendBuffer);
+	Writer << Magic << Version << HostId << Port << MatchKey << RegionKey << BuildUniqueId << NumPublicConnections << NumOpenPublicConnections << Flags;
+	Writer << MapNameLength;
+	Writer.Serialize(const_cast<ANSICHAR*>(MapName.Get()), MapNameLength);
+
+	int32 BytesSent = 0;
+	Socket->SendTo(SendBuffer.GetData(), SendBuffer.Num(), BytesSent, *GroupAddr);
+}
+
+void FMultiplayerSessionLANBeacon::ReceiveBeacon(const uint8* Data, int32 Size, const FInternetAddr& Sender, double Now)
+{
+	uint32 Magic = 0;
+	uint8 Version = 0;
+	FGuid HostId;
+	uint16 Port = 0;
+	uint32 MatchKey = 0;
+	uint32 RegionKey = 0;
+	int32 BuildUniqueId = 0;
+	uint16 NumPublicConnections = 0;
+	uint16 NumOpenPublicConnections = 0;
+	uint8 Flags = 0;
+	uint8 MapNameLength = 0;
+
+	FMemoryReaderView Reader(MakeArrayView(Data, Size));
+	Reader << Magic << Version << HostId << Port << MatchKey << RegionKey << BuildUniqueId << NumPublicConnections << NumOpenPublicConnections << Flags;
+	Reader << MapNameLength;
+
+	// anything else on our port, hosts speaking another schema version and our own announcements are ignored
+	if(Reader.IsError() || Magic != BeaconMagic || Version != MultiplayerSessionAttributes::CurrentSchemaVersion) { return; }
+	if(Reader.Tell() + MapNameLength > Size || HostId == OwnHostId) { return; }
+
+	if (Flags & Withdrawn)
+	{
+		if(const int32* HostIndex = HostIndices.Find(HostId)) { RemoveHost(*HostIndex); }
+		return;
+	}
+
+	int32 HostIndex = INDEX_NONE;
+	if (const int32* ExistingIndex = HostIndices.Find(HostId))
+	{
+		HostIndex = *ExistingIndex;
+	}
+	else
+	{
+		HostIndex = Hosts.AddDefaulted();
+		HostIndices.Add(HostId, HostIndex);
+	}
+
+	FMultiplayerSessionLANHost& Host = Hosts[HostIndex];
+	Host.HostId = HostId;
+	Host.Port = Port;
+	Host.ConnectAddress = FString::Printf(TEXT("%s:%d"), *Sender.ToString(false), Port);
+	Host.MatchKey = MatchKey;
+	Host.RegionKey = RegionKey;
+	Host.bHasRegion = (Flags & HasRegion) != 0;
+	Host.BuildUniqueId = BuildUniqueId;
+	Host.NumPublicConnections = NumPublicConnections;
+	Host.NumOpenPublicConnections = NumOpenPublicConnections;
+	Host.bIsDedicated = (Flags & Dedicated) != 0;
+	Host.bQuickMatch = (Flags & QuickMatch) != 0;
+	Host.LastHeardTime = Now;
+
+	const FUTF8ToTCHAR MapName(reinterpret_cast<const ANSICHAR*>(Data + Reader.Tell()), MapNameLength);
+	Host.MapName = FString(MapName.Length(), MapName.Get());
+}
+
+void FMultiplayerSessionLANBeacon::RemoveHost(int32 HostIndex)
+{
+	HostIndices.Remove(Hosts[HostIndex].HostId);
+
+	// fill the hole with the last host so the table stays dense
+	const int32 LastIndex = Hosts.Num() - 1;
+	if (HostIndex != LastIndex)
+	{
+		Hosts[HostIndex] = MoveTemp(Hosts[LastIndex]);
+		HostIndices[Hosts[HostIndex].HostId] = HostIndex;
+	}
+	Hosts.Pop(EAllowShrinking::No);
+}
@@ -0,0 +1,433 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "GameFramework/GameSession.h"
+#include "HAL/IConsoleManager.h"
+#include "MockOnlineSession.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "OnlineSessionSettings.h"
+#include "SessionSearchIndex.h"
+
+#if !UE_BUILD_SHIPPING
+
+/* SESSION LOAD TEST
+ * ====================================================================================================================
+ *
+ *	Many simulated clients search for, join and leave the one session this process hosts, in real time:
+ *
+ *		UnrealEditor-Cmd <Project>.uproject -game -nullrhi -nosound -unattended
+ *			-ExecCmds="MultiplayerSessions.LoadTest 2000 120, Quit"
+ *
+ *	Arguments: clients, seconds, capacity (AGameSession's MaxPlayers by default), simulated latency in seconds, failure
+ *	rate, seconds a client stays. The host is this game instance's UMultiplayerSessionsSubsystem hosting a dedicated
+ *	session on a FMockOnlineSession, every client gets a mock of its own that shares the host's sessions. One NULL
+ *	online subsystem per process can't stand in for thousands of players, the mock plays the LAN service instead.
+ *
+ *	A client searches, joins the first session the search index lets through (full and closed sessions are left
+ *	out the same way they are for players), stays a while, leaves and starts over. Once the service has let a client
+ *	in, the host admits it like AGameSession would: it is turned away if the host is full already, otherwise it's
+ *	queued for registration. That's where the host lags behind what it advertises, and clients get through the
+ *	service only to be turned away.
+ *
+ *	The host's share of the game thread is everything the subsystem does: completions of its own mock, its tickers
+ *	(registration batches, session updates, heartbeats) and admitting and dropping players. Divided by the admitted
+ *	joins that is the host's CPU per join, the number to size servers with.
+ *
+ * ====================================================================================================================
+ */
+namespace
+{
+	enum class EClientState : uint8
+	{
+		Idle,
+		Searching,
+		Joining,
+		Playing,
+		Leaving
+	};
+
+	struct FSimulatedClient
+	{
+		TSharedPtr<FMockOnlineSession, ESPMode::ThreadSafe> Session;
+		TSharedPtr<FOnlineSessionSearch> Search;
+		EClientState State{EClientState::Idle};
+
+		// Seconds into the run when the client acts next, and when it started looking for a session
+		double NextActionTime{0.0};
+		double SearchStartTime{0.0};
+	};
+
+	struct FLoadTestCounters
+	{
+		int32 NumSearches{0};
+		int32 NumSearchesFailed{0};
+
+		// Nothing joinable came back
+		int32 NumNoSession{0};
+		int32 NumJoinsAdmitted{0};
+
+		// The service turned the join down
+		int32 NumServiceFull{0};
+		int32 NumServiceGone{0};
+		int32 NumServiceFailed{0};
+
+		// The service let the client in, but the host was full
+		int32 NumHostFull{0};
+		int32 NumLeaves{0};
+	};
+
+	class FSessionLoadTest
+	{
+	public:
+
+		FSessionLoadTest(UMultiplayerSessionsSubsystem& InSubsystem, const FMockOnlineSessionConfig& Config, int32 NumClients) :
+			Subsystem(InSubsystem),
+			HostSession(MakeShared<FMockOnlineSession, ESPMode::ThreadSafe>(Config)),
+			Random(Config.RandomSeed)
+		{
+			Filter.MatchType = Config.AdvertisedMatchType;
+			Filter.bDedicatedServers = true;
+			MatchKey = FMultiplayerSessionSearchIndex::MakeMatchKey(Filter.MatchType);
+
+			Clients.SetNum(NumClients);
+			for (int32 ClientIndex = 0; ClientIndex < NumClients; ++ClientIndex)
+			{
+				FMockOnlineSessionConfig ClientConfig = Config;
+				ClientConfig.RandomSeed = Config.RandomSeed + ClientIndex + 1;
+				ClientConfig.LocalUserName = FString::Printf(TEXT("LoadTestClient%d"), ClientIndex);
+
+				FSimulatedClient& Client = Clients[ClientIndex];
+				Client.Session = MakeShared<FMockOnlineSession, ESPMode::ThreadSafe>(ClientConfig, *HostSession);
+
+				// the mocks go away with the test, and their delegates with them
+				Client.Session->AddOnFindSessionsCompleteDelegate_Handle(FOnFindSessionsCompleteDelegate::CreateLambda(
+					[this, ClientIndex](bool bWasSuccessful) { OnSearchComplete(ClientIndex, bWasSuccessful); }));
+				Client.Session->AddOnJoinSessionCompleteDelegate_Handle(FOnJoinSessionCompleteDelegate::CreateLambda(
+					[this, ClientIndex](FName, EOnJoinSessionCompleteResult::Type Result) { OnJoinComplete(ClientIndex, Result); }));
+				Client.Session->AddOnDestroySessionCompleteDelegate_Handle(FOnDestroySessionCompleteDelegate::CreateLambda(
+					[this, ClientIndex](FName, bool) { OnLeaveComplete(ClientIndex); }));
+			}
+
+			// this process isn't a server as far as the heartbeat can tell, keep advertising anyway
+			SavedMaxHeartbeatsNotServing = Subsystem.GetMaxHeartbeatsNotServing();
+			Subsystem.SetMaxHeartbeatsNotServing(MAX_int32);
+
+			Subsystem.OverrideSessionInterface(HostSession, HostSession->GetLocalUserId());
+		}
+
+		~FSessionLoadTest()
+		{
+			Subsystem.OverrideSessionInterface(nullptr);
+			Subsystem.SetMaxHeartbeatsNotServing(SavedMaxHeartbeatsNotServing);
+		}
+
+		void Run(int32 InCapacity, double Duration, double StaySeconds, FOutputDevice& Ar)
+		{
+			Subsystem.ResetSessionMetrics();
+			Capacity = InCapacity;
+			MeanStaySeconds = StaySeconds;
+
+			Subsystem.HostDedicatedSession(NAME_GameSession, Capacity, Filter.MatchType);
+			if (!WaitForHost())
+			{
+				Ar.Log(TEXT("MultiplayerSessions.LoadTest: the host session didn't come up"));
+				return;
+			}
+
+			// don't have every client search in the very first frame
+			const double RampUp = FMath::Min(Duration * 0.25, 10.0);
+			for (FSimulatedClient& Client : Clients)
+			{
+				Client.NextActionTime = Random.FRand() * RampUp;
+			}
+
+			const double StartTime = FPlatformTime::Seconds();
+			double LastTime = StartTime;
+
+			while (LastTime - StartTime < Duration)
+			{
+				FPlatformProcess::SleepNoStats(TickSeconds);
+
+				const double FrameTime = FPlatformTime::Seconds();
+				const float DeltaTime = static_cast<float>(FrameTime - LastTime);
+				LastTime = FrameTime;
+				Now = FrameTime - StartTime;
+
+				const double ClientStart = FPlatformTime::Seconds();
+				for (int32 ClientIndex = 0; ClientIndex < Clients.Num(); ++ClientIndex)
+				{
+					Clients[ClientIndex].Session->Tick(DeltaTime);
+					StepClient(ClientIndex);
+				}
+				ClientSeconds += FPlatformTime::Seconds() - ClientStart;
+
+				TickHost(DeltaTime);
+			}
+
+			const double Elapsed = FPlatformTime::Seconds() - StartTime;
+			Report(Elapsed, Ar);
+
+			// what the clients still hold is simply dropped with them, the host takes its session down properly
+			Subsystem.DestroySession(NAME_GameSession);
+			for (int32 Tick = 0; Tick < MaxWaitTicks && !Subsystem.IsSessionIdle(NAME_GameSession); ++Tick)
+			{
+				FPlatformProcess::SleepNoStats(TickSeconds);
+				TickHost(TickSeconds);
+			}
+		}
+
+	private:
+
+		bool WaitForHost()
+		{
+			for (int32 Tick = 0; Tick < MaxWaitTicks && !Subsystem.IsSessionIdle(NAME_GameSession); ++Tick)
+			{
+				FPlatformProcess::SleepNoStats(TickSeconds);
+				TickHost(TickSeconds);
+			}
+
+			HostSeconds = 0.0;
+			return Subsystem.GetSessionState(NAME_GameSession) == EMultiplayerSessionState::InProgress;
+		}
+
+		// Everything the host does between two frames, the tickers of its registration batches and session updates included
+		void TickHost(float DeltaTime)
+		{
+			const double HostStart = FPlatformTime::Seconds();
+
+			HostSession->Tick(DeltaTime);
+			FTSTicker::GetCoreTicker().Tick(DeltaTime);
+
+			HostSeconds += FPlatformTime::Seconds() - HostStart;
+		}
+
+		void StepClient(int32 ClientIndex)
+		{
+			FSimulatedClient& Client = Clients[ClientIndex];
+			if(Now < Client.NextActionTime) { return; }
+
+			if (Client.State == EClientState::Idle)
+			{
+				Client.Search = MakeShared<FOnlineSessionSearch>();
+				Client.Search->MaxSearchResults = MaxSearchResults;
+				Filter.ApplyTo(*Client.Search);
+
+				Client.State = EClientState::Searching;
+				Client.SearchStartTime = Now;
+				++Counters.NumSearches;
+
+				if (!Client.Session->FindSessions(*Client.Session->GetLocalUserId(), Client.Search.ToSharedRef()))
+				{
+					OnSearchComplete(ClientIndex, false);
+				}
+			}
+			else if (Client.State == EClientState::Playing)
+			{
+				Leave(ClientIndex, true);
+			}
+		}
+
+		void OnSearchComplete(int32 ClientIndex, bool bWasSuccessful)
+		{
+			FSimulatedClient& Client = Clients[ClientIndex];
+			if(Client.State != EClientState::Searching) { return; }
+
+			if (!bWasSuccessful)
+			{
+				++Counters.NumSearchesFailed;
+				Retry(Client);
+				return;
+			}
+
+			// the same filtering players get, closed and dead hosts never make it out of the index
+			SearchIndex.Reset(Filter);
+			SearchIndex.Append(Client.Search->SearchResults, 0);
+
+			const int32 ResultIndex = SearchIndex.FindFirst(MatchKey);
+			if (ResultIndex == INDEX_NONE || Client.Search->SearchResults[ResultIndex].Session.NumOpenPublicConnections <= 0)
+			{
+				++Counters.NumNoSession;
+				Retry(Client);
+				return;
+			}
+
+			Client.State = EClientState::Joining;
+			Client.Session->JoinSession(*Client.Session->GetLocalUserId(), NAME_GameSession, Client.Search->SearchResults[ResultIndex]);
+			Client.Search.Reset();
+		}
+
+		void OnJoinComplete(int32 ClientIndex, EOnJoinSessionCompleteResult::Type Result)
+		{
+			FSimulatedClient& Client = Clients[ClientIndex];
+			if(Client.State != EClientState::Joining) { return; }
+
+			if (Result != EOnJoinSessionCompleteResult::Success)
+			{
+				int32& Counter = Result == EOnJoinSessionCompleteResult::SessionIsFull ? Counters.NumServiceFull :
+					Result == EOnJoinSessionCompleteResult::SessionDoesNotExist ? Counters.NumServiceGone : Counters.NumServiceFailed;
+				++Counter;
+
+				Retry(Client);
+				return;
+			}
+
+			// the client connects, the host decides whether to keep it
+			const double HostStart = FPlatformTime::Seconds();
+			const bool bAdmitted = NumPlayersOnHost < Capacity;
+			if (bAdmitted)
+			{
+				++NumPlayersOnHost;
+				Subsystem.QueuePlayerRegistration(NAME_GameSession, Client.Session->GetLocalUserId(), true);
+			}
+			HostSeconds += FPlatformTime::Seconds() - HostStart;
+
+			if (!bAdmitted)
+			{
+				++Counters.NumHostFull;
+				Leave(ClientIndex, false);
+				return;
+			}
+
+			++Counters.NumJoinsAdmitted;
+			TimesToJoin.Add(Now - Client.SearchStartTime);
+
+			Client.State = EClientState::Playing;
+			Client.NextActionTime = Now + MeanStaySeconds * (0.5 + Random.FRand());
+		}
+
+		void Leave(int32 ClientIndex, bool bWasAdmitted)
+		{
+			FSimulatedClient& Client = Clients[ClientIndex];
+
+			if (bWasAdmitted)
+			{
+				const double HostStart = FPlatformTime::Seconds();
+				--NumPlayersOnHost;
+				Subsystem.QueuePlayerRegistration(NAME_GameSession, Client.Session->GetLocalUserId(), false);
+				HostSeconds += FPlatformTime::Seconds() - HostStart;
+
+				++Counters.NumLeaves;
+			}
+
+			Client.State = EClientState::Leaving;
+			if (!Client.Session->DestroySession(NAME_GameSession))
+			{
+				OnLeaveComplete(ClientIndex);
+			}
+		}
+
+		void OnLeaveComplete(int32 ClientIndex)
+		{
+			FSimulatedClient& Client = Clients[ClientIndex];
+			if(Client.State != EClientState::Leaving) { return; }
+
+			// a failed leave would keep the client in its session, take it out of it for good
+			Client.Session->RemoveNamedSession(NAME_GameSession);
+
+			Client.State = EClientState::Idle;
+			Client.NextActionTime = Now + MaxThinkSeconds * Random.FRand();
+		}
+
+		void Retry(FSimulatedClient& Client)
+		{
+			Client.Search.Reset();
+			Client.State = EClientState::Idle;
+			Client.NextActionTime = Now + MaxThinkSeconds * Random.FRand();
+		}
+
+		void Report(double Elapsed, FOutputDevice& Ar)
+		{
+			const FMockOnlineSessionConfig& Config = HostSession->GetConfig();
+			Ar.Logf(TEXT("MultiplayerSessions load test: %d clients, %d slots, %.1fs, %.0f-%.0fms simulated latency, %.1f%% failures"),
+				Clients.Num(), Capacity, Elapsed, Config.MinLatency * 1000.0, Config.MaxLatency * 1000.0, Config.FailureRate * 100.f);
+
+			const int32 NumJoins = FMath::Max(Counters.NumJoinsAdmitted, 1);
+			Ar.Logf(TEXT("%.1f joins/s, %.1f leaves/s, %d players at the end"),
+				Counters.NumJoinsAdmitted / Elapsed, Counters.NumLeaves / Elapsed, NumPlayersOnHost);
+			Ar.Logf(TEXT("host: %.1fus game thread per join, %.1f%% of the game thread"),
+				HostSeconds * 1000000.0 / NumJoins, HostSeconds * 100.0 / FMath::Max(Elapsed, 1e-9));
+			Ar.Logf(TEXT("clients (and the simulated service): %.1fus game thread per join"), ClientSeconds * 1000000.0 / NumJoins);
+
+			// every search is an attempt to get in, each ends in exactly one of these
+			const double NumAttempts = FMath::Max(Counters.NumSearches, 1);
+			Ar.Logf(TEXT("%d attempts: %.1f%% admitted, %.1f%% nothing joinable found, %.1f%% full at the service, %.1f%% turned away by the host, %.1f%% session gone, %.1f%% failed"),
+				Counters.NumSearches, Counters.NumJoinsAdmitted * 100.0 / NumAttempts, Counters.NumNoSession * 100.0 / NumAttempts,
+				Counters.NumServiceFull * 100.0 / NumAttempts, Counters.NumHostFull * 100.0 / NumAttempts,
+				Counters.NumServiceGone * 100.0 / NumAttempts, (Counters.NumSearchesFailed + Counters.NumServiceFailed) * 100.0 / NumAttempts);
+
+			TimesToJoin.Sort();
+			const auto Percentile = [this](double P)
+			{
+				return TimesToJoin.Num() ? TimesToJoin[FMath::Clamp(FMath::CeilToInt(P * TimesToJoin.Num()) - 1, 0, TimesToJoin.Num() - 1)] : 0.0;
+			};
+			Ar.Logf(TEXT("search to admitted: p50=%.0fms p95=%.0fms p99=%.0fms"), Percentile(0.5) * 1000.0, Percentile(0.95) * 1000.0, Percentile(0.99) * 1000.0);
+
+			// the host's own ops, session updates publishing the player count in particular
+			Subsystem.GetSessionMetrics().Dump(Ar);
+		}
+
+		static constexpr float TickSeconds = 0.005f;
+		static constexpr int32 MaxWaitTicks = 2000;
+		static constexpr int32 MaxSearchResults = 50;
+		static constexpr double MaxThinkSeconds = 1.0;
+
+		UMultiplayerSessionsSubsystem& Subsystem;
+		TSharedRef<FMockOnlineSession, ESPMode::ThreadSafe> HostSession;
+		TArray<FSimulatedClient> Clients;
+		FRandomStream Random;
+
+		FMultiplayerSessionSearchFilter Filter;
+		uint32 MatchKey{0};
+		FMultiplayerSessionSearchIndex SearchIndex;
+
+		int32 SavedMaxHeartbeatsNotServing{0};
+		int32 Capacity{0};
+		double MeanStaySeconds{10.0};
+
+		// Seconds since the start of the run
+		double Now{0.0};
+
+		int32 NumPlayersOnHost{0};
+		FLoadTestCounters Counters;
+		TArray<double> TimesToJoin;
+		double HostSeconds{0.0};
+		double ClientSeconds{0.0};
+	};
+
+	FAutoConsoleCommandWithWorldArgsAndOutputDevice LoadTestCommand(
+		TEXT("MultiplayerSessions.LoadTest"),
+		TEXT("Simulated clients search, join and leave a session hosted here. Args: [Clients=1000] [Seconds=60] [Capacity=GameSession MaxPlayers] [LatencySeconds=0.05] [FailureRate=0] [StaySeconds=10]"),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+		{
+			const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+			UMultiplayerSessionsSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<UMultiplayerSessionsSubsystem>() : nullptr;
+			if (!Subsystem)
+			{
+				Ar.Log(TEXT("MultiplayerSessions.LoadTest needs a game instance"));
+				return;
+			}
+
+			const int32 NumClients = Args.IsValidIndex(0) ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 1000;
+			const double Duration = Args.IsValidIndex(1) ? FMath::Max(FCString::Atod(*Args[1]), 1.0) : 60.0;
+			const int32 Capacity = Args.IsValidIndex(2) ? FMath::Max(FCString::Atoi(*Args[2]), 1) : GetDefault<AGameSession>()->MaxPlayers;
+			const double StaySeconds = Args.IsValidIndex(5) ? FMath::Max(FCString::Atod(*Args[5]), 0.0) : 10.0;
+
+			FMockOnlineSessionConfig Config;
+			Config.bManualTick = true;
+			Config.NumAdvertisedSessions = 0;
+			Config.MaxLatency = Args.IsValidIndex(3) ? FMath::Max(FCString::Atod(*Args[3]), 0.0) : 0.05;
+			Config.MinLatency = Config.MaxLatency * 0.5;
+			Config.FailureRate = Args.IsValidIndex(4) ? FMath::Clamp(FCString::Atof(*Args[4]), 0.f, 1.f) : 0.f;
+			Config.bStreamSearchResults = false;
+			Config.bPingableHosts = false;
+
+			FSessionLoadTest LoadTest(*Subsystem, Config, NumClients);
+			LoadTest.Run(Capacity, Duration, StaySeconds, Ar);
+		}));
+}
+
+#endif
@@ -0,0 +1,192 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionMetrics.h"
+
+#include "OnlineSessionSettings.h"
+#include "ProfilingDebugging/CountersTrace.h"
+
+namespace
+{
+	constexpr double HistogramMinInMs = 0.1;
+	constexpr double HistogramGrowth = 1.25;
+
+	const TCHAR* GetOpName(EMultiplayerSessionMetricOp Op)
+	{
+		switch (Op)
+		{
+		case EMultiplayerSessionMetricOp::Create: return TEXT("Create");
+		case EMultiplayerSessionMetricOp::Find: return TEXT("Find");
+		case EMultiplayerSessionMetricOp::Join: return TEXT("Join");
+		case EMultiplayerSessionMetricOp::Destroy: return TEXT("Destroy");
+		case EMultiplayerSessionMetricOp::Start: return TEXT("Start");
+		case EMultiplayerSessionMetricOp::Update: return TEXT("Update");
+		default: return TEXT("Unknown");
+		}
+	}
+
+	const TCHAR* GetOutcomeName(EMultiplayerSessionOpOutcome Outcome)
+	{
+		switch (Outcome)
+		{
+		case EMultiplayerSessionOpOutcome::Success: return TEXT("Success");
+		case EMultiplayerSessionOpOutcome::Failure: return TEXT("Failure");
+		case EMultiplayerSessionOpOutcome::Cancelled: return TEXT("Cancelled");
+		case EMultiplayerSessionOpOutcome::Rejected: return TEXT("Rejected");
+		case EMultiplayerSessionOpOutcome::SessionIsFull: return TEXT("SessionIsFull");
+		case EMultiplayerSessionOpOutcome::SessionDoesNotExist: return TEXT("SessionDoesNotExist");
+		case EMultiplayerSessionOpOutcome::CouldNotRetrieveAddress: return TEXT("CouldNotRetrieveAddress");
+		case EMultiplayerSessionOpOutcome::AlreadyInSession: return TEXT("AlreadyInSession");
+		default: return TEXT("Unknown");
+		}
+	}
+}
+
+// trace counters are compiled in wherever Unreal Insights can connect, shipping included
+TRACE_DECLARE_INT_COUNTER(MultiplayerSessions_OpsSucceeded, TEXT("MultiplayerSessions/OpsSucceeded"));
+TRACE_DECLARE_INT_COUNTER(MultiplayerSessions_OpsFailed, TEXT("MultiplayerSessions/OpsFailed"));
+TRACE_DECLARE_FLOAT_COUNTER(MultiplayerSessions_LastCreateMs, TEXT("MultiplayerSessions/LastCreateMs"));
+TRACE_DECLARE_FLOAT_COUNTER(MultiplayerSessions_LastFindMs, TEXT("MultiplayerSessions/LastFindMs"));
+TRACE_DECLARE_FLOAT_COUNTER(MultiplayerSessions_LastJoinMs, TEXT("MultiplayerSessions/LastJoinMs"));
+TRACE_DECLARE_FLOAT_COUNTER(MultiplayerSessions_LastDestroyMs, TEXT("MultiplayerSessions/LastDestroyMs"));
+TRACE_DECLARE_FLOAT_COUNTER(MultiplayerSessions_LastStartMs, TEXT("MultiplayerSessions/LastStartMs"));
+TRACE_DECLARE_FLOAT_COUNTER(MultiplayerSessions_LastUpdateMs, TEXT("MultiplayerSessions/LastUpdateMs"));
+TRACE_DECLARE_INT_COUNTER(MultiplayerSessions_SearchResults, TEXT("MultiplayerSessions/SearchResults"));
+
+void FMultiplayerLatencyHistogram::Add(double LatencyInMs)
+{
+	LatencyInMs = FMath::Max(LatencyInMs, 0.0);
+
+	const int32 Bucket = LatencyInMs <= HistogramMinInMs ? 0 :
+		FMath::Min(FMath::CeilToInt(FMath::Loge(LatencyInMs / HistogramMinInMs) / FMath::Loge(HistogramGrowth)), NumBuckets - 1);
+
+	++Buckets[Bucket];
+	++NumSamples;
+	TotalInMs += LatencyInMs;
+	MaxInMs = FMath::Max(MaxInMs, LatencyInMs);
+}
+
+double FMultiplayerLatencyHistogram::GetPercentile(double Percentile) const
+{
+	if(NumSamples == 0) { return 0.0; }
+
+	const uint32 Rank = FMath::Max<uint32>(FMath::CeilToInt(FMath::Clamp(Percentile, 0.0, 1.0) * NumSamples), 1);
+
+	uint32 Seen = 0;
+	for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+	{
+		Seen += Buckets[Bucket];
+
+		// the last bucket is open-ended, the largest sample is the best bound we have
+		if (Seen >= Rank) { return FMath::Min(GetBucketUpperBound(Bucket), MaxInMs); }
+	}
+
+	return MaxInMs;
+}
+
+double FMultiplayerLatencyHistogram::GetBucketUpperBound(int32 Bucket)
+{
+	return HistogramMinInMs * FMath::Pow(HistogramGrowth, static_cast<double>(Bucket));
+}
+
+uint32 FMultiplayerSessionOpMetrics::GetNumFailed() const
+{
+	uint32 NumFailed = 0;
+	for (int32 Outcome = 0; Outcome < static_cast<int32>(EMultiplayerSessionOpOutcome::Num); ++Outcome)
+	{
+		if (Outcome != static_cast<int32>(EMultiplayerSessionOpOutcome::Success)) { NumFailed += Outcomes[Outcome]; }
+	}
+	return NumFailed;
+}
+
+void FMultiplayerSessionMetrics::RecordOutcome(EMultiplayerSessionMetricOp Op, EMultiplayerSessionOpOutcome Outcome)
+{
+	++Ops[static_cast<int32>(Op)].Outcomes[static_cast<int32>(Outcome)];
+
+	if (Outcome == EMultiplayerSessionOpOutcome::Success)
+	{
+		TRACE_COUNTER_INCREMENT(MultiplayerSessions_OpsSucceeded);
+	}
+	else
+	{
+		TRACE_COUNTER_INCREMENT(MultiplayerSessions_OpsFailed);
+	}
+}
+
+void FMultiplayerSessionMetrics::RecordCompletion(EMultiplayerSessionMetricOp Op, EMultiplayerSessionOpOutcome Outcome, double StartTime, double EndTime)
+{
+	const double LatencyInMs = (EndTime - StartTime) * 1000.0;
+	Ops[static_cast<int32>(Op)].Latency.Add(LatencyInMs);
+
+	switch (Op)
+	{
+	case EMultiplayerSessionMetricOp::Create: TRACE_COUNTER_SET(MultiplayerSessions_LastCreateMs, LatencyInMs); break;
+	case EMultiplayerSessionMetricOp::Find: TRACE_COUNTER_SET(MultiplayerSessions_LastFindMs, LatencyInMs); break;
+	case EMultiplayerSessionMetricOp::Join: TRACE_COUNTER_SET(MultiplayerSessions_LastJoinMs, LatencyInMs); break;
+	case EMultiplayerSessionMetricOp::Destroy: TRACE_COUNTER_SET(MultiplayerSessions_LastDestroyMs, LatencyInMs); break;
+	case EMultiplayerSessionMetricOp::Start: TRACE_COUNTER_SET(MultiplayerSessions_LastStartMs, LatencyInMs); break;
+	case EMultiplayerSessionMetricOp::Update: TRACE_COUNTER_SET(MultiplayerSessions_LastUpdateMs, LatencyInMs); break;
+	default: break;
+	}
+
+	RecordOutcome(Op, Outcome);
+}
+
+void FMultiplayerSessionMetrics::RecordSearchResults(int32 NumResults)
+{
+	LastSearchResultCount = NumResults;
+	MaxSearchResultCount = FMath::Max(MaxSearchResultCount, NumResults);
+	TotalSearchResultCount += NumResults;
+
+	TRACE_COUNTER_SET(MultiplayerSessions_SearchResults, NumResults);
+}
+
+void FMultiplayerSessionMetrics::RecordSearchCacheHit()
+{
+	++NumSearchCacheHits;
+}
+
+void FMultiplayerSessionMetrics::RecordJoinFailover(bool bExhausted)
+{
+	++(bExhausted ? NumJoinFailoversExhausted : NumJoinFailovers);
+}
+
+void FMultiplayerSessionMetrics::Dump(FOutputDevice& Ar) const
+{
+	for (int32 Op = 0; Op < static_cast<int32>(EMultiplayerSessionMetricOp::Num); ++Op)
+	{
+		const FMultiplayerSessionOpMetrics& OpMetrics = Ops[Op];
+
+		FString Outcomes;
+		for (int32 Outcome = 0; Outcome < static_cast<int32>(EMultiplayerSessionOpOutcome::Num); ++Outcome)
+		{
+			if (OpMetrics.Outcomes[Outcome] == 0) { continue; }
+			Outcomes += FString::Printf(TEXT(" %s=%u"), GetOutcomeName(static_cast<EMultiplayerSessionOpOutcome>(Outcome)), OpMetrics.Outcomes[Outcome]);
+		}
+
+		Ar.Logf(TEXT("%-8s n=%u p50=%.1fms p95=%.1fms p99=%.1fms max=%.1fms%s"),
+			GetOpName(static_cast<EMultiplayerSessionMetricOp>(Op)),
+			OpMetrics.Latency.Num(),
+			OpMetrics.Latency.GetPercentile(0.5),
+			OpMetrics.Latency.GetPercentile(0.95),
+			OpMetrics.Latency.GetPercentile(0.99),
+			OpMetrics.Latency.GetMax(),
+			*Outcomes);
+	}
+
+	Ar.Logf(TEXT("Search   cache hits=%u last results=%d max results=%d bytes retained=%llu"),
+		NumSearchCacheHits, LastSearchResultCount, MaxSearchResultCount, static_cast<uint64>(SearchBytesRetained));
+	Ar.Logf(TEXT("Join     failovers=%u exhausted=%u"), NumJoinFailovers, NumJoinFailoversExhausted);
+}
+
+SIZE_T FMultiplayerSessionMetrics::GetSearchAllocatedSize(const FOnlineSessionSearch& Search)
+{
+	SIZE_T Size = sizeof(FOnlineSessionSearch) + Search.SearchResults.GetAllocatedSize();
+
+	for (const FOnlineSessionSearchResult& Result : Search.SearchResults)
+	{
+		Size += Result.Session.SessionSettings.Settings.GetAllocatedSize();
+	}
+
+	return Size;
+}
@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionObjectPool.h"
+
+#include "OnlineSessionSettings.h"
+#include "SessionMetrics.h"
+
+namespace
+{
+	void ResetSearch(FOnlineSessionSearch& Search)
+	{
+		// defaults for every member, but the results array and query map keep their allocations
+		TArray<FOnlineSessionSearchResult> SearchResults = MoveTemp(Search.SearchResults);
+		decltype(Search.QuerySettings.SearchParams) SearchParams = MoveTemp(Search.QuerySettings.SearchParams);
+
+		Search = FOnlineSessionSearch();
+
+		SearchResults.Reset();
+		SearchParams.Reset();
+		Search.SearchResults = MoveTemp(SearchResults);
+		Search.QuerySettings.SearchParams = MoveTemp(SearchParams);
+	}
+
+	void ResetSettings(FOnlineSessionSettings& SessionSettings)
+	{
+		decltype(SessionSettings.Settings) Settings = MoveTemp(SessionSettings.Settings);
+		decltype(SessionSettings.MemberSettings) MemberSettings = MoveTemp(SessionSettings.MemberSettings);
+
+		SessionSettings = FOnlineSessionSettings();
+
+		Settings.Reset();
+		MemberSettings.Reset();
+		SessionSettings.Settings = MoveTemp(Settings);
+		SessionSettings.MemberSettings = MoveTemp(MemberSettings);
+	}
+
+	template<typename ObjectType>
+	TSharedRef<ObjectType> Acquire(TArray<TSharedRef<ObjectType>>& Pool, int32 MaxPooled, void (*Reset)(ObjectType&))
+	{
+		for (const TSharedRef<ObjectType>& Object : Pool)
+		{
+			if (Object.IsUnique())
+			{
+				Reset(*Object);
+				return Object;
+			}
+		}
+
+		TSharedRef<ObjectType> Object = MakeShared<ObjectType>();
+		if (Pool.Num() < MaxPooled)
+		{
+			Pool.Add(Object);
+		}
+		return Object;
+	}
+}
+
+TSharedRef<FOnlineSessionSearch> FMultiplayerSessionObjectPool::AcquireSearch()
+{
+	return Acquire(Searches, MaxPooled, &ResetSearch);
+}
+
+TSharedRef<FOnlineSessionSettings> FMultiplayerSessionObjectPool::AcquireSettings()
+{
+	return Acquire(Settings, MaxPooled, &ResetSettings);
+}
+
+SIZE_T FMultiplayerSessionObjectPool::GetAllocatedSize() const
+{
+	SIZE_T Size = Searches.GetAllocatedSize() + Settings.GetAllocatedSize();
+
+	for (const TSharedRef<FOnlineSessionSearch>& Search : Searches)
+	{
+		Size += FMultiplayerSessionMetrics::GetSearchAllocatedSize(*Search);
+	}
+	for (const TSharedRef<FOnlineSessionSettings>& SessionSettings : Settings)
+	{
+		Size += sizeof(FOnlineSessionSettings) + SessionSettings->Settings.GetAllocatedSize();
+	}
+
+	return Size;
+}
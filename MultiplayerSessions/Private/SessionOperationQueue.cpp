@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionOperationQueue.h"
+
+EMultiplayerSessionEnqueueResult FMultiplayerSessionSlot::Enqueue(FMultiplayerSessionOp&& Op, TArray<FMultiplayerSessionOp>& OutCancelled)
+{
+	switch (Op.Type)
+	{
+	case EMultiplayerSessionOpType::Create:
+	case EMultiplayerSessionOpType::Join:
+
+		// the newest create/join wins over anything that hasn't been sent yet
+		CancelPendingOfType(EMultiplayerSessionOpType::Create, OutCancelled);
+		CancelPendingOfType(EMultiplayerSessionOpType::Join, OutCancelled);
+		CancelPendingOfType(EMultiplayerSessionOpType::Start, OutCancelled);
+
+		// whatever exists by then has to be gone first
+		if (WillExist())
+		{
+			FMultiplayerSessionOp Destroy;
+			Destroy.Type = EMultiplayerSessionOpType::Destroy;
+			PendingOps.Add(MoveTemp(Destroy));
+		}
+
+		PendingOps.Add(MoveTemp(Op));
+		return EMultiplayerSessionEnqueueResult::Queued;
+
+	case EMultiplayerSessionOpType::Start:
+
+		if (IsInFlight(EMultiplayerSessionOpType::Start) || HasPending(EMultiplayerSessionOpType::Start))
+		{
+			return EMultiplayerSessionEnqueueResult::Coalesced;
+		}
+
+		if (!WillExist() || (State == EMultiplayerSessionState::InProgress && PendingOps.Num() == 0))
+		{
+			return EMultiplayerSessionEnqueueResult::Rejected;
+		}
+
+		PendingOps.Add(MoveTemp(Op));
+		return EMultiplayerSessionEnqueueResult::Queued;
+
+	case EMultiplayerSessionOpType::Destroy:
+
+		// nothing that was waiting to set the session up is wanted anymore
+		CancelPendingOfType(EMultiplayerSessionOpType::Create, OutCancelled);
+		CancelPendingOfType(EMultiplayerSessionOpType::Join, OutCancelled);
+		CancelPendingOfType(EMultiplayerSessionOpType::Start, OutCancelled);
+
+		if (IsInFlight(EMultiplayerSessionOpType::Destroy) || HasPending(EMultiplayerSessionOpType::Destroy))
+		{
+			return EMultiplayerSessionEnqueueResult::Coalesced;
+		}
+
+		if (!WillExist())
+		{
+			return EMultiplayerSessionEnqueueResult::Rejected;
+		}
+
+		PendingOps.Add(MoveTemp(Op));
+		return EMultiplayerSessionEnqueueResult::Queued;
+	}
+
+	return EMultiplayerSessionEnqueueResult::Rejected;
+}
+
+void FMultiplayerSessionSlot::CancelPending(TArray<FMultiplayerSessionOp>& OutCancelled)
+{
+	OutCancelled.Append(MoveTemp(PendingOps));
+	PendingOps.Reset();
+}
+
+bool FMultiplayerSessionSlot::WillExist() const
+{
+	// Creating/Joining count as existing, if they fail the ops queued behind them simply fail too
+	bool bExists = State != EMultiplayerSessionState::None && State != EMultiplayerSessionState::Destroying;
+
+	for (const FMultiplayerSessionOp& Op : PendingOps)
+	{
+		if (Op.Type == EMultiplayerSessionOpType::Destroy) { bExists = false; }
+		else if (Op.Type != EMultiplayerSessionOpType::Start) { bExists = true; }
+	}
+
+	return bExists;
+}
+
+bool FMultiplayerSessionSlot::HasPending(EMultiplayerSessionOpType Type) const
+{
+	return PendingOps.ContainsByPredicate([Type](const FMultiplayerSessionOp& Op) { return Op.Type == Type; });
+}
+
+void FMultiplayerSessionSlot::CancelPendingOfType(EMultiplayerSessionOpType Type, TArray<FMultiplayerSessionOp>& OutCancelled)
+{
+	for (int32 Index = 0; Index < PendingOps.Num(); )
+	{
+		if (PendingOps[Index].Type == Type)
+		{
+			OutCancelled.Add(MoveTemp(PendingOps[Index]));
+			PendingOps.RemoveAt(Index);
+		}
+		else
+		{
+			++Index;
+		}
+	}
+}
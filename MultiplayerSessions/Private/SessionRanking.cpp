@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionRanking.h"
+
+#include "Async/ParallelFor.h"
+#include "OnlineSessionSettings.h"
+
+namespace
+{
+	// Candidates scored per task, fewer than this aren't worth handing to another thread
+	constexpr int32 ScoringChunkSize = 256;
+}
+
+FMultiplayerSessionCandidate FMultiplayerSessionCandidate::FromSearchResult(const FOnlineSessionSearchResult& Result, int32 ResultIndex)
+{
+	FMultiplayerSessionCandidate Candidate;
+	Candidate.ResultIndex = ResultIndex;
+	Candidate.PingInMs = Result.PingInMs;
+	Candidate.OpenSlots = Result.Session.NumOpenPublicConnections;
+	Candidate.MaxSlots = Result.Session.SessionSettings.NumPublicConnections;
+	Candidate.HostQuality = Result.Session.SessionSettings.bIsDedicated ? 1.f : 0.5f;
+	return Candidate;
+}
+
+float MultiplayerSessionRanking::ScoreCandidate(const FMultiplayerSessionCandidate& Candidate, const FMultiplayerSessionRankingWeights& Weights)
+{
+	if (Candidate.OpenSlots < FMath::Max(Weights.RequiredOpenSlots, 1)) { return -1.f; }
+
+	const float MaxPing = static_cast<float>(FMath::Max(Weights.MaxAcceptablePingInMs, 1));
+	const float LatencyTerm = 1.f - FMath::Clamp(static_cast<float>(Candidate.PingInMs) / MaxPing, 0.f, 1.f);
+
+	const float OpenSlotsTerm = Candidate.MaxSlots > 0 ? FMath::Clamp(static_cast<float>(Candidate.OpenSlots) / Candidate.MaxSlots, 0.f, 1.f) : 0.f;
+
+	const float HostQualityTerm = FMath::Clamp(Candidate.HostQuality, 0.f, 1.f);
+
+	return Weights.Latency * LatencyTerm + Weights.OpenSlots * OpenSlotsTerm + Weights.HostQuality * HostQualityTerm;
+}
+
+void MultiplayerSessionRanking::RankCandidates(TArray<FMultiplayerSessionCandidate>& Candidates, const FMultiplayerSessionRankingWeights& Weights)
+{
+	for (FMultiplayerSessionCandidate& Candidate : Candidates)
+	{
+		Candidate.Score = ScoreCandidate(Candidate, Weights);
+	}
+
+	Candidates.RemoveAllSwap([](const FMultiplayerSessionCandidate& Candidate) { return Candidate.Score < 0.f; }, EAllowShrinking::No);
+
+	// ties go to the result that arrived first so the ranking is deterministic
+	Candidates.Sort([](const FMultiplayerSessionCandidate& A, const FMultiplayerSessionCandidate& B)
+	{
+		return A.Score != B.Score ? A.Score > B.Score : A.ResultIndex < B.ResultIndex;
+	});
+}
+
+void MultiplayerSessionRanking::SelectTopCandidates(TArrayView<const FOnlineSessionSearchResult> Results, TArrayView<const int32> ResultIndices,
+	const TSet<FString>& ExcludedSessionIds, const FMultiplayerSessionRankingWeights& Weights, int32 MaxCandidates,
+	TArray<FMultiplayerSessionCandidate>& OutCandidates)
+{
+	OutCandidates.Reset();
+	if(MaxCandidates <= 0 || ResultIndices.Num() == 0) { return; }
+
+	// the reverse of the final order, so the worst candidate kept so far sits on top of the heap
+	const auto IsWorse = [](const FMultiplayerSessionCandidate& A, const FMultiplayerSessionCandidate& B)
+	{
+		return A.Score != B.Score ? A.Score < B.Score : A.ResultIndex > B.ResultIndex;
+	};
+
+	// every chunk keeps its own best MaxCandidates, only those meet in the merge below
+	const int32 NumChunks = FMath::DivideAndRoundUp(ResultIndices.Num(), ScoringChunkSize);
+	TArray<TArray<FMultiplayerSessionCandidate>> ChunkCandidates;
+	ChunkCandidates.SetNum(NumChunks);
+
+	ParallelFor(NumChunks, [&](int32 Chunk)
+	{
+		TArray<FMultiplayerSessionCandidate>& Kept = ChunkCandidates[Chunk];
+		Kept.Reserve(FMath::Min(MaxCandidates, ScoringChunkSize) + 1);
+
+		const int32 End = FMath::Min((Chunk + 1) * ScoringChunkSize, ResultIndices.Num());
+		for (int32 Index = Chunk * ScoringChunkSize; Index < End; ++Index)
+		{
+			const FOnlineSessionSearchResult& Result = Results[ResultIndices[Index]];
+			if(ExcludedSessionIds.Num() && ExcludedSessionIds.Contains(Result.GetSessionIdStr())) { continue; }
+
+			FMultiplayerSessionCandidate Candidate = FMultiplayerSessionCandidate::FromSearchResult(Result, ResultIndices[Index]);
+			Candidate.Score = ScoreCandidate(Candidate, Weights);
+			if(Candidate.Score < 0.f) { continue; }
+
+			Kept.HeapPush(Candidate, IsWorse);
+			if (Kept.Num() > MaxCandidates)
+			{
+				Kept.HeapPopDiscard(IsWorse, EAllowShrinking::No);
+			}
+		}
+	});
+
+	for (TArray<FMultiplayerSessionCandidate>& Kept : ChunkCandidates)
+	{
+		OutCandidates.Append(MoveTemp(Kept));
+	}
+
+	RankCandidates(OutCandidates, Weights);
+	if (OutCandidates.Num() > MaxCandidates)
+	{
+		OutCandidates.SetNum(MaxCandidates, EAllowShrinking::No);
+	}
+}
@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionSearchCache.h"
+
+#include "OnlineSessionSettings.h"
+#include "SessionMetrics.h"
+
+namespace
+{
+	bool IsSameQuery(const FMultiplayerSessionSearchCache::FEntry& Entry, const FMultiplayerSessionSearchFilter& Filter, int32 MaxSearchResults)
+	{
+		return Entry.MaxSearchResults == MaxSearchResults &&
+			Entry.Filter.MinOpenSlots == Filter.MinOpenSlots &&
+			Entry.Filter.BuildUniqueId == Filter.BuildUniqueId &&
+			Entry.Filter.MatchType == Filter.MatchType &&
+			Entry.Filter.Region == Filter.Region &&
+			Entry.Filter.bDedicatedServers == Filter.bDedicatedServers &&
+			Entry.Filter.Lineage == Filter.Lineage;
+	}
+}
+
+void FMultiplayerSessionSearchCache::Configure(int32 InMaxEntries, double InTimeToLive)
+{
+	MaxEntries = FMath::Max(InMaxEntries, 0);
+	TimeToLive = InTimeToLive;
+
+	while (Entries.Num() > MaxEntries)
+	{
+		Entries.RemoveAt(0);
+	}
+}
+
+TSharedPtr<FOnlineSessionSearch> FMultiplayerSessionSearchCache::Find(const FMultiplayerSessionSearchFilter& Filter, int32 MaxSearchResults, double Now)
+{
+	FEntry* Entry = FindEntry(Filter, MaxSearchResults);
+	if (!Entry || Now - Entry->StoredTime > TimeToLive) { return nullptr; }
+
+	Entry->LastUsedTime = Now;
+	return Entry->Search;
+}
+
+void FMultiplayerSessionSearchCache::Store(const FMultiplayerSessionSearchFilter& Filter, int32 MaxSearchResults, const TSharedRef<FOnlineSessionSearch>& Search, double Now)
+{
+	if (MaxEntries == 0) { return; }
+
+	FEntry* Entry = FindEntry(Filter, MaxSearchResults);
+
+	if (!Entry)
+	{
+		if (Entries.Num() >= MaxEntries)
+		{
+			int32 LeastRecentlyUsed = 0;
+			for (int32 Index = 1; Index < Entries.Num(); ++Index)
+			{
+				if (Entries[Index].LastUsedTime < Entries[LeastRecentlyUsed].LastUsedTime) { LeastRecentlyUsed = Index; }
+			}
+			Entries.RemoveAtSwap(LeastRecentlyUsed);
+		}
+
+		Entry = &Entries.AddDefaulted_GetRef();
+		Entry->Filter = Filter;
+		Entry->MaxSearchResults = MaxSearchResults;
+		Entry->LastUsedTime = Now;
+	}
+
+	Entry->Search = Search;
+	Entry->StoredTime = Now;
+}
+
+void FMultiplayerSessionSearchCache::RemoveStale(double Now)
+{
+	Entries.RemoveAllSwap([this, Now](const FEntry& Entry) { return Now - Entry.StoredTime > TimeToLive; });
+}
+
+const FMultiplayerSessionSearchCache::FEntry* FMultiplayerSessionSearchCache::FindEntryToRefresh(double Now, double RefreshAge) const
+{
+	const FEntry* Best = nullptr;
+
+	for (const FEntry& Entry : Entries)
+	{
+		if (Now - Entry.LastUsedTime > TimeToLive || Now - Entry.StoredTime < RefreshAge) { continue; }
+		if (!Best || Entry.LastUsedTime > Best->LastUsedTime) { Best = &Entry; }
+	}
+
+	return Best;
+}
+
+bool FMultiplayerSessionSearchCache::Contains(const TSharedPtr<FOnlineSessionSearch>& Search) const
+{
+	return Entries.ContainsByPredicate([&Search](const FEntry& Entry) { return Entry.Search == Search; });
+}
+
+SIZE_T FMultiplayerSessionSearchCache::GetAllocatedSize() const
+{
+	SIZE_T Size = Entries.GetAllocatedSize();
+
+	for (const FEntry& Entry : Entries)
+	{
+		Size += Entry.Filter.MatchType.GetAllocatedSize() + Entry.Filter.Region.GetAllocatedSize();
+		if (Entry.Search.IsValid()) { Size += FMultiplayerSessionMetrics::GetSearchAllocatedSize(*Entry.Search); }
+	}
+
+	return Size;
+}
+
+FMultiplayerSessionSearchCache::FEntry* FMultiplayerSessionSearchCache::FindEntry(const FMultiplayerSessionSearchFilter& Filter, int32 MaxSearchResults)
+{
+	return Entries.FindByPredicate([&Filter, MaxSearchResults](const FEntry& Entry) { return IsSameQuery(Entry, Filter, MaxSearchResults); });
+}
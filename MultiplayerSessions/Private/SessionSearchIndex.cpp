@@ -0,0 +1,190 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionSearchIndex.h"
+
+#include "Async/ParallelFor.h"
+#include "OnlineSessionSettings.h"
+#include "SessionAttributes.h"
+
+namespace
+{
+	// Results decoded per task. Pages of a streaming search are smaller than this and stay on the calling thread.
+	constexpr int32 ParallelDecodeChunkSize = 256;
+
+	struct FDecodedResult
+	{
+		uint32 MatchKey;
+		bool bPassed;
+	};
+}
+
+void FMultiplayerSessionSearchFilter::ApplyTo(FOnlineSessionSearch& Search) const
+{
+	if (!MatchType.IsEmpty())
+	{
+		MultiplayerSessionAttributes::SetQuery(Search.QuerySettings, EMultiplayerSessionAttribute::MatchKey, FMultiplayerSessionSearchIndex::MakeMatchKey(MatchType));
+	}
+
+	if (MinOpenSlots > 0)
+	{
+		Search.QuerySettings.Set(SEARCH_MINSLOTSAVAILABLE, MinOpenSlots, EOnlineComparisonOp::GreaterThanEquals);
+	}
+
+	if (!Region.IsEmpty())
+	{
+		MultiplayerSessionAttributes::SetQuery(Search.QuerySettings, EMultiplayerSessionAttribute::RegionKey, MultiplayerSessionAttributes::HashString(Region));
+	}
+
+	if (bDedicatedServers)
+	{
+		Search.QuerySettings.Set(SEARCH_DEDICATED_ONLY, true, EOnlineComparisonOp::Equals);
+	}
+
+	if (Lineage != 0)
+	{
+		MultiplayerSessionAttributes::SetQuery(Search.QuerySettings, EMultiplayerSessionAttribute::Lineage, static_cast<uint32>(Lineage));
+	}
+
+	// BuildUniqueId isn't an advertised key, online subsystems compare it against their own build id.
+	// It's checked again when the results are indexed.
+}
+
+uint32 FMultiplayerSessionSearchIndex::MakeMatchKey(const FString& MatchType)
+{
+	return MultiplayerSessionAttributes::HashString(MatchType);
+}
+
+void FMultiplayerSessionSearchIndex::Reset(const FMultiplayerSessionSearchFilter& InFilter, uint32 InOldestHeartbeat)
+{
+	Filter = InFilter;
+	RegionKey = Filter.Region.IsEmpty() ? 0 : MultiplayerSessionAttributes::HashString(Filter.Region);
+	OldestHeartbeat = InOldestHeartbeat;
+
+	MatchKeys.Reset();
+	ResultIndices.Reset();
+	OpenSlots.Reset();
+	PingsInMs.Reset();
+	NextRows.Reset();
+	RowsByMatchKey.Reset();
+}
+
+void FMultiplayerSessionSearchIndex::Append(TArrayView<const FOnlineSessionSearchResult> Results, int32 FirstResultIndex)
+{
+	const int32 NumRows = ResultIndices.Num() + Results.Num();
+	MatchKeys.Reserve(NumRows);
+	ResultIndices.Reserve(NumRows);
+	OpenSlots.Reserve(NumRows);
+	PingsInMs.Reserve(NumRows);
+	NextRows.Reserve(NumRows);
+
+	if (Results.Num() < ParallelDecodeChunkSize)
+	{
+		for (int32 Index = 0; Index < Results.Num(); ++Index)
+		{
+			uint32 MatchKey = 0;
+			if (Decode(Results[Index], MatchKey))
+			{
+				AddRow(Results[Index], FirstResultIndex + Index, MatchKey);
+			}
+		}
+		return;
+	}
+
+	// reading the attributes is what's expensive, spread that over the task graph and keep linking serial
+	TArray<FDecodedResult> Decoded;
+	Decoded.SetNumUninitialized(Results.Num());
+
+	ParallelFor(FMath::DivideAndRoundUp(Results.Num(), ParallelDecodeChunkSize), [this, Results, &Decoded](int32 Chunk)
+	{
+		const int32 End = FMath::Min((Chunk + 1) * ParallelDecodeChunkSize, Results.Num());
+		for (int32 Index = Chunk * ParallelDecodeChunkSize; Index < End; ++Index)
+		{
+			Decoded[Index].bPassed = Decode(Results[Index], Decoded[Index].MatchKey);
+		}
+	});
+
+	for (int32 Index = 0; Index < Results.Num(); ++Index)
+	{
+		if (Decoded[Index].bPassed)
+		{
+			AddRow(Results[Index], FirstResultIndex + Index, Decoded[Index].MatchKey);
+		}
+	}
+}
+
+bool FMultiplayerSessionSearchIndex::Decode(const FOnlineSessionSearchResult& Result, uint32& OutMatchKey) const
+{
+	const FOnlineSessionSettings& Settings = Result.Session.SessionSettings;
+
+	if (Filter.BuildUniqueId != 0 && Settings.BuildUniqueId != Filter.BuildUniqueId) { return false; }
+	if (Result.Session.NumOpenPublicConnections < Filter.MinOpenSlots) { return false; }
+
+	// hosts encoding their settings differently can't be read, let alone joined
+	uint32 SchemaVersion = 0;
+	if(!MultiplayerSessionAttributes::GetInt(Settings, EMultiplayerSessionAttribute::SchemaVersion, SchemaVersion)) { return false; }
+	if(SchemaVersion != MultiplayerSessionAttributes::CurrentSchemaVersion) { return false; }
+
+	// the online service keeps listing sessions that are over, full or whose host has died, their heartbeat tells.
+	// Hosts that don't send one (e.g. LAN beacons) are taken at their word.
+	uint32 bClosed = 0;
+	if(MultiplayerSessionAttributes::GetInt(Settings, EMultiplayerSessionAttribute::Closed, bClosed) && bClosed != 0) { return false; }
+
+	uint32 Heartbeat = 0;
+	if(OldestHeartbeat != 0 && MultiplayerSessionAttributes::GetInt(Settings, EMultiplayerSessionAttribute::Heartbeat, Heartbeat) && Heartbeat < OldestHeartbeat) { return false; }
+
+	if (Filter.Lineage != 0)
+	{
+		uint32 HostLineage = 0;
+		if(!MultiplayerSessionAttributes::GetInt(Settings, EMultiplayerSessionAttribute::Lineage, HostLineage)) { return false; }
+		if(HostLineage != static_cast<uint32>(Filter.Lineage)) { return false; }
+	}
+
+	if (!Filter.Region.IsEmpty())
+	{
+		uint32 HostRegionKey = 0;
+		if(!MultiplayerSessionAttributes::GetInt(Settings, EMultiplayerSessionAttribute::RegionKey, HostRegionKey)) { return false; }
+		if(HostRegionKey != RegionKey) { return false; }
+	}
+
+	OutMatchKey = 0;
+	return MultiplayerSessionAttributes::GetInt(Settings, EMultiplayerSessionAttribute::MatchKey, OutMatchKey);
+}
+
+void FMultiplayerSessionSearchIndex::AddRow(const FOnlineSessionSearchResult& Result, int32 ResultIndex, uint32 MatchKey)
+{
+	const int32 Row = ResultIndices.Add(ResultIndex);
+	MatchKeys.Add(MatchKey);
+	OpenSlots.Add(Result.Session.NumOpenPublicConnections);
+	PingsInMs.Add(Result.PingInMs);
+	NextRows.Add(INDEX_NONE);
+
+	// link the row at the tail of its match key's list
+	if (TPair<int32, int32>* HeadAndTail = RowsByMatchKey.Find(MatchKey))
+	{
+		NextRows[HeadAndTail->Value] = Row;
+		HeadAndTail->Value = Row;
+	}
+	else
+	{
+		RowsByMatchKey.Add(MatchKey, TPair<int32, int32>(Row, Row));
+	}
+}
+
+int32 FMultiplayerSessionSearchIndex::FindFirst(uint32 MatchKey) const
+{
+	const int32 Row = FindFirstRow(MatchKey);
+	return Row != INDEX_NONE ? ResultIndices[Row] : INDEX_NONE;
+}
+
+int32 FMultiplayerSessionSearchIndex::FindFirstRow(uint32 MatchKey) const
+{
+	const TPair<int32, int32>* HeadAndTail = RowsByMatchKey.Find(MatchKey);
+	return HeadAndTail ? HeadAndTail->Key : INDEX_NONE;
+}
+
+SIZE_T FMultiplayerSessionSearchIndex::GetAllocatedSize() const
+{
+	return MatchKeys.GetAllocatedSize() + ResultIndices.GetAllocatedSize() + OpenSlots.GetAllocatedSize() +
+		PingsInMs.GetAllocatedSize() + NextRows.GetAllocatedSize() + RowsByMatchKey.GetAllocatedSize();
+}
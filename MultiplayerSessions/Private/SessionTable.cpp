@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SessionTable.h"
+
+FMultiplayerSessionSlot* FMultiplayerSessionTable::Find(FName SessionName)
+{
+	const int32 SlotIndex = FindSlotIndex(SessionName);
+	return SlotIndex != INDEX_NONE ? &Slots[SlotIndex] : nullptr;
+}
+
+const FMultiplayerSessionSlot* FMultiplayerSessionTable::Find(FName SessionName) const
+{
+	const int32 SlotIndex = FindSlotIndex(SessionName);
+	return SlotIndex != INDEX_NONE ? &Slots[SlotIndex] : nullptr;
+}
+
+FMultiplayerSessionSlot* FMultiplayerSessionTable::Find(FMultiplayerSessionHandle Handle)
+{
+	return const_cast<FMultiplayerSessionSlot*>(static_cast<const FMultiplayerSessionTable*>(this)->Find(Handle));
+}
+
+const FMultiplayerSessionSlot* FMultiplayerSessionTable::Find(FMultiplayerSessionHandle Handle) const
+{
+	if(!Handles.IsValidIndex(Handle.Index)) { return nullptr; }
+
+	const FHandleEntry& Entry = Handles[Handle.Index];
+	return Entry.Generation == Handle.Generation && Entry.SlotIndex != INDEX_NONE ? &Slots[Entry.SlotIndex] : nullptr;
+}
+
+FMultiplayerSessionSlot& FMultiplayerSessionTable::FindOrAdd(FName SessionName)
+{
+	if (FMultiplayerSessionSlot* Existing = Find(SessionName))
+	{
+		return *Existing;
+	}
+
+	const int32 HandleIndex = FreeHandles.Num() ? FreeHandles.Pop(EAllowShrinking::No) : Handles.AddDefaulted();
+	const int32 SlotIndex = Slots.AddDefaulted();
+
+	Handles[HandleIndex].SlotIndex = SlotIndex;
+	SlotHandles.Add(HandleIndex);
+	HandlesByName.Add(SessionName, HandleIndex);
+
+	FMultiplayerSessionSlot& Slot = Slots[SlotIndex];
+	Slot.SessionName = SessionName;
+	return Slot;
+}
+
+FMultiplayerSessionHandle FMultiplayerSessionTable::GetHandle(FName SessionName) const
+{
+	const int32* HandleIndex = HandlesByName.Find(SessionName);
+	if(!HandleIndex) { return FMultiplayerSessionHandle(); }
+
+	FMultiplayerSessionHandle Handle;
+	Handle.Index = *HandleIndex;
+	Handle.Generation = Handles[*HandleIndex].Generation;
+	return Handle;
+}
+
+bool FMultiplayerSessionTable::Remove(FName SessionName)
+{
+	int32 HandleIndex = INDEX_NONE;
+	if(!HandlesByName.RemoveAndCopyValue(SessionName, HandleIndex)) { return false; }
+
+	const int32 SlotIndex = Handles[HandleIndex].SlotIndex;
+	const int32 LastSlotIndex = Slots.Num() - 1;
+
+	// fill the hole with the last slot so the table stays dense
+	if (SlotIndex != LastSlotIndex)
+	{
+		Slots[SlotIndex] = MoveTemp(Slots[LastSlotIndex]);
+		SlotHandles[SlotIndex] = SlotHandles[LastSlotIndex];
+		Handles[SlotHandles[SlotIndex]].SlotIndex = SlotIndex;
+	}
+	Slots.Pop(EAllowShrinking::No);
+	SlotHandles.Pop(EAllowShrinking::No);
+
+	// outstanding handles to the removed session stop resolving
+	FHandleEntry& Entry = Handles[HandleIndex];
+	Entry.SlotIndex = INDEX_NONE;
+	++Entry.Generation;
+	FreeHandles.Add(HandleIndex);
+
+	return true;
+}
+
+void FMultiplayerSessionTable::Reset()
+{
+	Slots.Reset();
+	SlotHandles.Reset();
+	HandlesByName.Reset();
+	FreeHandles.Reset();
+
+	// bump every generation instead of forgetting the handles, so handles given out before still don't resolve
+	for (int32 HandleIndex = 0; HandleIndex < Handles.Num(); ++HandleIndex)
+	{
+		Handles[HandleIndex].SlotIndex = INDEX_NONE;
+		++Handles[HandleIndex].Generation;
+		FreeHandles.Add(HandleIndex);
+	}
+}
+
+SIZE_T FMultiplayerSessionTable::GetAllocatedSize() const
+{
+	SIZE_T Size = Slots.GetAllocatedSize() + SlotHandles.GetAllocatedSize() + Handles.GetAllocatedSize() +
+		FreeHandles.GetAllocatedSize() + HandlesByName.GetAllocatedSize();
+
+	for (const FMultiplayerSessionSlot& Slot : Slots)
+	{
+		Size += Slot.PendingOps.GetAllocatedSize();
+	}
+
+	return Size;
+}
+
+int32 FMultiplayerSessionTable::FindSlotIndex(FName SessionName) const
+{
+	const int32* HandleIndex = HandlesByName.Find(SessionName);
+	return HandleIndex ? Handles[*HandleIndex].SlotIndex : INDEX_NONE;
+}
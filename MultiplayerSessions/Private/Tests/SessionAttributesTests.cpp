@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "SessionAttributes.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMultiplayerSessionPackedAttributesTest, "MultiplayerSessions.Attributes.Packed",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+bool FMultiplayerSessionPackedAttributesTest::RunTest(const FString& Parameters)
+{
+	using namespace MultiplayerSessionAttributes;
+
+	FOnlineSessionSettings Settings;
+	const int32 NumDefaultSettings = Settings.Settings.Num();
+	uint32 Value = 0;
+
+	TestFalse(TEXT("nothing packed yet"), GetInt(Settings, EMultiplayerSessionAttribute::PlayerCount, Value));
+
+	TestTrue(TEXT("setting a field changes the settings"), SetInt(Settings, EMultiplayerSessionAttribute::SchemaVersion, CurrentSchemaVersion));
+	TestTrue(TEXT("setting a field changes the settings"), SetInt(Settings, EMultiplayerSessionAttribute::QuickMatch, 1));
+	TestTrue(TEXT("setting a field changes the settings"), SetInt(Settings, EMultiplayerSessionAttribute::MatchPhase, static_cast<uint32>(EMultiplayerSessionMatchPhase::Ended)));
+	TestTrue(TEXT("setting a field changes the settings"), SetInt(Settings, EMultiplayerSessionAttribute::Closed, 1));
+	TestTrue(TEXT("setting a field changes the settings"), SetInt(Settings, EMultiplayerSessionAttribute::PlayerCount, 4095));
+	TestFalse(TEXT("writing the same value again changes nothing"), SetInt(Settings, EMultiplayerSessionAttribute::PlayerCount, 4095));
+
+	// every packed attribute shares the one setting
+	TestEqual(TEXT("packed attributes share a key"), Settings.Settings.Num(), NumDefaultSettings + 1);
+
+	TestTrue(TEXT("schema version reads back"), GetInt(Settings, EMultiplayerSessionAttribute::SchemaVersion, Value) && Value == CurrentSchemaVersion);
+	TestTrue(TEXT("quick match reads back"), GetInt(Settings, EMultiplayerSessionAttribute::QuickMatch, Value) && Value == 1);
+	TestTrue(TEXT("match phase reads back"), GetInt(Settings, EMultiplayerSessionAttribute::MatchPhase, Value) && Value == static_cast<uint32>(EMultiplayerSessionMatchPhase::Ended));
+	TestTrue(TEXT("closed reads back"), GetInt(Settings, EMultiplayerSessionAttribute::Closed, Value) && Value == 1);
+	TestTrue(TEXT("player count reads back"), GetInt(Settings, EMultiplayerSessionAttribute::PlayerCount, Value) && Value == 4095);
+
+	// clearing one field leaves its neighbours alone
+	TestTrue(TEXT("clearing a field changes the settings"), SetInt(Settings, EMultiplayerSessionAttribute::Closed, 0));
+	TestTrue(TEXT("cleared field reads zero"), GetInt(Settings, EMultiplayerSessionAttribute::Closed, Value) && Value == 0);
+	TestTrue(TEXT("field below is kept"), GetInt(Settings, EMultiplayerSessionAttribute::MatchPhase, Value) && Value == static_cast<uint32>(EMultiplayerSessionMatchPhase::Ended));
+	TestTrue(TEXT("field above is kept"), GetInt(Settings, EMultiplayerSessionAttribute::PlayerCount, Value) && Value == 4095);
+
+	// Int32 attributes get a key of their own
+	TestTrue(TEXT("int32 attribute is set"), SetInt(Settings, EMultiplayerSessionAttribute::Heartbeat, 0xFFFFFFFFu));
+	TestEqual(TEXT("int32 attribute has its own key"), Settings.Settings.Num(), NumDefaultSettings + 2);
+	TestTrue(TEXT("int32 attribute keeps all 32 bits"), GetInt(Settings, EMultiplayerSessionAttribute::Heartbeat, Value) && Value == 0xFFFFFFFFu);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMultiplayerSessionAttributeQueryTest, "MultiplayerSessions.Attributes.Query",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+bool FMultiplayerSessionAttributeQueryTest::RunTest(const FString& Parameters)
+{
+	using namespace MultiplayerSessionAttributes;
+
+	TestEqual(TEXT("hashes ignore case"), HashString(TEXT("FreeForAll")), HashString(TEXT("freeforall")));
+
+	FOnlineSessionSettings Settings;
+	SetInt(Settings, EMultiplayerSessionAttribute::MatchKey, HashString(TEXT("FreeForAll")));
+
+	FOnlineSearchSettings QuerySettings;
+	TestTrue(TEXT("no query matches anything"), MatchesQuery(QuerySettings, Settings, EMultiplayerSessionAttribute::MatchKey));
+
+	SetQuery(QuerySettings, EMultiplayerSessionAttribute::MatchKey, HashString(TEXT("freeforall")));
+	TestTrue(TEXT("equal value matches"), MatchesQuery(QuerySettings, Settings, EMultiplayerSessionAttribute::MatchKey));
+
+	SetQuery(QuerySettings, EMultiplayerSessionAttribute::MatchKey, HashString(TEXT("TeamDeathMatch")));
+	TestFalse(TEXT("other value doesn't match"), MatchesQuery(QuerySettings, Settings, EMultiplayerSessionAttribute::MatchKey));
+
+	SetQuery(QuerySettings, EMultiplayerSessionAttribute::Lineage, 42);
+	TestFalse(TEXT("missing attribute doesn't match"), MatchesQuery(QuerySettings, Settings, EMultiplayerSessionAttribute::Lineage));
+
+	return true;
+}
+
+#endif
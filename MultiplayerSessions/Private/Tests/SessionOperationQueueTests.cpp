@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "SessionOperationQueue.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	EMultiplayerSessionEnqueueResult Enqueue(FMultiplayerSessionSlot& Slot, EMultiplayerSessionOpType Type, TArray<FMultiplayerSessionOp>& OutCancelled)
+	{
+		FMultiplayerSessionOp Op;
+		Op.Type = Type;
+		return Slot.Enqueue(MoveTemp(Op), OutCancelled);
+	}
+
+	TArray<EMultiplayerSessionOpType> GetPendingTypes(const FMultiplayerSessionSlot& Slot)
+	{
+		TArray<EMultiplayerSessionOpType> Types;
+		for (const FMultiplayerSessionOp& Op : Slot.PendingOps)
+		{
+			Types.Add(Op.Type);
+		}
+		return Types;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMultiplayerSessionSlotEnqueueTest, "MultiplayerSessions.OperationQueue.Enqueue",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+bool FMultiplayerSessionSlotEnqueueTest::RunTest(const FString& Parameters)
+{
+	using EType = EMultiplayerSessionOpType;
+	using EResult = EMultiplayerSessionEnqueueResult;
+
+	FMultiplayerSessionSlot Slot;
+	TArray<FMultiplayerSessionOp> Cancelled;
+
+	TestTrue(TEXT("new slot is idle"), Slot.IsIdle());
+	TestFalse(TEXT("new slot has no session"), Slot.WillExist());
+	TestTrue(TEXT("nothing to start"), Enqueue(Slot, EType::Start, Cancelled) == EResult::Rejected);
+	TestTrue(TEXT("nothing to destroy"), Enqueue(Slot, EType::Destroy, Cancelled) == EResult::Rejected);
+
+	TestTrue(TEXT("create is queued"), Enqueue(Slot, EType::Create, Cancelled) == EResult::Queued);
+	TestTrue(TEXT("start behind the create is queued"), Enqueue(Slot, EType::Start, Cancelled) == EResult::Queued);
+	TestTrue(TEXT("second start is coalesced"), Enqueue(Slot, EType::Start, Cancelled) == EResult::Coalesced);
+	TestTrue(TEXT("session will exist"), Slot.WillExist());
+	TestEqual(TEXT("nothing cancelled yet"), Cancelled.Num(), 0);
+
+	// the newest create wins over everything that wasn't sent
+	TestTrue(TEXT("second create is queued"), Enqueue(Slot, EType::Create, Cancelled) == EResult::Queued);
+	TestEqual(TEXT("earlier create and start are cancelled"), Cancelled.Num(), 2);
+	TestTrue(TEXT("only the newest create waits"), GetPendingTypes(Slot) == (TArray<EType>{ EType::Create }));
+
+	// a destroy drops the create that never got sent, the session won't exist then
+	Cancelled.Reset();
+	TestTrue(TEXT("destroy of a session that won't exist is rejected"), Enqueue(Slot, EType::Destroy, Cancelled) == EResult::Rejected);
+	TestEqual(TEXT("pending create is cancelled"), Cancelled.Num(), 1);
+	TestTrue(TEXT("slot is idle again"), Slot.IsIdle());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMultiplayerSessionSlotReplaceTest, "MultiplayerSessions.OperationQueue.Replace",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+bool FMultiplayerSessionSlotReplaceTest::RunTest(const FString& Parameters)
+{
+	using EType = EMultiplayerSessionOpType;
+	using EResult = EMultiplayerSessionEnqueueResult;
+
+	FMultiplayerSessionSlot Slot;
+	Slot.State = EMultiplayerSessionState::InProgress;
+	TArray<FMultiplayerSessionOp> Cancelled;
+
+	TestTrue(TEXT("started session isn't started again"), Enqueue(Slot, EType::Start, Cancelled) == EResult::Rejected);
+
+	// joining on top of an existing session destroys it first
+	TestTrue(TEXT("join is queued"), Enqueue(Slot, EType::Join, Cancelled) == EResult::Queued);
+	TestTrue(TEXT("destroy goes first"), GetPendingTypes(Slot) == (TArray<EType>{ EType::Destroy, EType::Join }));
+
+	// a create replacing the join keeps the destroy in front of it
+	TestTrue(TEXT("create is queued"), Enqueue(Slot, EType::Create, Cancelled) == EResult::Queued);
+	TestEqual(TEXT("join is cancelled"), Cancelled.Num(), 1);
+	TestTrue(TEXT("destroy stays first"), GetPendingTypes(Slot) == (TArray<EType>{ EType::Destroy, EType::Create }));
+
+	// a destroy in flight coalesces with another one
+	FMultiplayerSessionOp InFlight = MoveTemp(Slot.PendingOps[0]);
+	Slot.PendingOps.RemoveAt(0);
+	Slot.InFlight = MoveTemp(InFlight);
+	Slot.State = EMultiplayerSessionState::Destroying;
+
+	Cancelled.Reset();
+	TestTrue(TEXT("destroy next to the one in flight is coalesced"), Enqueue(Slot, EType::Destroy, Cancelled) == EResult::Coalesced);
+	TestEqual(TEXT("create is cancelled"), Cancelled.Num(), 1);
+	TestFalse(TEXT("session won't exist"), Slot.WillExist());
+
+	Slot.CancelPending(Cancelled);
+	TestFalse(TEXT("op in flight can't be taken back"), Slot.IsIdle());
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "SessionRanking.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	FMultiplayerSessionCandidate MakeCandidate(int32 ResultIndex, int32 PingInMs, int32 OpenSlots, int32 MaxSlots, float HostQuality)
+	{
+		FMultiplayerSessionCandidate Candidate;
+		Candidate.ResultIndex = ResultIndex;
+		Candidate.PingInMs = PingInMs;
+		Candidate.OpenSlots = OpenSlots;
+		Candidate.MaxSlots = MaxSlots;
+		Candidate.HostQuality = HostQuality;
+		return Candidate;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMultiplayerSessionScoreCandidateTest, "MultiplayerSessions.Ranking.ScoreCandidate",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+bool FMultiplayerSessionScoreCandidateTest::RunTest(const FString& Parameters)
+{
+	using namespace MultiplayerSessionRanking;
+
+	FMultiplayerSessionRankingWeights Weights;
+	Weights.RequiredOpenSlots = 2;
+
+	TestTrue(TEXT("too few open slots is rejected"), ScoreCandidate(MakeCandidate(0, 10, 1, 4, 1.f), Weights) < 0.f);
+	TestTrue(TEXT("enough open slots is accepted"), ScoreCandidate(MakeCandidate(0, 10, 2, 4, 1.f), Weights) >= 0.f);
+
+	const float NearScore = ScoreCandidate(MakeCandidate(0, 20, 2, 4, 0.5f), Weights);
+	const float FarScore = ScoreCandidate(MakeCandidate(0, 200, 2, 4, 0.5f), Weights);
+	TestTrue(TEXT("lower ping scores higher"), NearScore > FarScore);
+
+	const float DedicatedScore = ScoreCandidate(MakeCandidate(0, 50, 2, 4, 1.f), Weights);
+	const float ListenScore = ScoreCandidate(MakeCandidate(0, 50, 2, 4, 0.5f), Weights);
+	TestTrue(TEXT("dedicated hosts score higher"), DedicatedScore > ListenScore);
+
+	// pings past the acceptable maximum all count the same
+	TestEqual(TEXT("latency term saturates"), ScoreCandidate(MakeCandidate(0, 1000, 2, 4, 0.5f), Weights),
+		ScoreCandidate(MakeCandidate(0, 5000, 2, 4, 0.5f), Weights));
+
+	// a required slot count below one still requires a slot
+	Weights.RequiredOpenSlots = 0;
+	TestTrue(TEXT("full session is rejected"), ScoreCandidate(MakeCandidate(0, 10, 0, 4, 1.f), Weights) < 0.f);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMultiplayerSessionRankCandidatesTest, "MultiplayerSessions.Ranking.RankCandidates",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+bool FMultiplayerSessionRankCandidatesTest::RunTest(const FString& Parameters)
+{
+	FMultiplayerSessionRankingWeights Weights;
+
+	TArray<FMultiplayerSessionCandidate> Candidates;
+	Candidates.Add(MakeCandidate(0, 150, 2, 4, 0.5f));
+	Candidates.Add(MakeCandidate(1, 30, 0, 4, 1.f));
+	Candidates.Add(MakeCandidate(2, 30, 2, 4, 1.f));
+	Candidates.Add(MakeCandidate(3, 150, 2, 4, 0.5f));
+
+	MultiplayerSessionRanking::RankCandidates(Candidates, Weights);
+
+	if (!TestEqual(TEXT("full candidate is dropped"), Candidates.Num(), 3))
+	{
+		return false;
+	}
+
+	TestEqual(TEXT("best candidate first"), Candidates[0].ResultIndex, 2);
+	TestEqual(TEXT("ties keep arrival order"), Candidates[1].ResultIndex, 0);
+	TestEqual(TEXT("ties keep arrival order"), Candidates[2].ResultIndex, 3);
+
+	for (int32 Index = 1; Index < Candidates.Num(); ++Index)
+	{
+		TestTrue(TEXT("sorted best first"), Candidates[Index - 1].Score >= Candidates[Index].Score);
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "OnlineSessionSettings.h"
+#include "SessionAttributes.h"
+#include "SessionSearchIndex.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	// A listing as a current host advertises it
+	FOnlineSessionSearchResult MakeResult(const FString& MatchType, uint32 Heartbeat, uint32 Lineage = 0)
+	{
+		using namespace MultiplayerSessionAttributes;
+
+		FOnlineSessionSearchResult Result;
+		Result.Session.NumOpenPublicConnections = 2;
+		Result.PingInMs = 30;
+
+		FOnlineSessionSettings& Settings = Result.Session.SessionSettings;
+		SetInt(Settings, EMultiplayerSessionAttribute::MatchKey, FMultiplayerSessionSearchIndex::MakeMatchKey(MatchType));
+		SetInt(Settings, EMultiplayerSessionAttribute::SchemaVersion, CurrentSchemaVersion);
+		SetInt(Settings, EMultiplayerSessionAttribute::Closed, 0);
+		SetInt(Settings, EMultiplayerSessionAttribute::Heartbeat, Heartbeat);
+		if(Lineage != 0) { SetInt(Settings, EMultiplayerSessionAttribute::Lineage, Lineage); }
+
+		return Result;
+	}
+
+	TArray<int32> CollectResultIndices(const FMultiplayerSessionSearchIndex& Index, const FString& MatchType)
+	{
+		TArray<int32> ResultIndices;
+		Index.ForEach(FMultiplayerSessionSearchIndex::MakeMatchKey(MatchType), [&ResultIndices](int32 ResultIndex) { ResultIndices.Add(ResultIndex); });
+		return ResultIndices;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMultiplayerSessionSearchIndexFilterTest, "MultiplayerSessions.SearchIndex.Filter",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+bool FMultiplayerSessionSearchIndexFilterTest::RunTest(const FString& Parameters)
+{
+	using namespace MultiplayerSessionAttributes;
+
+	constexpr uint32 Now = 1000000;
+
+	TArray<FOnlineSessionSearchResult> Results;
+	Results.Add(MakeResult(TEXT("FreeForAll"), Now));
+
+	FOnlineSessionSearchResult ClosedResult = MakeResult(TEXT("FreeForAll"), Now);
+	SetInt(ClosedResult.Session.SessionSettings, EMultiplayerSessionAttribute::Closed, 1);
+	Results.Add(MoveTemp(ClosedResult));
+
+	Results.Add(MakeResult(TEXT("FreeForAll"), Now - 600));
+
+	FOnlineSessionSearchResult OtherSchemaResult = MakeResult(TEXT("FreeForAll"), Now);
+	SetInt(OtherSchemaResult.Session.SessionSettings, EMultiplayerSessionAttribute::SchemaVersion, CurrentSchemaVersion + 1);
+	Results.Add(MoveTemp(OtherSchemaResult));
+
+	FOnlineSessionSearchResult FullResult = MakeResult(TEXT("FreeForAll"), Now);
+	FullResult.Session.NumOpenPublicConnections = 0;
+	Results.Add(MoveTemp(FullResult));
+
+	Results.Add(MakeResult(TEXT("TeamDeathMatch"), Now));
+
+	// a host that predates the heartbeat is taken at its word
+	FOnlineSessionSearchResult NoHeartbeatResult = MakeResult(TEXT("FreeForAll"), Now);
+	NoHeartbeatResult.Session.SessionSettings.Remove(GetKey(EMultiplayerSessionAttribute::Heartbeat));
+	Results.Add(MoveTemp(NoHeartbeatResult));
+
+	FMultiplayerSessionSearchFilter Filter;
+	Filter.MinOpenSlots = 1;
+
+	FMultiplayerSessionSearchIndex Index;
+	Index.Reset(Filter, Now - 60);
+	Index.Append(Results, 10);
+
+	TestTrue(TEXT("closed, stale, other schema and full hosts are left out"), CollectResultIndices(Index, TEXT("FreeForAll")) == (TArray<int32>{ 10, 16 }));
+	TestEqual(TEXT("rows keep their source index"), Index.FindFirst(FMultiplayerSessionSearchIndex::MakeMatchKey(TEXT("TeamDeathMatch"))), 15);
+	TestEqual(TEXT("unknown match type finds nothing"), Index.FindFirst(FMultiplayerSessionSearchIndex::MakeMatchKey(TEXT("Capture"))), INDEX_NONE);
+	TestEqual(TEXT("one row per session passing the filter"), Index.Num(), 3);
+
+	// without a heartbeat cutoff stale hosts come back
+	Index.Reset(Filter);
+	Index.Append(Results, 0);
+	TestTrue(TEXT("no cutoff keeps stale hosts"), CollectResultIndices(Index, TEXT("FreeForAll")) == (TArray<int32>{ 0, 2, 6 }));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMultiplayerSessionSearchIndexLineageTest, "MultiplayerSessions.SearchIndex.Lineage",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+bool FMultiplayerSessionSearchIndexLineageTest::RunTest(const FString& Parameters)
+{
+	TArray<FOnlineSessionSearchResult> Results;
+	Results.Add(MakeResult(TEXT("FreeForAll"), 100, 7));
+	Results.Add(MakeResult(TEXT("FreeForAll"), 100, 8));
+	Results.Add(MakeResult(TEXT("FreeForAll"), 100));
+	Results.Add(MakeResult(TEXT("FreeForAll"), 100, 7));
+
+	FMultiplayerSessionSearchFilter Filter;
+	Filter.Lineage = 7;
+
+	FMultiplayerSessionSearchIndex Index;
+	Index.Reset(Filter);
+	Index.Append(Results, 0);
+
+	TestTrue(TEXT("only the lineage asked for"), CollectResultIndices(Index, TEXT("FreeForAll")) == (TArray<int32>{ 0, 3 }));
+
+	// appending a later page continues the lists in arrival order
+	Index.Append(TArrayView<const FOnlineSessionSearchResult>(Results).Left(1), 4);
+	TestTrue(TEXT("later pages are linked at the tail"), CollectResultIndices(Index, TEXT("FreeForAll")) == (TArray<int32>{ 0, 3, 4 }));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMultiplayerSessionSearchIndexParallelTest, "MultiplayerSessions.SearchIndex.ParallelDecode",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+bool FMultiplayerSessionSearchIndexParallelTest::RunTest(const FString& Parameters)
+{
+	using namespace MultiplayerSessionAttributes;
+
+	// big enough to be decoded in chunks on the task graph, every third host is closed
+	TArray<FOnlineSessionSearchResult> Results;
+	TArray<int32> Expected;
+	for (int32 ResultIndex = 0; ResultIndex < 1000; ++ResultIndex)
+	{
+		FOnlineSessionSearchResult& Result = Results.Add_GetRef(MakeResult(TEXT("FreeForAll"), 100));
+		if (ResultIndex % 3 == 0)
+		{
+			SetInt(Result.Session.SessionSettings, EMultiplayerSessionAttribute::Closed, 1);
+		}
+		else
+		{
+			Expected.Add(ResultIndex);
+		}
+	}
+
+	FMultiplayerSessionSearchIndex Index;
+	Index.Reset(FMultiplayerSessionSearchFilter());
+	Index.Append(Results, 0);
+
+	TestTrue(TEXT("parallel decode keeps arrival order"), CollectResultIndices(Index, TEXT("FreeForAll")) == Expected);
+
+	return true;
+}
+
+#endif
@@ -8,6 +8,8 @@
 
 #include "Menu.generated.h"
 
+enum class EMultiplayerQuickMatchResult : uint8;
+
 /**
  * 
  */
@@ -19,7 +21,7 @@ class MULTIPLAYERSESSIONS_API UMenu : public UUserWidget
 public:
 
 	UFUNCTION(BlueprintCallable, Category = "Network")
-	void MenuSetup(int32 NumberOfPublicConnection = 4, FString TypeOfMatch = FString(TEXT("Noskov")), FString LobbyPath = FString(TEXT("/Game/ThirdPerson/Maps/L_Lobby?listen")));
+	void MenuSetup(int32 NumberOfPublicConnection = 4, FString TypeOfMatch = FString(TEXT("Noskov")), FString LobbyPath = FString(TEXT("/Game/ThirdPerson/Maps/L_Lobby?listen")), bool bUseFastHost = true);
 
 protected:
 	
@@ -30,7 +32,9 @@ protected:
 	UFUNCTION()
 	void OnCreateSession(bool bWasSuccessful);
 	
-	void OnFindSessions(const TArray<FOnlineSessionSearchResult>& SessionResults, bool bWasSuccessful);
+	void OnFindSessions(TArrayView<const FOnlineSessionSearchResult> SessionResults, bool bIsLastPage);
+
+	void OnSessionsRanked(TArrayView<const struct FMultiplayerSessionCandidate> RankedCandidates);
 	
 	void OnJoinSession(EOnJoinSessionCompleteResult::Type Result);
 	
@@ -40,6 +44,10 @@ protected:
 	UFUNCTION()
 	void OnStartSession(bool bWasSuccessful);
 
+	void OnHostReady(bool bWasSuccessful);
+
+	void OnQuickMatchComplete(EMultiplayerQuickMatchResult Result);
+
 private:
 	
 	UPROPERTY(meta = (BindWidget))
@@ -51,6 +59,10 @@ private:
 	UPROPERTY(meta = (BindWidget))
 	class UButton* QuitButton;
 
+	// Join the best session of our match type or host one if there is none
+	UPROPERTY(meta = (BindWidgetOptional))
+	class UButton* QuickMatchButton;
+
 	UFUNCTION()
 	void HostButtonClicked();
 	
@@ -60,8 +72,17 @@ private:
 	UFUNCTION()
 	void QuitButtonClicked();
 
+	UFUNCTION()
+	void QuickMatchButtonClicked();
+
+	void SetButtonsEnabled(bool bEnabled);
+
 	void MenuTearDown();
 
+	// The menu may be set up again after a teardown (see UMultiplayerMenuSubsystem), it's bound exactly while it's shown
+	void BindSubsystemDelegates();
+	void UnbindSubsystemDelegates();
+
 	// Reference to a subsystem designed to handle all online session functionality
 	UPROPERTY()
 	class UMultiplayerSessionsSubsystem* MultiplayerSessionsSubsystem;
@@ -69,6 +90,10 @@ private:
 	// Menu setup properties
 	int32 NumPublicConnections{4};
 	FString MatchType{TEXT("Noskov")};
+	uint32 MatchKey{0};
 	
 	FString PathToLobby{TEXT("")};
+
+	// Create the session and load the lobby at the same time instead of one after the other
+	bool bFastHost{true};
 };
@@ -0,0 +1,212 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Interfaces/OnlineSessionInterface.h"
+#include "OnlineSessionSettings.h"
+#include "SessionMetrics.h"
+
+struct FMockOnlineSessionConfig
+{
+	// Sessions other hosts advertise, every search sees them (filtered by its query settings)
+	int32 NumAdvertisedSessions{100};
+	FString AdvertisedMatchType{TEXT("FreeForAll")};
+	int32 MaxSlotsPerSession{4};
+	int32 MinPingInMs{10};
+	int32 MaxPingInMs{200};
+
+	// Every call completes after a random latency in this range, in seconds
+	double MinLatency{0.02};
+	double MaxLatency{0.1};
+
+	// Chance, 0..1, that a call that was accepted completes with a failure
+	float FailureRate{0.f};
+
+	// Search results trickle in over the search's latency, like Steam server queries do
+	bool bStreamSearchResults{true};
+
+	// Complete calls from inside the call itself, like the NULL online subsystem does. Latency is ignored.
+	bool bCompleteInline{false};
+
+	// Ticked by the core ticker in real time. Otherwise time only moves when the owner calls Tick().
+	bool bManualTick{false};
+
+	// Hosts resolve to 127.0.0.1:<port>, which rankings ping. Otherwise to "mock.<session id>", which they can't.
+	bool bPingableHosts{true};
+
+	int32 RandomSeed{0};
+
+	// Id of the local player, tells apart mocks that share the sessions of another one
+	FString LocalUserName{TEXT("MockLocalUser")};
+};
+
+/**
+ * In-process IOnlineSession that simulates an online service: advertised sessions, latency and failures.
+ * Lets UMultiplayerSessionsSubsystem run without network (e.g. headless on a CI box), see
+ * UMultiplayerSessionsSubsystem::OverrideSessionInterface() and the MultiplayerSessions.Benchmark console command.
+ * Matchmaking, invites and friends aren't simulated, those calls simply fail.
+ */
+class MULTIPLAYERSESSIONS_API FMockOnlineSession : public IOnlineSession
+{
+public:
+
+	explicit FMockOnlineSession(const FMockOnlineSessionConfig& InConfig = FMockOnlineSessionConfig());
+
+	// Another player of the same online service: searches, joins and leaves go against the sessions Service advertises
+	// and hosts, e.g. to have many simulated clients join one host. Config.NumAdvertisedSessions is ignored.
+	FMockOnlineSession(const FMockOnlineSessionConfig& InConfig, const FMockOnlineSession& Service);
+	virtual ~FMockOnlineSession() override;
+
+	// Advance simulated time and complete whatever is due
+	void Tick(float DeltaTime);
+
+	// Calls that have been accepted and haven't completed yet, the running search included
+	int32 GetNumPendingCalls() const { return PendingCalls.Num() + (CurrentSearch.IsValid() ? 1 : 0); }
+
+	double GetTime() const { return Now; }
+	const FMockOnlineSessionConfig& GetConfig() const { return Config; }
+
+	// Drop the advertised sessions and simulate NumSessions new ones
+	void AdvertiseSessions(int32 NumSessions);
+	int32 GetNumAdvertisedSessions() const { return Service->Hosts.Num(); }
+
+	// A user id for the local player, headless runs don't have one
+	FUniqueNetIdRef GetLocalUserId() const { return LocalUserId; }
+
+	// Decide the next call of this kind up front instead of rolling latency and failure, e.g. to replay a
+	// FMultiplayerSessionJournal. Scripted calls are used in the order they were added. A scripted find returns at
+	// most NumResults results (INDEX_NONE for all that match), a scripted join succeeds whenever the host still exists.
+	void AddScriptedCall(EMultiplayerSessionMetricOp Op, double Latency, EMultiplayerSessionOpOutcome Outcome, int32 NumResults = INDEX_NONE);
+	void ClearScriptedCalls();
+	int32 GetNumScriptedCalls() const;
+
+#pragma region IOnlineSession
+
+	virtual FUniqueNetIdPtr CreateSessionIdFromString(const FString& SessionIdStr) override;
+	virtual FNamedOnlineSession* GetNamedSession(FName SessionName) override;
+	virtual void RemoveNamedSession(FName SessionName) override;
+	virtual bool HasPresenceSession() override;
+	virtual EOnlineSessionState::Type GetSessionState(FName SessionName) const override;
+	virtual bool CreateSession(int32 HostingPlayerNum, FName SessionName, const FOnlineSessionSettings& NewSessionSettings) override;
+	virtual bool CreateSession(const FUniqueNetId& HostingPlayerId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings) override;
+	virtual bool StartSession(FName SessionName) override;
+	virtual bool UpdateSession(FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings, bool bShouldRefreshOnlineData = true) override;
+	virtual bool EndSession(FName SessionName) override;
+	virtual bool DestroySession(FName SessionName, const FOnDestroySessionCompleteDelegate& CompletionDelegate = FOnDestroySessionCompleteDelegate()) override;
+	virtual bool IsPlayerInSession(FName SessionName, const FUniqueNetId& UniqueId) override;
+	virtual bool StartMatchmaking(const TArray<FUniqueNetIdRef>& LocalPlayers, FName SessionName, const FOnlineSessionSettings& NewSessionSettings, TSharedRef<FOnlineSessionSearch>& SearchSettings) override;
+	virtual bool CancelMatchmaking(int32 SearchingPlayerNum, FName SessionName) override;
+	virtual bool CancelMatchmaking(const FUniqueNetId& SearchingPlayerId, FName SessionName) override;
+	virtual bool FindSessions(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings) override;
+	virtual bool FindSessions(const FUniqueNetId& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings) override;
+	virtual bool FindSessionById(const FUniqueNetId& SearchingUserId, const FUniqueNetId& SessionId, const FUniqueNetId& FriendId, const FOnSingleSessionResultCompleteDelegate& CompletionDelegate) override;
+	virtual bool CancelFindSessions() override;
+	virtual bool PingSearchResults(const FOnlineSessionSearchResult& SearchResult) override;
+	virtual bool JoinSession(int32 LocalUserNum, FName SessionName, const FOnlineSessionSearchResult& DesiredSession) override;
+	virtual bool JoinSession(const FUniqueNetId& LocalUserId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession) override;
+	virtual bool FindFriendSession(int32 LocalUserNum, const FUniqueNetId& Friend) override;
+	virtual bool FindFriendSession(const FUniqueNetId& LocalUserId, const FUniqueNetId& Friend) override;
+	virtual bool FindFriendSession(const FUniqueNetId& LocalUserId, const TArray<FUniqueNetIdRef>& FriendList) override;
+	virtual bool SendSessionInviteToFriend(int32 LocalUserNum, FName SessionName, const FUniqueNetId& Friend) override;
+	virtual bool SendSessionInviteToFriend(const FUniqueNetId& LocalUserId, FName SessionName, const FUniqueNetId& Friend) override;
+	virtual bool SendSessionInviteToFriends(int32 LocalUserNum, FName SessionName, const TArray<FUniqueNetIdRef>& Friends) override;
+	virtual bool SendSessionInviteToFriends(const FUniqueNetId& LocalUserId, FName SessionName, const TArray<FUniqueNetIdRef>& Friends) override;
+	virtual bool GetResolvedConnectString(FName SessionName, FString& ConnectInfo, FName PortType = NAME_GamePort) override;
+	virtual bool GetResolvedConnectString(const FOnlineSessionSearchResult& SearchResult, FName PortType, FString& ConnectInfo) override;
+	virtual FOnlineSessionSettings* GetSessionSettings(FName SessionName) override;
+	virtual bool RegisterPlayer(FName SessionName, const FUniqueNetId& PlayerId, bool bWasInvited) override;
+	virtual bool RegisterPlayers(FName SessionName, const TArray<FUniqueNetIdRef>& Players, bool bWasInvited = false) override;
+	virtual bool UnregisterPlayer(FName SessionName, const FUniqueNetId& PlayerId) override;
+	virtual bool UnregisterPlayers(FName SessionName, const TArray<FUniqueNetIdRef>& Players) override;
+	virtual void RegisterLocalPlayer(const FUniqueNetId& PlayerId, FName SessionName, const FOnRegisterLocalPlayerCompleteDelegate& Delegate) override;
+	virtual void UnregisterLocalPlayer(const FUniqueNetId& PlayerId, FName SessionName, const FOnUnregisterLocalPlayerCompleteDelegate& Delegate) override;
+	virtual void RemovePlayerFromSession(int32 LocalUserNum, FName SessionName, const FUniqueNetId& TargetPlayerId) override;
+	virtual int32 GetNumSessions() override;
+	virtual void DumpSessionState() override;
+
+protected:
+
+	virtual FNamedOnlineSession* AddNamedSession(FName SessionName, const FOnlineSessionSettings& SessionSettings) override;
+	virtual FNamedOnlineSession* AddNamedSession(FName SessionName, const FOnlineSession& Session) override;
+
+#pragma endregion
+
+private:
+
+	// A session some host advertises. LocalSessionName is set for the ones we host ourselves.
+	struct FHost
+	{
+		FOnlineSession Session;
+		int32 PingInMs{0};
+		FName LocalSessionName;
+	};
+
+	struct FPendingCall
+	{
+		double DueTime{0.0};
+		TFunction<void()> Complete;
+	};
+
+	// What the online service advertises, shared by every mock created against the same service
+	struct FService
+	{
+		TArray<FHost> Hosts;
+		int32 NextSessionId{0};
+	};
+
+	struct FScriptedCall
+	{
+		double Latency{0.0};
+		EMultiplayerSessionOpOutcome Outcome{EMultiplayerSessionOpOutcome::Success};
+		int32 NumResults{INDEX_NONE};
+	};
+
+	// Run Complete once the simulated latency has passed (or right away when completing inline)
+	void Schedule(TFunction<void()>&& Complete);
+
+	// Same for a call that may be scripted, Complete gets the script or nullptr if latency and failure are rolled
+	void Schedule(EMultiplayerSessionMetricOp Op, TFunction<void(const FScriptedCall*)>&& Complete);
+
+	double RollLatency();
+	bool RollFailure();
+
+	// The scripted outcome is a failure, or a failure was rolled if there's no script
+	bool Fails(const FScriptedCall* Script);
+	bool PopScriptedCall(EMultiplayerSessionMetricOp Op, FScriptedCall& OutScript);
+
+	bool CoreTick(float DeltaTime);
+	void AdvanceSearch();
+	void FinishSearch();
+
+	bool MatchesQuery(const FHost& Host, const FOnlineSessionSearch& Search) const;
+	TSharedRef<FOnlineSessionInfo> MakeSessionInfo();
+
+	FHost* FindHost(const FString& SessionId);
+	void AdvertiseLocalSession(const FNamedOnlineSession& Session);
+
+	FMockOnlineSessionConfig Config;
+	FRandomStream Random;
+	double Now{0.0};
+
+	FUniqueNetIdRef LocalUserId;
+
+	TSharedRef<FService> Service;
+	TArray<FNamedOnlineSession> Sessions;
+	TArray<FPendingCall> PendingCalls;
+
+	// AddScriptedCall(), by op, and how many of each have been used
+	TArray<FScriptedCall> ScriptedCalls[static_cast<int32>(EMultiplayerSessionMetricOp::Num)];
+	int32 NumScriptedCallsUsed[static_cast<int32>(EMultiplayerSessionMetricOp::Num)]{};
+
+	// The interface runs one search at a time, its results are appended to the search object as they "arrive"
+	TSharedPtr<FOnlineSessionSearch> CurrentSearch;
+	TArray<FOnlineSessionSearchResult> CurrentSearchResults;
+	int32 NumCurrentSearchResultsDelivered{0};
+	double CurrentSearchStartTime{0.0};
+	double CurrentSearchDueTime{0.0};
+	bool bCurrentSearchFails{false};
+
+	FTSTicker::FDelegateHandle TickHandle;
+};
@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "UObject/UObjectGlobals.h"
+
+#include "MultiplayerMenuSubsystem.generated.h"
+
+class UMenu;
+struct FStreamableHandle;
+
+/**
+ * Owns the one menu widget of the game instance, so it survives travel instead of being rebuilt every time the player
+ * comes back to the menu. The widget Blueprint is loaded and the widget created up front, and while the player is
+ * elsewhere the menu map is kept loaded, so returning to the menu doesn't have to wait for either.
+ *
+ * Call ShowMenu() from the menu map (e.g. its level Blueprint) instead of creating the widget and calling MenuSetup().
+ */
+UCLASS(Config = Game)
+class MULTIPLAYERSESSIONS_API UMultiplayerMenuSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Put the pooled menu on screen, same arguments as UMenu::MenuSetup(). InMenuClass overrides MenuClass from the
+	// config, the widget is created again only if it differs from the pooled one's class.
+	UFUNCTION(BlueprintCallable, Category = "Network")
+	UMenu* ShowMenu(int32 NumberOfPublicConnection = 4, FString TypeOfMatch = FString(TEXT("Noskov")), FString LobbyPath = FString(TEXT("/Game/ThirdPerson/Maps/L_Lobby?listen")),
+		bool bUseFastHost = true, TSubclassOf<UMenu> InMenuClass = nullptr);
+
+	// Take the menu off screen, it stays pooled for the next ShowMenu()
+	UFUNCTION(BlueprintCallable, Category = "Network")
+	void HideMenu();
+
+	UMenu* GetMenu() const { return Menu; }
+
+protected:
+
+#pragma region MENU SETTINGS
+
+	// Widget Blueprint of the menu, loaded and created as soon as the game instance starts
+	UPROPERTY(Config)
+	TSoftClassPtr<UMenu> MenuClass;
+
+	// Map the menu is shown on. Kept loaded while the game is on any other map, leave empty to not preload it.
+	UPROPERTY(Config)
+	FString MenuMapPath;
+
+#pragma endregion
+
+private:
+
+	UMenu* GetOrCreateMenu(TSubclassOf<UMenu> WidgetClass);
+
+	void OnMenuClassLoaded();
+	void OnPreLoadMap(const FString& MapName);
+	void OnPostLoadMapWithWorld(UWorld* LoadedWorld);
+	void PreloadMenuMap();
+	void OnMenuMapLoaded(const FName& PackageName, UPackage* LoadedPackage, EAsyncLoadingResult::Type Result);
+
+	UPROPERTY()
+	UMenu* Menu{nullptr};
+
+	UPROPERTY()
+	TSubclassOf<UMenu> LoadedMenuClass;
+
+	// Held while the game is on another map and dropped once travel back has loaded it, the menu world holds it then
+	UPROPERTY()
+	UPackage* MenuMapPackage{nullptr};
+
+	TSharedPtr<FStreamableHandle> MenuClassHandle;
+	FString MenuMapPackageName;
+	bool bMenuMapLoading{false};
+
+	FDelegateHandle PreLoadMapHandle;
+	FDelegateHandle PostLoadMapHandle;
+};
@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
 
+MULTIPLAYERSESSIONS_API DECLARE_LOG_CATEGORY_EXTERN(LogMultiplayerSessions, Log, All);
+
 class FMultiplayerSessionsModule : public IModuleInterface
 {
 public:
@@ -12,4 +14,11 @@ public:
 	/** IModuleInterface implementation */
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
+
+	// FPlatformTime::Seconds() of when the module started up
+	static MULTIPLAYERSESSIONS_API double GetStartupTime();
+
+private:
+
+	static double StartupTime;
 };
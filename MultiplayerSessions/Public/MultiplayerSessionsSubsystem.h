@@ -3,37 +3,240 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Engine/EngineBaseTypes.h"
 #include "Interfaces/OnlineSessionInterface.h"
+#include "SessionAttributes.h"
+#include "SessionMetrics.h"
+#include "SessionObjectPool.h"
+#include "SessionRanking.h"
+#include "SessionOperationQueue.h"
+#include "SessionSearchCache.h"
+#include "SessionJournal.h"
+#include "SessionLANBeacon.h"
+#include "SessionSearchIndex.h"
+#include "SessionTable.h"
 #include "Subsystems/GameInstanceSubsystem.h"
 
 #include "MultiplayerSessionsSubsystem.generated.h"
 
+class UNetDriver;
+
+/*
+ * FPlatformTime::Seconds() at which each stage of the last join was reached, 0 if it hasn't been (yet)
+ */
+struct FMultiplayerJoinTimings
+{
+	double RequestedTime{0.0};
+	double AddressResolvedTime{0.0};
+	double MapLoadStartedTime{0.0};
+	double MapLoadedTime{0.0};
+	double JoinCompletedTime{0.0};
+	double TravelStartedTime{0.0};
+};
+
+UENUM(BlueprintType)
+enum class EMultiplayerQuickMatchResult : uint8
+{
+	// Joined somebody else's session, travel with ClientTravelToSession()
+	Joined,
+	// Hosting the game session and the lobby map is loaded, travel to the lobby
+	Hosted,
+	Failed,
+	Cancelled
+};
+
+UENUM(BlueprintType)
+enum class EMultiplayerHostMigrationResult : uint8
+{
+	// We were picked as the successor, the session is hosted again and we're travelling into it
+	Hosted,
+	// Joined the successor's session and travelling to it
+	Joined,
+	Failed,
+	Cancelled
+};
+
 /*
  * Declaring our own custom delegates for the Menu class to bind callbacks to 
  */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnCreateSessionComplete, bool, bWasSuccessful);
-DECLARE_MULTICAST_DELEGATE_TwoParams(FMultiplayerOnFindSessionsComplete, const TArray<FOnlineSessionSearchResult>& SessionResults, bool bWasSuccessful);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FMultiplayerOnFindSessionsComplete, TArrayView<const FOnlineSessionSearchResult> SessionResults, bool bWasSuccessful);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FMultiplayerOnFindSessionsPage, TArrayView<const FOnlineSessionSearchResult> SessionResults, bool bIsLastPage);
+DECLARE_MULTICAST_DELEGATE_OneParam(FMultiplayerOnSessionsRanked, TArrayView<const FMultiplayerSessionCandidate> RankedCandidates);
 DECLARE_MULTICAST_DELEGATE_OneParam(FMultiplayerOnJoinSessionComplete, EOnJoinSessionCompleteResult::Type Result);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnDestroySessionsComplete, bool, bWasSuccessful);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMultiplayerOnStartSessionsComplete, bool, bWasSuccessful);
+DECLARE_MULTICAST_DELEGATE_OneParam(FMultiplayerOnHostReady, bool bWasSuccessful);
+DECLARE_MULTICAST_DELEGATE_OneParam(FMultiplayerOnQuickMatchComplete, EMultiplayerQuickMatchResult Result);
+DECLARE_MULTICAST_DELEGATE_OneParam(FMultiplayerOnHostMigrationComplete, EMultiplayerHostMigrationResult Result);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FMultiplayerOnSessionStateChanged, FName SessionName, EMultiplayerSessionState State);
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FMultiplayerOnSessionOpComplete, FName SessionName, EMultiplayerSessionOpType Type, bool bWasSuccessful);
 
 /**
  * 
  */
-UCLASS()
+UCLASS(Config = Game)
 class MULTIPLAYERSESSIONS_API UMultiplayerSessionsSubsystem : public UGameInstanceSubsystem
 {
 	GENERATED_BODY()
 
 public:
 	UMultiplayerSessionsSubsystem();
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
 	
 	// To handle session functionality. The Menu class will call these.
+	// Overloads without a session name act on NAME_GameSession.
+	// Creating a session we host already, that hasn't started yet, updates it in place instead of re-creating it.
 	void CreateSession(int32 NumPublicConnections, FString MatchType);
-	void FindSessions(int32 MaxSearchResults);
+	void CreateSession(FName SessionName, int32 NumPublicConnections, FString MatchType, const FString& MapName = FString(), bool bDedicated = false);
+
+	// Fast host path: create the game session and async-load the lobby map at the same time. Once both have finished
+	// the session is started and MultiplayerOnHostReady fires, travelling to LobbyPath then finds the map in memory.
+	void HostSession(int32 NumPublicConnections, FString MatchType, const FString& LobbyPath);
+
+	// Dedicated server hosting: no local player is needed, the online subsystem creates and advertises the game session
+	// under the server's own identity. The session is started right away since the server already runs its map, which
+	// is advertised unless MapName says otherwise.
+	void HostDedicatedSession(int32 MaxPlayers, FString MatchType, const FString& MapName = FString());
+
+	// Same for any session name, so one server process can host and advertise many small matches side by side
+	void HostDedicatedSession(FName SessionName, int32 MaxPlayers, FString MatchType, const FString& MapName = FString());
+
+	// Players joining or leaving a session we host, e.g. from an AGameSession::RegisterPlayer/UnregisterPlayer override.
+	// They are registered with the online service in batches every PlayerRegistrationInterval seconds, followed by a
+	// single refresh of what the session advertises, instead of a round-trip per player.
+	void QueuePlayerRegistration(FName SessionName, const FUniqueNetIdRef& PlayerId, bool bRegister);
+	void FindSessions(int32 MaxSearchResults, const FMultiplayerSessionSearchFilter& Filter = FMultiplayerSessionSearchFilter());
+
+	// Same as FindSessions() but results are delivered in pages through MultiplayerOnFindSessionsPage
+	// while the search is still running, so a listener can join before the whole result set has arrived.
+	void FindSessionsIncremental(int32 MaxSearchResults, const FMultiplayerSessionSearchFilter& Filter = FMultiplayerSessionSearchFilter());
+	void CancelFindSessions();
+
+	// Forget every cached search result, the next search of every query goes online again
+	void InvalidateSearchCache() { SearchCache.Invalidate(); }
+
+	// Results of the last search are indexed by match key (see FMultiplayerSessionSearchIndex::MakeMatchKey) as they arrive.
+	// Returns nullptr if no session of that match type has been found (yet).
+	const FOnlineSessionSearchResult* FindSearchResult(uint32 MatchKey) const;
+	const FMultiplayerSessionSearchIndex& GetSearchIndex() const { return SearchIndex; }
+	const FOnlineSessionSearchResult* GetSearchResult(int32 ResultIndex) const;
+
+	// Rank the sessions of this match type found so far and broadcast the best MaxRankedCandidates of them, best first,
+	// through MultiplayerOnSessionsRanked. Up to MaxCandidatesToPing of the most promising ones are pinged concurrently
+	// before the final scoring. A running FindSessionsIncremental() is cancelled and ranked on the results it got so far.
+	// A running FindSessions() keeps going for its caller, it's ranked on the game thread on what has arrived so far.
+	// Otherwise from AsyncRankingThreshold candidates on they're scored on the task graph and the game thread only sees the best.
+	void RankSessions(uint32 MatchKey);
+	
 	void JoinSession(const FOnlineSessionSearchResult& SessionResult);
+
+	// PartySize is the number of players joining together, the leader included. A session that can't take all of
+	// them is turned down as full before anything is sent, see the PARTY JOIN section.
+	void JoinSession(FName SessionName, const FOnlineSessionSearchResult& SessionResult, int32 PartySize = 1);
+
+	// Join the candidates of the last RankSessions() best first. When a host turns us down (full, gone) it is remembered
+	// for RejectedHostCooldown seconds and the next candidate is tried after a growing backoff, without searching again.
+	// Candidates without room for the whole party are skipped. Only the final outcome is broadcast. Returns false if
+	// there's no candidate left to try, or if a newer search has replaced the one they were ranked from.
+	bool JoinRankedSessions(FName SessionName = NAME_GameSession, int32 PartySize = 1);
+
+	// Party members follow their leader into the session it joined: one lookup by session id, no search. The outcome
+	// is broadcast like any other join.
+	void JoinSessionById(FName SessionName, const FString& SessionId);
+
+	// Id of a session we've created or joined, for the party leader to hand to its members. Empty if there's none.
+	FString GetSessionId(FName SessionName);
+
+	// Hosts that turned a join down recently are left out of the ranking
+	bool IsHostRecentlyRejected(const FString& SessionId) const;
+
+	// Travel the first local player to the session joined last. The connect address was resolved and the host's map
+	// preloaded while the join was in progress. Returns false if there's no address or player to travel.
+	bool ClientTravelToSession();
+	const FString& GetJoinConnectAddress() const { return JoinConnectAddress; }
+	const FMultiplayerJoinTimings& GetLastJoinTimings() const { return JoinTimings; }
 	void DestroySession();
+	void DestroySession(FName SessionName);
 	void StartSession();
+	void StartSession(FName SessionName);
+
+	EMultiplayerSessionState GetSessionState(FName SessionName) const;
+	EMultiplayerSessionState GetSessionState(FMultiplayerSessionHandle Handle) const;
+
+	// Resolving a handle skips the name lookup. It stops resolving once the session is gone.
+	FMultiplayerSessionHandle GetSessionHandle(FName SessionName) const { return Sessions.GetHandle(SessionName); }
+
+	// Settings of a session we host, changes made through the setters below included. nullptr if there's no such session.
+	const FOnlineSessionSettings* GetSessionSettings(FName SessionName) const;
+
+	// Change what a session we host advertises while it stays up, instead of destroying and re-creating it (which is
+	// what CreateSession() on top of a started or joined session does). Setting a value it already has changes nothing. Every
+	// change made within a frame goes out in a single UpdateSession, at most one update per session is in flight.
+	// SetSessionSetting() is for keys of the game's own, attributes of SessionAttributes.h have their typed setters.
+	void SetSessionSetting(FName SessionName, FName Key, const FVariantData& Value);
+	void SetSessionMatchType(FName SessionName, const FString& MatchType);
+	void SetSessionMapName(FName SessionName, const FString& MapName);
+	void SetSessionNumPublicConnections(FName SessionName, int32 NumPublicConnections);
+
+	// Where the match of a session we host is at. It starts in the lobby and moves in progress once StartSession()
+	// succeeds, ending it is up to the game. Joinability follows from it, see the HOST HEARTBEAT section.
+	void SetSessionMatchPhase(FName SessionName, EMultiplayerSessionMatchPhase Phase);
+	EMultiplayerSessionMatchPhase GetSessionMatchPhase(FName SessionName) const;
+
+	// Sessions that exist or have operations in flight or queued
+	int32 GetNumSessions() const { return Sessions.Num(); }
+
+	// No operation of this session is in flight or queued
+	bool IsSessionIdle(FName SessionName) const;
+
+	// Drop the operations of this session that haven't been sent to the online service yet, each of them reports failure
+	void CancelPendingSessionOps(FName SessionName);
+
+	// Latency distributions and outcome counters of every session operation since startup (or the last reset),
+	// including how much memory the search path retains right now. Also dumped by "MultiplayerSessions.DumpMetrics".
+	FMultiplayerSessionMetrics GetSessionMetrics() const;
+	void ResetSessionMetrics() { Metrics = FMultiplayerSessionMetrics(); }
+
+	// Every op requested of and sent to the online service and how it completed, streamed to a file in the log
+	// directory for FMultiplayerSessionJournal::Load() and "MultiplayerSessions.ReplayJournal"
+	FMultiplayerSessionJournal& GetSessionJournal() { return Journal; }
+
+	// Talk to InSessionInterface instead of the online subsystem's, e.g. a FMockOnlineSession for benchmarks.
+	// InLocalUserId stands in for the first local player, headless runs don't have one.
+	// Sessions and searches of the previous interface are forgotten. Pass nullptr to go back to the online subsystem.
+	void OverrideSessionInterface(IOnlineSessionPtr InSessionInterface, FUniqueNetIdPtr InLocalUserId = nullptr);
+
+	// See MaxHeartbeatsNotServing. Processes hosting for a mock (load tests) don't listen and have to raise it.
+	int32 GetMaxHeartbeatsNotServing() const { return MaxHeartbeatsNotServing; }
+	void SetMaxHeartbeatsNotServing(int32 InMaxHeartbeatsNotServing) { MaxHeartbeatsNotServing = InMaxHeartbeatsNotServing; }
+
+	// The online subsystem is bound on first use. Call this early (e.g. while the splash screen is up) so the first
+	// search or host doesn't wait for the platform service to initialize. See also bWarmUpOnline.
+	void WarmUpOnline();
+	bool IsOnlineBound() const { return bSessionInterfaceBound; }
+
+	// Search for a session of this match type and join the best one. If none turns up within QuickMatchSearchDeadline
+	// seconds the game session is hosted through HostSession() instead. Players that ended up hosting at the same moment
+	// merge into one lobby before the result is reported. While a quick match runs the menu delegates stay quiet,
+	// its outcome is reported once through MultiplayerOnQuickMatchComplete.
+	void QuickMatch(int32 NumPublicConnections, FString MatchType, const FString& LobbyPath);
+
+	// A session that has already been created or joined is left alone
+	void CancelQuickMatch();
+	bool IsQuickMatchActive() const { return QuickMatchState.Stage != EQuickMatchStage::None; }
+
+	// The host of the game session we've joined is gone, carry on with the members that are left instead of sending
+	// everybody back to the menu. The member with the lowest unique id hosts the session again under the same match
+	// type, everybody else finds it with a single targeted query and follows. Runs by itself when the connection to
+	// the host is lost (see bMigrateHostOnDisconnect), games that notice first call it with the members they know of.
+	// The outcome is reported through MultiplayerOnHostMigrationComplete. Returns false if the session can't migrate.
+	bool MigrateHost(TArrayView<const FUniqueNetIdRef> RemainingMembers);
+	void CancelHostMigration();
+	bool IsHostMigrationActive() const { return HostMigrationState.Stage != EHostMigrationStage::None; }
 	
 
 #pragma region MENU DELEGATES
@@ -41,9 +244,18 @@ public:
 	// our own custom delegates for the Menu class to bind callback to
 	FMultiplayerOnCreateSessionComplete MultiplayerOnCreateSessionComplete;
 	FMultiplayerOnFindSessionsComplete MultiplayerOnFindSessionsComplete;
+	FMultiplayerOnFindSessionsPage MultiplayerOnFindSessionsPage;
+	FMultiplayerOnSessionsRanked MultiplayerOnSessionsRanked;
 	FMultiplayerOnJoinSessionComplete MultiplayerOnJoinSessionsComplete;
 	FMultiplayerOnDestroySessionsComplete MultiplayerOnDestroySessionsComplete;
 	FMultiplayerOnStartSessionsComplete MultiplayerOnStartSessionsComplete;
+	FMultiplayerOnHostReady MultiplayerOnHostReady;
+	FMultiplayerOnQuickMatchComplete MultiplayerOnQuickMatchComplete;
+	FMultiplayerOnHostMigrationComplete MultiplayerOnHostMigrationComplete;
+
+	// The delegates above only report on NAME_GameSession, these follow every session the subsystem manages
+	FMultiplayerOnSessionStateChanged MultiplayerOnSessionStateChanged;
+	FMultiplayerOnSessionOpComplete MultiplayerOnSessionOpComplete;
 
 #pragma endregion
 
@@ -60,27 +272,569 @@ protected:
 	void OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result);
 	void OnDestroySessionComplete(FName SessionName, bool bWasSuccessful);
 	void OnStartSessionComplete(FName SessionName, bool bWasSuccessful);
+	void OnUpdateSessionComplete(FName SessionName, bool bWasSuccessful);
+
+#pragma endregion
+
+#pragma region SEARCH SETTINGS
+
+	// Number of search results handed to MultiplayerOnFindSessionsPage per broadcast
+	UPROPERTY(Config)
+	int32 SearchPageSize{50};
+
+	// Upper bound of results a single incremental search may ask the online service for
+	UPROPERTY(Config)
+	int32 MaxSearchResultsInFlight{500};
+
+	// How often (in seconds) a running incremental search is checked for newly arrived results
+	UPROPERTY(Config)
+	float SearchPollInterval{0.05f};
+
+	// Advertised with every session we host so searches can filter by it. Leave empty to not advertise a region.
+	UPROPERTY(Config)
+	FString Region;
+
+	UPROPERTY(Config)
+	FMultiplayerSessionRankingWeights RankingWeights;
+
+	// How many of the best pre-ranked candidates get their latency measured
+	UPROPERTY(Config)
+	int32 MaxCandidatesToPing{16};
+
+	// How many candidates a ranking keeps, the rest are dropped where they're scored. Never fewer than MaxCandidatesToPing.
+	UPROPERTY(Config)
+	int32 MaxRankedCandidates{32};
+
+	// Rankings of this many candidates or more are scored off the game thread. Capped at a quarter of
+	// MaxSearchResultsInFlight, an incremental search never holds more candidates than that.
+	UPROPERTY(Config)
+	int32 AsyncRankingThreshold{128};
+
+	// Seconds to wait for a ping reply before falling back to the latency reported by the online service
+	UPROPERTY(Config)
+	float PingTimeout{0.5f};
+
+	// Number of distinct queries whose results are kept around, 0 disables the cache
+	UPROPERTY(Config)
+	int32 SearchCacheSize{4};
+
+	// Seconds cached results are served for before a query has to go online again
+	UPROPERTY(Config)
+	float SearchCacheTimeToLive{30.f};
+
+	// Seconds between background refreshes of the most recently used cached query, 0 disables refreshing
+	UPROPERTY(Config)
+	float SearchCacheRefreshInterval{10.f};
+
+#pragma endregion
+
+#pragma region DEDICATED SERVER SETTINGS
+
+	// Seconds player registrations are collected before they are sent to the online service as one batch
+	UPROPERTY(Config)
+	float PlayerRegistrationInterval{1.f};
+
+#pragma endregion
+
+#pragma region SESSION UPDATE SETTINGS
+
+	// Seconds before a session update the online service turned down is sent again
+	UPROPERTY(Config)
+	float SessionUpdateRetryDelay{1.f};
+
+	// Seconds between two updates of the same session, whatever changes in between goes out with the next one
+	UPROPERTY(Config)
+	float SessionUpdateInterval{1.f};
+
+	// Seconds between heartbeats of the sessions we host. Every heartbeat republishes player count, joinability and
+	// match phase with a fresh timestamp. 0 turns the heartbeat off.
+	UPROPERTY(Config)
+	float HostHeartbeatInterval{15.f};
+
+	// Search results whose host hasn't had a heartbeat for this many seconds are taken for dead and left out.
+	// Leave room for clocks of different machines disagreeing. 0 keeps them.
+	UPROPERTY(Config)
+	float HostHeartbeatTimeout{90.f};
+
+	// Heartbeats in a row that may find us not serving a session we host (not listening for connections) before it's
+	// no longer advertised. Covers the travel into the lobby after creating it.
+	UPROPERTY(Config)
+	int32 MaxHeartbeatsNotServing{2};
+
+	// Whether sessions we host can still be joined once they're in progress
+	UPROPERTY(Config)
+	bool bAllowJoinInProgress{true};
+
+#pragma endregion
+
+#pragma region JOIN SETTINGS
+
+	// Candidates JoinRankedSessions() tries before it gives up
+	UPROPERTY(Config)
+	int32 MaxJoinAttempts{4};
+
+	// Seconds before the first fail over to the next candidate, doubling with every further attempt up to JoinRetryMaxDelay
+	UPROPERTY(Config)
+	float JoinRetryBaseDelay{0.1f};
+
+	UPROPERTY(Config)
+	float JoinRetryMaxDelay{1.f};
+
+	// Seconds a host that turned a join down is skipped for
+	UPROPERTY(Config)
+	float RejectedHostCooldown{60.f};
+
+#pragma endregion
+
+#pragma region QUICK MATCH SETTINGS
+
+	// Seconds QuickMatch() searches for a session to join before it hosts one
+	UPROPERTY(Config)
+	float QuickMatchSearchDeadline{3.f};
+
+	// Seconds a freshly hosted quick match looks for another host of the same match type to merge with, 0 disables merging
+	UPROPERTY(Config)
+	float QuickMatchMergeWindow{2.f};
+
+	UPROPERTY(Config)
+	int32 QuickMatchMaxSearchResults{100};
+
+#pragma endregion
+
+#pragma region HOST MIGRATION SETTINGS
+
+	// Migrate the game session when the connection to its host is lost, see MigrateHost()
+	UPROPERTY(Config)
+	bool bMigrateHostOnDisconnect{true};
+
+	// Seconds the members that follow look for the successor's session before they give up
+	UPROPERTY(Config)
+	float HostMigrationTimeout{20.f};
+
+	// Seconds between their queries, the successor needs a round-trip to host the session again
+	UPROPERTY(Config)
+	float HostMigrationRetryInterval{1.f};
+
+#pragma endregion
+
+#pragma region LAN SETTINGS
+
+	// Discover LAN sessions through announcements hosts multicast instead of broadcast queries, see FMultiplayerSessionLANBeacon.
+	// Only used with the NULL online subsystem.
+	UPROPERTY(Config)
+	bool bUseLANBeacon{false};
+
+	UPROPERTY(Config)
+	FString LANBeaconGroupAddress{TEXT("239.255.77.77")};
+
+	UPROPERTY(Config)
+	int32 LANBeaconPort{14777};
+
+	// Interface announcements go out on, empty for the default one. 127.0.0.1 keeps every process on one machine.
+	UPROPERTY(Config)
+	FString LANBeaconMulticastInterface;
+
+	// Seconds between announcements of a host
+	UPROPERTY(Config)
+	float LANBeaconInterval{0.5f};
+
+	// Seconds without an announcement before a host is forgotten
+	UPROPERTY(Config)
+	float LANBeaconHostTimeout{2.f};
+
+#pragma endregion
+
+#pragma region ONLINE BINDING SETTINGS
+
+	// Bind the online subsystem OnlineWarmUpDelay seconds after startup instead of on first use. Headless processes
+	// (dedicated and test servers, load test clients) never warm up, they bind when they first touch a session.
+	UPROPERTY(Config)
+	bool bWarmUpOnline{true};
+
+	UPROPERTY(Config)
+	float OnlineWarmUpDelay{0.f};
+
+#pragma endregion
+
+#pragma region JOURNAL SETTINGS
+
+	// Off in shipping builds unless the game's config turns it on
+	UPROPERTY(Config)
+	bool bEnableSessionJournal{!UE_BUILD_SHIPPING};
+
+	// Journals kept in the log directory, the oldest ones are deleted when a new one starts. 0 keeps them all.
+	UPROPERTY(Config)
+	int32 MaxSessionJournalFiles{10};
+
+	// Events the game thread can record before the writer catches up, further events are dropped until it does
+	UPROPERTY(Config)
+	int32 SessionJournalCapacity{4096};
+
+	// Seconds between writes of the journal to disk
+	UPROPERTY(Config)
+	float SessionJournalFlushInterval{1.f};
 
 #pragma endregion
 	
 private:
 
+	bool TickIncrementalSearch(float DeltaTime);
+
+	// Broadcast every full page collected so far. When bSearchFinished is set the remaining tail is flushed as the last page.
+	void DeliverSearchPages(bool bSearchFinished);
+	void StopSearchPolling();
+
+	// Hand a page to the running quick match or, if there is none, to MultiplayerOnFindSessionsPage
+	void BroadcastSearchPage(TArrayView<const FOnlineSessionSearchResult> Page, bool bIsLastPage);
+
 	// Stores reference to a Multiplayer session interface
 	IOnlineSessionPtr SessionInterface;
 
-	TSharedPtr<FOnlineSessionSettings> LastSessionSettings;
+	// Binds the online subsystem's session interface the first time round. False if there is none to talk to.
+	bool EnsureSessionInterface();
+	bool TickOnlineWarmUp(float DeltaTime);
+
+	bool bSessionInterfaceBound{false};
+	bool bLANSubsystem{false};
+	FTSTicker::FDelegateHandle OnlineWarmUpHandle;
+
 	TSharedPtr<FOnlineSessionSearch> LastSessionSearch;
 
+	// Lifecycle and operation queue of every session that exists or has operations pending. A slot is dropped as soon
+	// as its session is gone and nothing is queued, so the table only ever holds live sessions.
+	FMultiplayerSessionTable Sessions;
+	uint32 SessionOpSerial{0};
+
+	FMultiplayerSessionSlot& FindOrAddSessionSlot(FName SessionName);
+	void EnqueueSessionOp(FName SessionName, FMultiplayerSessionOp&& Op);
+
+	// Send the next queued operation of this session if nothing is in flight
+	void PumpSessionOps(FName SessionName);
+
+	// Complete the operation in flight: update the session state and tell listeners
+	void FinishSessionOp(FName SessionName, bool bWasSuccessful, EOnJoinSessionCompleteResult::Type JoinResult = EOnJoinSessionCompleteResult::UnknownError);
+	bool IsSessionOpInFlight(FName SessionName, EMultiplayerSessionOpType Type) const;
+	// Serial is the one of the op that completed, 0 for requests turned down before they were queued
+	void BroadcastSessionOpResult(FName SessionName, EMultiplayerSessionOpType Type, bool bWasSuccessful, EOnJoinSessionCompleteResult::Type JoinResult = EOnJoinSessionCompleteResult::UnknownError, uint32 Serial = 0);
+
+	FUniqueNetIdPtr GetLocalUserId() const;
+	FUniqueNetIdPtr LocalUserIdOverride;
+
+	void BindSessionInterface();
+	void UnbindSessionInterface();
+
+	// HostSession() progress, the session is started once it's created and the lobby map has loaded
+	struct FHostPipeline
+	{
+		FName SessionName;
+		bool bActive{false};
+		bool bSessionCreated{false};
+		bool bMapLoaded{false};
+		bool bStarting{false};
+
+		// ops requested before this one belong to an earlier HostSession() call and don't move this pipeline along
+		uint32 FirstSerial{0};
+
+		// the lobby map being preloaded, loads of anything else finishing late are ignored
+		FName LobbyPackage;
+	};
+	FHostPipeline HostPipeline;
+
+	// Join pipeline state, see StartJoinPipeline()
+	FName JoinPipelineSessionName;
+	FString JoinConnectAddress;
+	FMultiplayerJoinTimings JoinTimings;
+
+	// Players joining through the join pipeline's session together, the leader included
+	int32 JoinPartySize{1};
+
+	void StartJoinPipeline(FName SessionName, const FOnlineSessionSearchResult& SessionResult);
+	void SendJoinSession(FName SessionName, const FOnlineSessionSearchResult& SessionResult, int32 PartySize = 1);
+
+	// Whether the session has a free public slot for every member of the party
+	static bool HasRoomForParty(const FOnlineSession& Session, int32 PartySize);
+
+	void OnFindSessionByIdComplete(int32 LocalUserNum, bool bWasSuccessful, const FOnlineSessionSearchResult& SessionResult, FName SessionName);
+
+	// Once the leader is in, look the session up again to see whether the rest of the party still fits. The join stays
+	// in flight until the answer is in. False if the lookup couldn't be sent.
+	bool CheckRoomForParty(FName SessionName);
+	void OnPartyRoomChecked(int32 LocalUserNum, bool bWasSuccessful, const FOnlineSessionSearchResult& SessionResult, FName SessionName, uint32 Serial);
+
+	// Finish the join in flight and get the join pipeline ready to travel
+	void CompleteJoinSession(FName SessionName, EOnJoinSessionCompleteResult::Type Result);
+
+	// Registrations collected by QueuePlayerRegistration() for the next batch, by session
+	struct FPendingPlayerRegistrations
+	{
+		TArray<FUniqueNetIdRef> ToRegister;
+		TArray<FUniqueNetIdRef> ToUnregister;
+	};
+	TMap<FName, FPendingPlayerRegistrations> PendingPlayerRegistrations;
+	FTSTicker::FDelegateHandle PlayerRegistrationHandle;
+
+	bool FlushPlayerRegistrations(float DeltaTime);
+
+	// Settings of a session we host, to be changed and then marked dirty. nullptr for joined sessions.
+	FOnlineSessionSettings* GetHostedSessionSettings(FName SessionName);
+	void MarkSessionSettingsDirty(FName SessionName);
+	void ScheduleSessionUpdates(float Delay);
+
+	// Send the settings of every dirty session the online service can take an update for right now
+	bool FlushSessionUpdates(float DeltaTime);
+	FTSTicker::FDelegateHandle SessionUpdateHandle;
+
+	// Bring player count, joinability and advertisement of a session we host up to date, marking it dirty if any of
+	// them changed. A heartbeat stamps the current time as well, which always makes for an update.
+	void RefreshHostedSession(FName SessionName, bool bHeartbeat);
+
+	// Whether this process is listening for the players of the sessions it hosts
+	bool IsServingSessions() const;
+
+	bool TickHostHeartbeat(float DeltaTime);
+	FTSTicker::FDelegateHandle HostHeartbeatHandle;
+
+	// Heartbeat a search result's host must have sent since to be taken for alive, 0 if the age isn't checked
+	uint32 GetOldestLiveHeartbeat() const;
+
+	// JoinRankedSessions() progress. The search is held so the candidates stay valid whatever is searched next.
+	struct FJoinFailover
+	{
+		FName SessionName;
+		bool bActive{false};
+		int32 PartySize{1};
+		TSharedPtr<FOnlineSessionSearch> Search;
+		TArray<int32> ResultIndices;
+		int32 NextCandidate{0};
+		int32 NumAttempts{0};
+		FString CurrentSessionId;
+		EOnJoinSessionCompleteResult::Type LastResult{EOnJoinSessionCompleteResult::UnknownError};
+		FTSTicker::FDelegateHandle RetryHandle;
+	};
+	FJoinFailover JoinFailover;
+
+	// Session id of every host that turned a join down -> FPlatformTime::Seconds() until it is skipped
+	TMap<FString, double> RejectedHosts;
+
+	// Send a join to the next candidate that hasn't turned us down. Returns false once candidates or attempts have run out.
+	bool JoinNextCandidate();
+
+	// A join of the failover has finished. Returns true if another candidate is going to be tried, the outcome isn't broadcast then.
+	bool ContinueJoinFailover(bool bWasSuccessful, EOnJoinSessionCompleteResult::Type JoinResult);
+	bool OnJoinRetryDue(float DeltaTime);
+	void StopJoinFailover();
+	void RememberRejectedHost(const FString& SessionId);
+	void OnJoinMapLoaded(const FName& PackageName, UPackage* LoadedPackage, EAsyncLoadingResult::Type Result);
+
+	// Announces what we host and tracks what other LAN hosts announce, see the LAN BEACON section
+	FMultiplayerSessionLANBeacon LANBeacon;
+	FTSTicker::FDelegateHandle LANBeaconTickHandle;
+
+	void StartLANBeacon();
+	void StopLANBeacon();
+	bool TickLANBeacon(float DeltaTime);
+
+	// The first LAN session we host that is up, false if there's none
+	bool MakeLANBeaconAnnouncement(FMultiplayerSessionLANHost& OutHost);
+
+	// Answer a search from the hosts the beacon knows about. False if the beacon isn't running.
+	bool ServeSearchFromLANBeacon(int32 MaxSearchResults, const FMultiplayerSessionSearchFilter& Filter);
+
+	// Run an op of a session joined through the beacon, which the online subsystem knows nothing about
+	bool SendLANBeaconSessionOp(FName SessionName, EMultiplayerSessionOpType Type);
+
+	// Connect string of a search result, LAN beacon results included
+	bool ResolveConnectString(const FOnlineSessionSearchResult& SessionResult, FString& OutConnectString) const;
+
+	// A map loaded ahead of travel (host lobby or the map a joined host advertises), kept alive until the next map load
+	UPROPERTY()
+	UPackage* PreloadedMapPackage{nullptr};
+	FDelegateHandle PostLoadMapHandle;
+
+	// Start async-loading a map, MapPath may carry travel options. Returns the package name that is loaded.
+	FString PreloadMap(const FString& MapPath, FLoadPackageAsyncDelegate OnLoaded);
+
+	void OnHostPipelineSessionOp(EMultiplayerSessionOpType Type, bool bWasSuccessful, uint32 Serial);
+	void BroadcastHostReady(bool bWasSuccessful);
+	void OnLobbyPackageLoaded(const FName& PackageName, UPackage* LoadedPackage, EAsyncLoadingResult::Type Result);
+	void AdvanceHostPipeline();
+	void OnPostLoadMapWithWorld(UWorld* LoadedWorld);
+	void ReleasePreloadedMap();
+
+	// What LastSessionSearch was asked for, so its results can be cached under that query
+	FMultiplayerSessionSearchFilter LastSearchFilter;
+	int32 LastMaxSearchResults{0};
+
+	TSharedRef<FOnlineSessionSearch> MakeSessionSearch(int32 MaxSearchResults, const FMultiplayerSessionSearchFilter& Filter);
+
+	// A reference to SessionResult that stays valid while a join is queued, without copying it if that can be avoided
+	TSharedPtr<const FOnlineSessionSearchResult> ShareSearchResult(const FOnlineSessionSearchResult& SessionResult) const;
+
+	// Search and settings objects are recycled once the online service, the cache and the session queue are done with them
+	FMultiplayerSessionObjectPool ObjectPool;
+
+	// Rows of LastSessionSearch->SearchResults that passed the filter, keyed by match type
+	FMultiplayerSessionSearchIndex SearchIndex;
+	int32 NumSearchResultsIndexed{0};
+
+	// Index results that arrived since the last call
+	void IndexSearchResults();
+
+	// Ping the pre-ranked RankedCandidates, FinishRanking() once the replies are in
+	void PingRankedCandidates();
+
+	// Finish a RankSessions() call once every ping has come back
+	void FinishRanking();
+
+	// Drop the candidates and supersede a ranking still in progress, e.g. because LastSessionSearch was replaced
+	void ResetRanking();
+
+	// Ranking state. RankedSearch is the search RankedCandidates index into.
+	TArray<FMultiplayerSessionCandidate> RankedCandidates;
+	TWeakPtr<FOnlineSessionSearch> RankedSearch;
+	int32 NumPingsOutstanding{0};
+	uint32 RankingSerial{0};
+
+	// Make a cached result set for this query the current search. Returns false on a cache miss.
+	bool ServeSearchFromCache(int32 MaxSearchResults, const FMultiplayerSessionSearchFilter& Filter);
+
+	bool TickSearchCache(float DeltaTime);
+	void CancelSearchCacheRefresh();
+	void OnSearchCacheRefreshComplete(bool bWasSuccessful);
+
+	// Search cache state. A background refresh runs its own search object which replaces the cached one when done.
+	FMultiplayerSessionSearchCache SearchCache;
+	FTSTicker::FDelegateHandle SearchCacheTickHandle;
+	TSharedPtr<FOnlineSessionSearch> SearchCacheRefresh;
+	FMultiplayerSessionSearchFilter SearchCacheRefreshFilter;
+	int32 SearchCacheRefreshMaxResults{0};
+
+	// FPlatformTime::Seconds() of when the current search and background refresh were sent
+	double SearchStartTime{0.0};
+	double SearchCacheRefreshStartTime{0.0};
+
+	FMultiplayerSessionMetrics Metrics;
+	FMultiplayerSessionJournal Journal;
+
+	// QuickMatch() progress
+	enum class EQuickMatchStage : uint8
+	{
+		None,
+		Searching,
+		Ranking,
+		Joining,
+		Hosting,
+		// hosting, looking for a concurrent host to merge with
+		Merging,
+		// left our own session for the one we merge with
+		MergeJoining
+	};
+	struct FQuickMatchState
+	{
+		EQuickMatchStage Stage{EQuickMatchStage::None};
+		int32 NumPublicConnections{0};
+		FString MatchType;
+		FString LobbyPath;
+		uint32 MatchKey{0};
+
+		// open slots our session had when it was ready, fewer means somebody joined and we stay
+		int32 OpenSlotsWhenHosted{0};
+		bool bMergeAttempted{false};
+
+		FTSTicker::FDelegateHandle DeadlineHandle;
+	};
+	FQuickMatchState QuickMatchState;
+
+	void OnQuickMatchSearchPage(bool bIsLastPage);
+	void OnQuickMatchRanked();
+	void OnQuickMatchJoined(bool bWasSuccessful);
+	void OnQuickMatchHostReady(bool bWasSuccessful);
+	bool OnQuickMatchDeadline(float DeltaTime);
+	void QuickMatchHost();
+	void QuickMatchSearch(EQuickMatchStage Stage, float Deadline);
+	void ResolveQuickMatchMerge();
+
+	// Pick the concurrent host to merge with, nullptr if we are the one the others merge into
+	const FOnlineSessionSearchResult* FindQuickMatchMergeTarget() const;
+	void FinishQuickMatch(EMultiplayerQuickMatchResult Result);
+	void ClearQuickMatchDeadline();
+
+	// Key based CreateSession() and HostSession(). A Lineage of 0 starts a new one, host migration passes the old one on.
+	void CreateSessionWithKey(FName SessionName, int32 NumPublicConnections, uint32 MatchKey, const FString& MapName, bool bDedicated, uint32 Lineage);
+
+	// Give a session we host and haven't started the settings a create would, through an update of what changed.
+	// False if the session can't be changed into that and has to be re-created.
+	bool UpdateHostedSessionInPlace(FName SessionName, int32 NumPublicConnections, uint32 MatchKey, const FString& MapName, bool bDedicated, uint32 Lineage);
+	void HostSessionWithKey(int32 NumPublicConnections, uint32 MatchKey, const FString& LobbyPath, uint32 Lineage);
+
+	// MigrateHost() progress
+	enum class EHostMigrationStage : uint8
+	{
+		None,
+		// we're the successor
+		Hosting,
+		// looking for the successor's session
+		Searching,
+		Joining
+	};
+	struct FHostMigrationState
+	{
+		EHostMigrationStage Stage{EHostMigrationStage::None};
+		uint32 MatchKey{0};
+		uint32 Lineage{0};
+
+		// Owner of the session we lost, the online service may still list it for a while with a fresh heartbeat
+		FUniqueNetIdPtr OldHostId;
+
+		// Travel URL of the map we were in, the successor hosts it again
+		FString LobbyPath;
+
+		// FPlatformTime::Seconds() after which followers stop looking
+		double Deadline{0.0};
+
+		// The session has been hosted or joined, travelling is all that's left
+		bool bSessionReady{false};
+
+		// Losing the host takes us back to the entry map, we can't travel again before that has loaded
+		bool bAwaitingEntryMap{false};
+
+		FTSTicker::FDelegateHandle RetryHandle;
+		FDelegateHandle MapLoadedHandle;
+	};
+	FHostMigrationState HostMigrationState;
+
+	bool StartHostMigration(TArrayView<const FUniqueNetIdRef> RemainingMembers, bool bAwaitEntryMap);
+	void HostMigrationSearch();
+	bool OnHostMigrationRetry(float DeltaTime);
+	void OnHostMigrationSearchPage(bool bIsLastPage);
+	void OnHostMigrationJoined(bool bWasSuccessful);
+	void OnHostMigrationHostReady(bool bWasSuccessful);
+	void OnHostMigrationMapLoaded(UWorld* LoadedWorld);
+	void TravelAfterHostMigration();
+	void FinishHostMigration(EMultiplayerHostMigrationResult Result);
+
+	void OnNetworkFailure(UWorld* World, UNetDriver* NetDriver, ENetworkFailure::Type FailureType, const FString& ErrorString);
+	FDelegateHandle NetworkFailureHandle;
+
+	// Incremental search state
+	FTSTicker::FDelegateHandle SearchPollHandle;
+	int32 NumSearchResultsDelivered{0};
+	bool bIncrementalSearch{false};
+
 #pragma region ONLINEINTERFACE DELEGATES
 	/*
 	 * To add to the Online Session Interface delegate list.
 	 * We'll bind our MultiplayerSessionsSubsystem internal call backs to these.
+	 * Create/Join/Destroy/Start stay bound from Initialize() to Deinitialize(), searches bind theirs per query.
 	 */
 	FOnCreateSessionCompleteDelegate CreateSessionCompleteDelegate;
 	FDelegateHandle CreateSessionCompleteDelegateHandle;
 	
 	FOnFindSessionsCompleteDelegate	FindSessionsCompleteDelegate;
 	FDelegateHandle FindSessionsCompleteDelegateHandle;
+
+	FOnFindSessionsCompleteDelegate	SearchCacheRefreshCompleteDelegate;
+	FDelegateHandle SearchCacheRefreshDelegateHandle;
 	
 	FOnJoinSessionCompleteDelegate	JoinSessionCompleteDelegate;
 	FDelegateHandle JoinSessionCompleteDelegateHandle;
@@ -91,9 +845,8 @@ private:
 	FOnStartSessionCompleteDelegate	StartSessionCompleteDelegate;
 	FDelegateHandle StartSessionCompleteDelegateHandle;
 
-	bool bCreateSessionOnDestroy{ false };
-	int32 LastNumPublicConnections;
-	FString LastMatchType;
+	FOnUpdateSessionCompleteDelegate UpdateSessionCompleteDelegate;
+	FDelegateHandle UpdateSessionCompleteDelegateHandle;
  
 #pragma endregion
 	
@@ -0,0 +1,141 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+
+enum class EMultiplayerSessionAttributeType : uint8
+{
+	// Hashes and ids, advertised as their own int32 setting so the online service can filter on them
+	Int32,
+	String,
+	// A few bits of the one int64 setting every packed attribute shares
+	Packed
+};
+
+// Every attribute a session advertises. Doubles as the attribute's index into MultiplayerSessionAttributes::Schema.
+enum class EMultiplayerSessionAttribute : uint8
+{
+	// MultiplayerSessionAttributes::HashString() of the match type
+	MatchKey,
+	// MultiplayerSessionAttributes::HashString() of the region
+	RegionKey,
+	// Package name of the map, clients preload it while joining
+	MapName,
+	// Version of this schema the host encoded its settings with
+	SchemaVersion,
+	// Hosted by a quick match, which may still give it up to merge into another one
+	QuickMatch,
+	// EMultiplayerSessionMatchPhase the host is in
+	MatchPhase,
+	// Set while the host doesn't take players: it's full, its match phase doesn't allow joining or it isn't serving.
+	// Hosts that predate it read as open.
+	Closed,
+	// Players in the session as the host counts them
+	PlayerCount,
+	// UTC unix time of the host's last heartbeat, searches drop hosts that have gone quiet for too long
+	Heartbeat,
+	// Random id a session passes on to the one that replaces it when its host migrates, so members can find it again
+	Lineage,
+
+	Num
+};
+
+// Advertised through EMultiplayerSessionAttribute::MatchPhase
+enum class EMultiplayerSessionMatchPhase : uint8
+{
+	// Waiting for players, joinable while there's room
+	Lobby,
+	// Joinable only if the session allows joining in progress
+	InProgress,
+	// Nobody should join anymore
+	Ended
+};
+
+struct FMultiplayerSessionAttributeDesc
+{
+	const TCHAR* Key;
+	EMultiplayerSessionAttributeType Type;
+	EOnlineDataAdvertisementType::Type Advertisement;
+
+	// Packed only, where the attribute sits in the packed setting
+	uint8 BitOffset;
+	uint8 BitWidth;
+};
+
+/**
+ * The one place session attributes are declared. Hosts write and clients read them through the functions below only,
+ * so both sides agree on key, type and encoding without passing strings around.
+ *
+ * Strings that are only ever compared (match type, region) are advertised as hashes, which shrinks the payload and
+ * lets the online service and the search index compare integers. Small fields share a single int64 setting instead of
+ * paying for a key each.
+ */
+namespace MultiplayerSessionAttributes
+{
+	// Bump whenever an attribute's key or encoding changes, hosts of another version are left out of searches.
+	// That includes HashString(), match and region keys are compared as hashes. 2: HashString() moved to FCrc::StrCrc32.
+	inline constexpr uint32 CurrentSchemaVersion = 2;
+
+	inline constexpr const TCHAR* PackedKey = TEXT("MSPK");
+
+	inline constexpr FMultiplayerSessionAttributeDesc Schema[] =
+	{
+		{ TEXT("MSMT"), EMultiplayerSessionAttributeType::Int32, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing, 0, 32 },
+		{ TEXT("MSRG"), EMultiplayerSessionAttributeType::Int32, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing, 0, 32 },
+		{ TEXT("MAPNAME"), EMultiplayerSessionAttributeType::String, EOnlineDataAdvertisementType::ViaOnlineService, 0, 0 },
+		{ PackedKey, EMultiplayerSessionAttributeType::Packed, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing, 0, 8 },
+		{ PackedKey, EMultiplayerSessionAttributeType::Packed, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing, 8, 1 },
+		{ PackedKey, EMultiplayerSessionAttributeType::Packed, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing, 9, 2 },
+		{ PackedKey, EMultiplayerSessionAttributeType::Packed, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing, 11, 1 },
+		{ PackedKey, EMultiplayerSessionAttributeType::Packed, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing, 12, 12 },
+		{ TEXT("MSHB"), EMultiplayerSessionAttributeType::Int32, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing, 0, 32 },
+		{ TEXT("MSLN"), EMultiplayerSessionAttributeType::Int32, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing, 0, 32 },
+	};
+
+	static_assert(UE_ARRAY_COUNT(Schema) == static_cast<int32>(EMultiplayerSessionAttribute::Num), "Every attribute needs a schema entry");
+
+	constexpr const FMultiplayerSessionAttributeDesc& Describe(EMultiplayerSessionAttribute Attribute)
+	{
+		return Schema[static_cast<int32>(Attribute)];
+	}
+
+	// Packed attributes have to fit into the int64 without overlapping each other
+	constexpr bool IsPackingValid()
+	{
+		uint64 UsedBits = 0;
+		for (const FMultiplayerSessionAttributeDesc& Desc : Schema)
+		{
+			if(Desc.Type != EMultiplayerSessionAttributeType::Packed) { continue; }
+			if(Desc.BitWidth == 0 || Desc.BitWidth > 32 || Desc.BitOffset + Desc.BitWidth > 64) { return false; }
+
+			const uint64 Bits = ((uint64(1) << Desc.BitWidth) - 1) << Desc.BitOffset;
+			if(UsedBits & Bits) { return false; }
+			UsedBits |= Bits;
+		}
+		return true;
+	}
+
+	static_assert(IsPackingValid(), "Packed attributes overlap or don't fit");
+	static_assert(CurrentSchemaVersion < (1u << Describe(EMultiplayerSessionAttribute::SchemaVersion).BitWidth), "Schema version doesn't fit its field");
+
+	// Setting key of the attribute, built once
+	MULTIPLAYERSESSIONS_API FName GetKey(EMultiplayerSessionAttribute Attribute);
+
+	// Case-insensitive
+	MULTIPLAYERSESSIONS_API uint32 HashString(const FString& Value);
+
+	// Int32 and packed attributes. Values are masked to the attribute's bit width. Returns whether the settings changed.
+	MULTIPLAYERSESSIONS_API bool SetInt(FOnlineSessionSettings& Settings, EMultiplayerSessionAttribute Attribute, uint32 Value);
+	MULTIPLAYERSESSIONS_API bool GetInt(const FOnlineSessionSettings& Settings, EMultiplayerSessionAttribute Attribute, uint32& OutValue);
+
+	MULTIPLAYERSESSIONS_API bool SetString(FOnlineSessionSettings& Settings, EMultiplayerSessionAttribute Attribute, const FString& Value);
+	MULTIPLAYERSESSIONS_API bool GetString(const FOnlineSessionSettings& Settings, EMultiplayerSessionAttribute Attribute, FString& OutValue);
+
+	// Ask the online service for sessions whose Int32 attribute equals Value
+	MULTIPLAYERSESSIONS_API void SetQuery(FOnlineSearchSettings& QuerySettings, EMultiplayerSessionAttribute Attribute, uint32 Value);
+
+	// Whether Settings pass the query SetQuery() put into QuerySettings for this attribute, true if there's none
+	MULTIPLAYERSESSIONS_API bool MatchesQuery(const FOnlineSearchSettings& QuerySettings, const FOnlineSessionSettings& Settings, EMultiplayerSessionAttribute Attribute);
+}
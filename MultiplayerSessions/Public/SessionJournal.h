@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SessionMetrics.h"
+
+#include <atomic>
+
+class FRunnableThread;
+
+enum class EMultiplayerSessionJournalEvent : uint8
+{
+	// A caller asked for the op, it's queued behind whatever the session is doing
+	Requested,
+	// The op reached the online service
+	Sent,
+	// The online service answered, or the op ended without it (refused, cancelled, rejected, served from a cache)
+	Completed,
+	Num
+};
+
+struct FMultiplayerSessionJournalEntry
+{
+	// Seconds since the journal was started
+	double Time{0.0};
+
+	FName SessionName;
+	EMultiplayerSessionJournalEvent Event{EMultiplayerSessionJournalEvent::Requested};
+	EMultiplayerSessionMetricOp Op{EMultiplayerSessionMetricOp::Create};
+	EMultiplayerSessionOpOutcome Outcome{EMultiplayerSessionOpOutcome::Success};
+
+	// Completed searches: number of results
+	int32 Value{0};
+
+	// Completed ops that were sent: time the online service took
+	float LatencyMs{0.f};
+};
+
+/**
+ * Binary journal of every session op the subsystem requests, sends and completes, for working out after the fact why
+ * a join took forever or a host failed. See the MultiplayerSessions.ReplayJournal console command for feeding a journal
+ * back into FMockOnlineSession.
+ *
+ * Recording copies the entry into a fixed ring buffer, no locks and no allocations. A writer thread drains the buffer
+ * to disk every flush interval. If it ever falls a whole buffer behind, entries are dropped and counted rather than
+ * making the game thread wait.
+ */
+class MULTIPLAYERSESSIONS_API FMultiplayerSessionJournal
+{
+public:
+
+	FMultiplayerSessionJournal();
+	~FMultiplayerSessionJournal();
+
+	// Start a journal file at Path. Capacity is rounded up to a power of two.
+	bool Start(const FString& Path, int32 Capacity, float FlushInterval);
+
+	// Write out what's still buffered and close the file
+	void Stop();
+
+	bool IsRunning() const { return Thread != nullptr; }
+	const FString& GetPath() const { return Path; }
+
+	// Game thread only
+	void Record(EMultiplayerSessionJournalEvent Event, EMultiplayerSessionMetricOp Op, FName SessionName,
+		EMultiplayerSessionOpOutcome Outcome = EMultiplayerSessionOpOutcome::Success, int32 Value = 0, double LatencyMs = 0.0);
+
+	// Entries recorded meanwhile are left out, e.g. while a replay drives the subsystem
+	void SetSuspended(bool bInSuspended) { bSuspended = bInSuspended; }
+
+	uint64 GetNumDropped() const { return NumDropped.load(std::memory_order_relaxed); }
+
+	static bool Load(const FString& Path, TArray<FMultiplayerSessionJournalEntry>& OutEntries);
+
+private:
+
+	class FWriter;
+
+	FString Path;
+	double StartTime{0.0};
+	bool bSuspended{false};
+
+	// Single producer (game thread), single consumer (writer thread). Entries [Tail, Head) are waiting to be written.
+	TArray<FMultiplayerSessionJournalEntry> Ring;
+	uint64 RingMask{0};
+	std::atomic<uint64> Head{0};
+	std::atomic<uint64> Tail{0};
+	std::atomic<uint64> NumDropped{0};
+
+	TUniquePtr<FWriter> Writer;
+	FRunnableThread* Thread{nullptr};
+};
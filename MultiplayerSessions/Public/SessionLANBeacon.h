@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FInternetAddr;
+class FOnlineSessionSearchResult;
+class FSocket;
+struct FMultiplayerSessionSearchFilter;
+
+// What a host announces about its session, and what listeners keep of it
+struct FMultiplayerSessionLANHost
+{
+	FGuid HostId;
+
+	// ip:port to travel to. Hosts only announce their port, the address is the one the beacon came from.
+	FString ConnectAddress;
+	uint16 Port{0};
+
+	uint32 MatchKey{0};
+	uint32 RegionKey{0};
+	bool bHasRegion{false};
+	int32 BuildUniqueId{0};
+	int32 NumPublicConnections{0};
+	int32 NumOpenPublicConnections{0};
+	bool bIsDedicated{false};
+	bool bQuickMatch{false};
+	FString MapName;
+
+	// FPlatformTime::Seconds() of the last beacon heard from this host
+	double LastHeardTime{0.0};
+};
+
+struct FMultiplayerSessionLANBeaconConfig
+{
+	// Multicast group and port beacons are sent to. Every process listening on them sees every host, several
+	// processes on one machine included.
+	FString GroupAddress{TEXT("239.255.77.77")};
+	int32 Port{14777};
+
+	// Interface beacons go out on, empty for the default one. 127.0.0.1 keeps them on the machine (e.g. a test farm box).
+	FString MulticastInterface;
+
+	// Seconds between beacons of a host, and without one before listeners forget it
+	float AnnounceInterval{0.5f};
+	float HostTimeout{2.f};
+};
+
+/**
+ * LAN discovery that doesn't wait for a broadcast query to time out.
+ *
+ * Hosts multicast a small beacon about their session every few hundred milliseconds, listeners keep a live table of
+ * every host they've heard from, deduplicated by host id. A search is answered from that table right away. Hosts
+ * that stop their session say so, hosts that crash are dropped once they've been quiet for the host timeout.
+ *
+ * Results made from the table carry their own session info, the online subsystem never sees them. See
+ * UMultiplayerSessionsSubsystem's LAN BEACON section for how joining them works.
+ */
+class MULTIPLAYERSESSIONS_API FMultiplayerSessionLANBeacon
+{
+public:
+
+	~FMultiplayerSessionLANBeacon();
+
+	// Open the socket and join the multicast group. False if that failed, the beacon stays stopped then.
+	bool Start(const FMultiplayerSessionLANBeaconConfig& InConfig);
+	void Stop();
+	bool IsRunning() const { return Socket != nullptr; }
+
+	// Whether the beacon has listened for a whole host timeout, every live host has been heard from by then
+	bool HasHeardEveryHost(double Now) const { return IsRunning() && Now - StartTime >= Config.HostTimeout; }
+
+	// Take in every beacon that has arrived and forget hosts that went quiet
+	void Tick(double Now);
+
+	// Whether the announcement (or the check if there's anything to announce) is due
+	bool IsAnnounceDue(double Now) const { return Now >= NextAnnounceTime; }
+	void RequestAnnounce() { NextAnnounceTime = 0.0; }
+
+	// Send a beacon about our session now and again once the interval has passed
+	void Announce(const FMultiplayerSessionLANHost& Host, double Now);
+
+	// Stop announcing. Listeners are told so they don't have to wait for the host timeout.
+	void Withdraw(double Now);
+
+	TArrayView<const FMultiplayerSessionLANHost> GetHosts() const { return Hosts; }
+	const FMultiplayerSessionLANHost* FindHost(const FGuid& HostId) const;
+
+	// Search results for every known host that passes Filter, like an online query with Filter applied would return
+	void MakeSearchResults(const FMultiplayerSessionSearchFilter& Filter, int32 MaxSearchResults, TArray<FOnlineSessionSearchResult>& OutResults) const;
+
+	// Whether a search result was made by MakeSearchResults(), and where to travel to for it
+	static bool IsBeaconResult(const FOnlineSessionSearchResult& Result);
+	static bool GetConnectString(const FOnlineSessionSearchResult& Result, FString& OutConnectString);
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+
+	void SendBeacon(const FMultiplayerSessionLANHost& Host, bool bWithdrawn);
+	void ReceiveBeacon(const uint8* Data, int32 Size, const FInternetAddr& Sender, double Now);
+	void RemoveHost(int32 HostIndex);
+
+	FMultiplayerSessionLANBeaconConfig Config;
+	FSocket* Socket{nullptr};
+	TSharedPtr<FInternetAddr> GroupAddr;
+	TSharedPtr<FInternetAddr> SenderAddr;
+
+	// Identifies this process' announcements, our own beacons come back to us over multicast loopback
+	FGuid OwnHostId;
+	double StartTime{0.0};
+	TOptional<FMultiplayerSessionLANHost> Announcement;
+	double NextAnnounceTime{0.0};
+
+	// Densely packed, a withdrawn or timed out host is replaced by the last one
+	TArray<FMultiplayerSessionLANHost> Hosts;
+	TMap<FGuid, int32> HostIndices;
+
+	TArray<uint8> SendBuffer;
+	TArray<uint8> ReceiveBuffer;
+};
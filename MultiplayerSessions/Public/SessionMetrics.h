@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FOnlineSessionSearch;
+
+// Every call the subsystem makes to the online session service
+enum class EMultiplayerSessionMetricOp : uint8
+{
+	Create,
+	Find,
+	Join,
+	Destroy,
+	Start,
+	Update,
+	Num
+};
+
+enum class EMultiplayerSessionOpOutcome : uint8
+{
+	Success,
+	// The online service refused the call or reported a failure
+	Failure,
+	// Superseded or cancelled before it completed
+	Cancelled,
+	// Never sent, it made no sense in the state the session was in
+	Rejected,
+	// Join failures the online service tells apart
+	SessionIsFull,
+	SessionDoesNotExist,
+	CouldNotRetrieveAddress,
+	AlreadyInSession,
+	Num
+};
+
+/**
+ * Fixed-size latency histogram with geometrically growing buckets, 0.1ms up to about two minutes at ~25% resolution.
+ * Recording a sample is a logarithm and an increment, cheap enough to stay on in shipping builds.
+ */
+struct MULTIPLAYERSESSIONS_API FMultiplayerLatencyHistogram
+{
+	static constexpr int32 NumBuckets = 64;
+
+	void Add(double LatencyInMs);
+
+	// Upper bound of the bucket the percentile falls into, 0 if there are no samples. Percentile is 0..1.
+	double GetPercentile(double Percentile) const;
+
+	uint32 Num() const { return NumSamples; }
+	double GetMean() const { return NumSamples > 0 ? TotalInMs / NumSamples : 0.0; }
+	double GetMax() const { return MaxInMs; }
+
+	static double GetBucketUpperBound(int32 Bucket);
+
+private:
+
+	uint32 Buckets[NumBuckets]{};
+	uint32 NumSamples{0};
+	double TotalInMs{0.0};
+	double MaxInMs{0.0};
+};
+
+struct MULTIPLAYERSESSIONS_API FMultiplayerSessionOpMetrics
+{
+	// Time from the call reaching the online service until it completed, for calls that reached it
+	FMultiplayerLatencyHistogram Latency;
+
+	uint32 Outcomes[static_cast<int32>(EMultiplayerSessionOpOutcome::Num)]{};
+
+	uint32 GetCount(EMultiplayerSessionOpOutcome Outcome) const { return Outcomes[static_cast<int32>(Outcome)]; }
+
+	// Everything but Success
+	uint32 GetNumFailed() const;
+};
+
+/**
+ * Counters and latency distributions of every session operation, plus what the search path keeps in memory.
+ * Recorded by UMultiplayerSessionsSubsystem and mirrored to trace counters so they show up in Unreal Insights.
+ */
+struct MULTIPLAYERSESSIONS_API FMultiplayerSessionMetrics
+{
+	FMultiplayerSessionOpMetrics Ops[static_cast<int32>(EMultiplayerSessionMetricOp::Num)];
+
+	// Searches answered from the search cache, they never reach the online service and aren't part of Ops[Find]
+	uint32 NumSearchCacheHits{0};
+
+	// Joins that failed over to the next ranked candidate, and failed joins that ran out of candidates to fail over to
+	uint32 NumJoinFailovers{0};
+	uint32 NumJoinFailoversExhausted{0};
+
+	// Result set sizes of the searches that completed
+	int32 LastSearchResultCount{0};
+	int32 MaxSearchResultCount{0};
+	uint64 TotalSearchResultCount{0};
+
+	// Filled in when the metrics are queried: search results, index and cache held right now
+	SIZE_T SearchBytesRetained{0};
+
+	const FMultiplayerSessionOpMetrics& Get(EMultiplayerSessionMetricOp Op) const { return Ops[static_cast<int32>(Op)]; }
+
+	void RecordOutcome(EMultiplayerSessionMetricOp Op, EMultiplayerSessionOpOutcome Outcome);
+	void RecordCompletion(EMultiplayerSessionMetricOp Op, EMultiplayerSessionOpOutcome Outcome, double StartTime, double EndTime);
+	void RecordSearchResults(int32 NumResults);
+	void RecordSearchCacheHit();
+	void RecordJoinFailover(bool bExhausted);
+
+	// p50/p95/p99 and the counters of every operation, one line each
+	void Dump(FOutputDevice& Ar) const;
+
+	// Memory held by a search's results, settings included
+	static SIZE_T GetSearchAllocatedSize(const FOnlineSessionSearch& Search);
+};
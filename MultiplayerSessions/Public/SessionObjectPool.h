@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FOnlineSessionSearch;
+class FOnlineSessionSettings;
+
+/**
+ * Recycles the search and settings objects handed to the online service. An object goes back into use once nobody
+ * but the pool references it anymore (the online service, the search cache and the session queue all hold shared
+ * references while they need it). Recycled objects keep the capacity of their arrays and maps, so a steady stream of
+ * searches and creates stops allocating them once the pool has warmed up.
+ */
+class MULTIPLAYERSESSIONS_API FMultiplayerSessionObjectPool
+{
+public:
+
+	explicit FMultiplayerSessionObjectPool(int32 InMaxPooled = 4) : MaxPooled(InMaxPooled) {}
+
+	// A search in its default state, with no results and no query settings
+	TSharedRef<FOnlineSessionSearch> AcquireSearch();
+
+	// Settings in their default state, with no settings or member settings
+	TSharedRef<FOnlineSessionSettings> AcquireSettings();
+
+	// The pooled objects and the memory they hold on to, whether they are in use right now or not
+	SIZE_T GetAllocatedSize() const;
+
+private:
+
+	// Objects past MaxPooled aren't pooled, they are freed as usual when their last reference goes
+	int32 MaxPooled{4};
+
+	TArray<TSharedRef<FOnlineSessionSearch>> Searches;
+	TArray<TSharedRef<FOnlineSessionSettings>> Settings;
+};
@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "SessionOperationQueue.generated.h"
+
+class FOnlineSessionSearchResult;
+class FOnlineSessionSettings;
+
+UENUM(BlueprintType)
+enum class EMultiplayerSessionState : uint8
+{
+	// No session under this name
+	None,
+	Creating,
+	Joining,
+	// Created or joined, not started yet
+	Pending,
+	Starting,
+	InProgress,
+	Destroying
+};
+
+enum class EMultiplayerSessionOpType : uint8
+{
+	Create,
+	Join,
+	Start,
+	Destroy
+};
+
+struct FMultiplayerSessionOp
+{
+	EMultiplayerSessionOpType Type{EMultiplayerSessionOpType::Create};
+
+	// Create only
+	TSharedPtr<FOnlineSessionSettings> Settings;
+
+	// Join only
+	TSharedPtr<const FOnlineSessionSearchResult> JoinTarget;
+
+	// Order in which ops were requested, tells completions of this op apart from late completions of an earlier one.
+	// 0 until the subsystem queues it
+	uint32 Serial{0};
+
+	// FPlatformTime::Seconds() of when the online service accepted the op, 0 if it never did
+	double SentTime{0.0};
+};
+
+enum class EMultiplayerSessionEnqueueResult : uint8
+{
+	// Will be sent to the online service once everything before it has finished
+	Queued,
+	// The same request is already queued or in flight, its completion answers this one too
+	Coalesced,
+	// Makes no sense in the state the session will be in (e.g. starting a session that won't exist)
+	Rejected
+};
+
+/**
+ * Lifecycle of one named session: what state it is in, the operation the online service is working on and the
+ * operations waiting behind it. Requests are coalesced on the way in so the online service never sees redundant or
+ * racing calls, e.g. a create on top of an existing session is queued behind a destroy instead of being sent next to it.
+ */
+struct MULTIPLAYERSESSIONS_API FMultiplayerSessionSlot
+{
+	FName SessionName;
+	EMultiplayerSessionState State{EMultiplayerSessionState::None};
+
+	// State to fall back to if the op in flight fails
+	EMultiplayerSessionState StateBeforeOp{EMultiplayerSessionState::None};
+
+	// Settings the session was created with
+	TSharedPtr<FOnlineSessionSettings> Settings;
+
+	TOptional<FMultiplayerSessionOp> InFlight;
+	TArray<FMultiplayerSessionOp> PendingOps;
+
+	// Settings have changed since the online service last saw them. Updates run next to the ops above, one at a time.
+	bool bSettingsDirty{false};
+	bool bUpdateInFlight{false};
+	double UpdateSentTime{0.0};
+
+	// Host heartbeats in a row that found us not serving the session
+	uint8 NumHeartbeatsNotServing{0};
+
+	// Joined through the LAN beacon, the online subsystem doesn't know about the session and its ops complete locally
+	bool bLANBeaconSession{false};
+
+	// Ops that never got to run because Op supersedes them are moved to OutCancelled
+	EMultiplayerSessionEnqueueResult Enqueue(FMultiplayerSessionOp&& Op, TArray<FMultiplayerSessionOp>& OutCancelled);
+
+	// Drop everything that hasn't been sent yet. The op in flight can't be taken back.
+	void CancelPending(TArray<FMultiplayerSessionOp>& OutCancelled);
+
+	// Whether the session exists once everything in flight and queued has run (assuming it all succeeds)
+	bool WillExist() const;
+
+	bool IsIdle() const { return !InFlight.IsSet() && PendingOps.Num() == 0; }
+
+private:
+
+	bool HasPending(EMultiplayerSessionOpType Type) const;
+	bool IsInFlight(EMultiplayerSessionOpType Type) const { return InFlight.IsSet() && InFlight->Type == Type; }
+	void CancelPendingOfType(EMultiplayerSessionOpType Type, TArray<FMultiplayerSessionOp>& OutCancelled);
+};
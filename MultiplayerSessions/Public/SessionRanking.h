@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "SessionRanking.generated.h"
+
+class FOnlineSessionSearchResult;
+
+/*
+ * How much each property of a session contributes to its score. Every term is normalised to [0, 1] before weighting.
+ */
+USTRUCT(BlueprintType)
+struct MULTIPLAYERSESSIONS_API FMultiplayerSessionRankingWeights
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network")
+	float Latency{1.f};
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network")
+	float OpenSlots{0.5f};
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network")
+	float HostQuality{0.25f};
+
+	// Pings at or above this are as bad as it gets
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network")
+	int32 MaxAcceptablePingInMs{250};
+
+	// Sessions with fewer open public connections than this are never picked
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network")
+	int32 RequiredOpenSlots{1};
+};
+
+/*
+ * Everything the ranking looks at, decoded once from a search result
+ */
+struct MULTIPLAYERSESSIONS_API FMultiplayerSessionCandidate
+{
+	// Index into the search results the candidate was made from
+	int32 ResultIndex{INDEX_NONE};
+
+	int32 PingInMs{MAX_int32};
+	int32 OpenSlots{0};
+	int32 MaxSlots{0};
+
+	// 0..1, dedicated hosts rank above listen servers
+	float HostQuality{0.f};
+
+	float Score{0.f};
+
+	static FMultiplayerSessionCandidate FromSearchResult(const FOnlineSessionSearchResult& Result, int32 ResultIndex);
+};
+
+/*
+ * Pure scoring functions. They don't touch the online subsystem so they can be run over synthetic candidates.
+ */
+namespace MultiplayerSessionRanking
+{
+	// Higher is better, negative if the candidate must not be joined at all
+	MULTIPLAYERSESSIONS_API float ScoreCandidate(const FMultiplayerSessionCandidate& Candidate, const FMultiplayerSessionRankingWeights& Weights);
+
+	// Score every candidate, drop the rejected ones and sort the rest best first
+	MULTIPLAYERSESSIONS_API void RankCandidates(TArray<FMultiplayerSessionCandidate>& Candidates, const FMultiplayerSessionRankingWeights& Weights);
+
+	// Decode the results at ResultIndices into candidates and rank them like RankCandidates(), keeping only the best
+	// MaxCandidates. Results whose session id is in ExcludedSessionIds are skipped. Large sets are scored in parallel
+	// chunks on the task graph. Safe to call from any thread as long as nobody modifies Results meanwhile.
+	MULTIPLAYERSESSIONS_API void SelectTopCandidates(TArrayView<const FOnlineSessionSearchResult> Results, TArrayView<const int32> ResultIndices,
+		const TSet<FString>& ExcludedSessionIds, const FMultiplayerSessionRankingWeights& Weights, int32 MaxCandidates,
+		TArray<FMultiplayerSessionCandidate>& OutCandidates);
+}
@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SessionSearchIndex.h"
+
+class FOnlineSessionSearch;
+
+/**
+ * Keeps the completed searches of the last few distinct queries so a repeated query can be answered without an
+ * online round-trip. Entries are looked up by filter and result limit and expire after a fixed time to live.
+ */
+class MULTIPLAYERSESSIONS_API FMultiplayerSessionSearchCache
+{
+public:
+
+	struct FEntry
+	{
+		FMultiplayerSessionSearchFilter Filter;
+		int32 MaxSearchResults{0};
+		TSharedPtr<FOnlineSessionSearch> Search;
+
+		// FPlatformTime::Seconds() of when the results were stored and when they were last handed out
+		double StoredTime{0.0};
+		double LastUsedTime{0.0};
+	};
+
+	void Configure(int32 InMaxEntries, double InTimeToLive);
+
+	// Fresh results for this query or nullptr. A hit counts as a use of the entry.
+	TSharedPtr<FOnlineSessionSearch> Find(const FMultiplayerSessionSearchFilter& Filter, int32 MaxSearchResults, double Now);
+
+	// Replaces the entry of the same query, otherwise evicts the least recently used one when full
+	void Store(const FMultiplayerSessionSearchFilter& Filter, int32 MaxSearchResults, const TSharedRef<FOnlineSessionSearch>& Search, double Now);
+
+	void RemoveStale(double Now);
+	void Invalidate() { Entries.Reset(); }
+
+	// The most recently used entry that is older than RefreshAge and has been used within its time to live.
+	// Entries nobody asks for anymore aren't worth an online query and are left to expire.
+	const FEntry* FindEntryToRefresh(double Now, double RefreshAge) const;
+
+	int32 Num() const { return Entries.Num(); }
+
+	bool Contains(const TSharedPtr<FOnlineSessionSearch>& Search) const;
+
+	// The cache itself and every search it holds
+	SIZE_T GetAllocatedSize() const;
+
+private:
+
+	FEntry* FindEntry(const FMultiplayerSessionSearchFilter& Filter, int32 MaxSearchResults);
+
+	// A handful of entries, a linear scan beats hashing the filter strings
+	TArray<FEntry> Entries;
+
+	int32 MaxEntries{4};
+	double TimeToLive{30.0};
+};
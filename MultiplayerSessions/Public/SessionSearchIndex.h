@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "SessionSearchIndex.generated.h"
+
+class FOnlineSessionSearch;
+class FOnlineSessionSearchResult;
+
+/*
+ * Criteria pushed into FOnlineSessionSearch::QuerySettings so the online service filters sessions for us.
+ * Empty strings / zero values mean "don't care".
+ */
+USTRUCT(BlueprintType)
+struct MULTIPLAYERSESSIONS_API FMultiplayerSessionSearchFilter
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network")
+	FString MatchType;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network")
+	int32 MinOpenSlots{1};
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network")
+	int32 BuildUniqueId{0};
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network")
+	FString Region;
+
+	// Look for dedicated servers instead of sessions hosted by players
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network")
+	bool bDedicatedServers{false};
+
+	// Only the session carrying on this lineage after its host migrated, 0 for any
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network")
+	int32 Lineage{0};
+
+	// Write the filter into the query settings of a search that's about to be sent
+	void ApplyTo(FOnlineSessionSearch& Search) const;
+};
+
+/**
+ * Compact, structure-of-arrays index over session search results.
+ *
+ * Every result is decoded exactly once when it's appended, afterwards looking up the sessions of a match type
+ * is a single hash map probe followed by walking an intrusive list of rows. Rows only store the index of the
+ * result in the source array, so nothing is copied out of FOnlineSessionSearch::SearchResults.
+ */
+class MULTIPLAYERSESSIONS_API FMultiplayerSessionSearchIndex
+{
+public:
+
+	// Case-insensitive, to match the FString comparison the menu used to do. Hosts advertise this instead of the
+	// match type itself, so results are indexed without hashing anything.
+	static uint32 MakeMatchKey(const FString& MatchType);
+
+	// Hosts advertising a heartbeat older than OldestHeartbeat (UTC unix time) are taken for dead, 0 keeps them all
+	void Reset(const FMultiplayerSessionSearchFilter& InFilter, uint32 InOldestHeartbeat = 0);
+
+	// Index Results, which start at FirstResultIndex in the source results array. Results the online service
+	// should have filtered out but didn't (e.g. LAN queries ignore QuerySettings) are skipped here.
+	// Large batches are decoded in parallel chunks on the task graph, rows are still linked in arrival order.
+	void Append(TArrayView<const FOnlineSessionSearchResult> Results, int32 FirstResultIndex);
+
+	// Index into the source results array of the first session with this match key, INDEX_NONE if there's none
+	int32 FindFirst(uint32 MatchKey) const;
+
+	// Visit the source result indices of every session with this match key, in arrival order
+	template<typename FunctorType>
+	void ForEach(uint32 MatchKey, FunctorType&& Functor) const
+	{
+		for (int32 Row = FindFirstRow(MatchKey); Row != INDEX_NONE; Row = NextRows[Row])
+		{
+			Functor(ResultIndices[Row]);
+		}
+	}
+
+	int32 Num() const { return ResultIndices.Num(); }
+
+	int32 GetResultIndex(int32 Row) const { return ResultIndices[Row]; }
+	uint32 GetMatchKey(int32 Row) const { return MatchKeys[Row]; }
+	int32 GetOpenSlots(int32 Row) const { return OpenSlots[Row]; }
+	int32 GetPingInMs(int32 Row) const { return PingsInMs[Row]; }
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+
+	int32 FindFirstRow(uint32 MatchKey) const;
+
+	// Whether Result passes the filter and, if so, its match key. Only reads the filter, any thread may call it.
+	bool Decode(const FOnlineSessionSearchResult& Result, uint32& OutMatchKey) const;
+
+	void AddRow(const FOnlineSessionSearchResult& Result, int32 ResultIndex, uint32 MatchKey);
+
+	FMultiplayerSessionSearchFilter Filter;
+	uint32 RegionKey{0};
+	uint32 OldestHeartbeat{0};
+
+	// One entry per indexed row
+	TArray<uint32> MatchKeys;
+	TArray<int32> ResultIndices;
+	TArray<int32> OpenSlots;
+	TArray<int32> PingsInMs;
+	TArray<int32> NextRows;
+
+	// Head and tail row of every match key's list
+	TMap<uint32, TPair<int32, int32>> RowsByMatchKey;
+};
@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SessionOperationQueue.h"
+
+/*
+ * Refers to one session of a FMultiplayerSessionTable. Stays cheap to resolve for as long as the session lives and
+ * resolves to nothing once it's gone, even if another session has taken its place in the table since.
+ */
+struct FMultiplayerSessionHandle
+{
+	int32 Index{INDEX_NONE};
+	uint32 Generation{0};
+
+	bool IsValid() const { return Index != INDEX_NONE; }
+
+	bool operator==(const FMultiplayerSessionHandle& Other) const { return Index == Other.Index && Generation == Other.Generation; }
+	bool operator!=(const FMultiplayerSessionHandle& Other) const { return !(*this == Other); }
+};
+
+/**
+ * Every session a process manages, keyed by name or handle.
+ *
+ * Slots are kept densely packed so walking all sessions touches contiguous memory. A handle goes through one
+ * indirection to its slot and a name through one hash probe, adding and removing a session are O(1) as well
+ * (removal moves the last slot into the hole). Pointers to slots don't survive adding or removing a session,
+ * look them up again after anything that may have done either.
+ */
+class MULTIPLAYERSESSIONS_API FMultiplayerSessionTable
+{
+public:
+
+	FMultiplayerSessionSlot* Find(FName SessionName);
+	const FMultiplayerSessionSlot* Find(FName SessionName) const;
+	FMultiplayerSessionSlot* Find(FMultiplayerSessionHandle Handle);
+	const FMultiplayerSessionSlot* Find(FMultiplayerSessionHandle Handle) const;
+
+	FMultiplayerSessionSlot& FindOrAdd(FName SessionName);
+
+	// Invalid handle if there's no session under this name
+	FMultiplayerSessionHandle GetHandle(FName SessionName) const;
+
+	bool Remove(FName SessionName);
+	void Reset();
+
+	int32 Num() const { return Slots.Num(); }
+
+	// Every session, in no particular order
+	TArrayView<FMultiplayerSessionSlot> GetSlots() { return Slots; }
+	TArrayView<const FMultiplayerSessionSlot> GetSlots() const { return Slots; }
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+
+	struct FHandleEntry
+	{
+		int32 SlotIndex{INDEX_NONE};
+		uint32 Generation{0};
+	};
+
+	int32 FindSlotIndex(FName SessionName) const;
+
+	TArray<FMultiplayerSessionSlot> Slots;
+
+	// Handle index of every slot, parallel to Slots
+	TArray<int32> SlotHandles;
+
+	TArray<FHandleEntry> Handles;
+	TArray<int32> FreeHandles;
+	TMap<FName, int32> HandlesByName;
+};